@@ -0,0 +1,528 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "AAKNavData.h"
+#include "AAKplayer.h"
+#include "AAKUtils.h"
+#include "AAKProbeCache.h"
+#include "console/engineAPI.h"
+#include "core/stream/fileStream.h"
+#include "core/volume.h"
+#include "math/mathIO.h"
+#include "scene/sceneContainer.h"
+#include "T3D/tsStatic.h"
+
+//"AKNV"
+static const U32 sNavDataTag = 0x564e4b41;
+
+//thresholds used when baking, looser than the probes so that shapes
+//tilted or scaled within the limits in transform() still match
+static const F32 sBakeVerticalZ = 0.4f;	//|normal.z| below this is a climb/wall patch
+static const F32 sBakeUpwardZ = 0.8f;	//normal.z above this is a ledge top
+static const F32 sBakeEdgeDot = 0.3f;	//ledge edges need normals differing by at least this
+
+Vector<AAKNavData::CachedFile> AAKNavData::smFiles;
+HashTable<SimObjectId, AAKNavData::Placed*> AAKNavData::smPlaced;
+U32 AAKNavData::smPurgeSize = 64;
+
+//object space normal -> world space normal
+static Point3F transformNormal(const MatrixF& mat, const Point3F& scale, const Point3F& normal)
+{
+   Point3F n(normal.x / scale.x, normal.y / scale.y, normal.z / scale.z);
+   mat.mulV(n);
+   n.normalizeSafe();
+   return n;
+}
+
+//object space point -> world space point
+static Point3F transformPoint(const MatrixF& mat, const Point3F& scale, const Point3F& point)
+{
+   Point3F p(point);
+   p.convolve(scale);
+   mat.mulP(p);
+   return p;
+}
+
+//-------------------------------------------------------------------
+// AAKNavData::bake
+//
+// Collects the object's collision polygons, moves them back into object
+// space and keeps the polygons and edges the player probes would use
+//-------------------------------------------------------------------
+bool AAKNavData::bake(TSStatic* obj)
+{
+   mPatches.clear();
+   mLedges.clear();
+
+   ConcretePolyList polyList;
+   obj->buildPolyList(PLC_Collision, &polyList, obj->getWorldBox(), SphereF());
+   if (polyList.isEmpty())
+      return false;
+
+   const MatrixF& worldToObj = obj->getWorldTransform();
+   const Point3F& scale = obj->getScale();
+
+   for (U32 i = 0; i < polyList.mVertexList.size(); i++)
+   {
+      worldToObj.mulP(polyList.mVertexList[i]);
+      polyList.mVertexList[i].convolveInverse(scale);
+   }
+
+   for (U32 p = 0; p < polyList.mPolyList.size(); p++)
+   {
+      ConcretePolyList::Poly& poly = polyList.mPolyList[p];
+      const Point3F& vertex0 = polyList.mVertexList[polyList.mIndexList[poly.vertexStart]];
+
+      //object space normal (inverse of transformNormal)
+      Point3F normal = poly.plane;
+      worldToObj.mulV(normal);
+      normal.convolve(scale);
+      normal.normalizeSafe();
+      poly.plane.set(vertex0, normal);
+   }
+
+   for (U32 p = 0; p < polyList.mPolyList.size(); p++)
+   {
+      const ConcretePolyList::Poly& poly = polyList.mPolyList[p];
+      const U32 vertexEnd = poly.vertexStart + poly.vertexCount;
+
+      if (mFabs(poly.plane.z) < sBakeVerticalZ)
+      {
+         Patch patch;
+         patch.plane = poly.plane;
+         patch.bounds = Box3F::Invalid;
+
+         Point3F areaNorm(0, 0, 0);
+         for (U32 i = poly.vertexStart; i < vertexEnd; i++)
+         {
+            const Point3F& vertex1 = polyList.mVertexList[polyList.mIndexList[i]];
+            const Point3F& vertex2 = polyList.mVertexList[polyList.mIndexList[i + 1 < vertexEnd ? i + 1 : poly.vertexStart]];
+
+            Point3F tmp;
+            mCross(vertex1, vertex2, &tmp);
+            areaNorm += tmp;
+            patch.bounds.extend(vertex1);
+         }
+         patch.area = mFabs(mDot(poly.plane, areaNorm)) * 0.5f;
+
+         if (patch.area > 0.0f)
+            mPatches.push_back(patch);
+      }
+      else if (poly.plane.z > sBakeUpwardZ)
+      {
+         for (U32 i = poly.vertexStart; i < vertexEnd; i++)
+         {
+            const Point3F& vertex1 = polyList.mVertexList[polyList.mIndexList[i]];
+            const Point3F& vertex2 = polyList.mVertexList[polyList.mIndexList[i + 1 < vertexEnd ? i + 1 : poly.vertexStart]];
+
+            U32 adjPolyIndex;
+            if (!AAKPlayer::findAdjacentPoly(&polyList, vertex1, vertex2, p, &adjPolyIndex))
+               continue;
+
+            const PlaneF& adjPlane = polyList.mPolyList[adjPolyIndex].plane;
+            if (mDot(poly.plane, adjPlane) > sBakeEdgeDot)
+               continue;
+
+            Ledge ledge;
+            ledge.start = vertex1;
+            ledge.end = vertex2;
+            ledge.polyNormal = poly.plane;
+            ledge.adjNormal = adjPlane;
+            mLedges.push_back(ledge);
+         }
+      }
+   }
+
+   return true;
+}
+
+//-------------------------------------------------------------------
+// AAKNavData::write / read
+//-------------------------------------------------------------------
+bool AAKNavData::write(Stream& stream) const
+{
+   AAKUtils::writeSnapshotHeader(stream, sNavDataTag, FileVersion);
+
+   stream.write(mPatches.size());
+   for (U32 i = 0; i < mPatches.size(); i++)
+   {
+      mathWrite(stream, mPatches[i].plane);
+      mathWrite(stream, mPatches[i].bounds);
+      stream.write(mPatches[i].area);
+   }
+
+   stream.write(mLedges.size());
+   for (U32 i = 0; i < mLedges.size(); i++)
+   {
+      mathWrite(stream, mLedges[i].start);
+      mathWrite(stream, mLedges[i].end);
+      mathWrite(stream, mLedges[i].polyNormal);
+      mathWrite(stream, mLedges[i].adjNormal);
+   }
+
+   return stream.getStatus() == Stream::Ok;
+}
+
+//bytes one patch / ledge takes in the file, used to reject counts the
+//rest of the stream can't possibly hold
+static const U32 sPatchRecordSize = sizeof(F32) * 4 + sizeof(F32) * 6 + sizeof(F32);
+static const U32 sLedgeRecordSize = sizeof(F32) * 3 * 4;
+
+static bool readRecordCount(Stream& stream, U32 recordSize, U32* count)
+{
+   if (!stream.read(count))
+      return false;
+
+   U32 remaining = stream.getStreamSize() - stream.getPosition();
+   if (*count > remaining / recordSize)
+   {
+      Con::errorf("AAKNavData::read - record count %u doesn't fit in the file", *count);
+      return false;
+   }
+
+   return true;
+}
+
+bool AAKNavData::read(Stream& stream)
+{
+   mPatches.clear();
+   mLedges.clear();
+
+   U16 version;
+   if (!AAKUtils::readSnapshotHeader(stream, sNavDataTag, FileVersion, &version, "AAKNavData"))
+      return false;
+
+   U32 count = 0;
+   if (!readRecordCount(stream, sPatchRecordSize, &count))
+      return false;
+
+   mPatches.setSize(count);
+   for (U32 i = 0; i < count; i++)
+   {
+      if (!mathRead(stream, &mPatches[i].plane)
+         || !mathRead(stream, &mPatches[i].bounds)
+         || !stream.read(&mPatches[i].area))
+      {
+         mPatches.clear();
+         return false;
+      }
+   }
+
+   if (!readRecordCount(stream, sLedgeRecordSize, &count))
+   {
+      mPatches.clear();
+      return false;
+   }
+
+   mLedges.setSize(count);
+   for (U32 i = 0; i < count; i++)
+   {
+      if (!mathRead(stream, &mLedges[i].start)
+         || !mathRead(stream, &mLedges[i].end)
+         || !mathRead(stream, &mLedges[i].polyNormal)
+         || !mathRead(stream, &mLedges[i].adjNormal))
+      {
+         mPatches.clear();
+         mLedges.clear();
+         return false;
+      }
+   }
+
+   return true;
+}
+
+//-------------------------------------------------------------------
+// AAKNavData::transform
+//
+// The bake thresholds only hold if the shape stays roughly upright and
+// evenly scaled, anything else is left to the polygon probes
+//-------------------------------------------------------------------
+bool AAKNavData::transform(const AAKNavData& src, const MatrixF& mat, const Point3F& scale)
+{
+   mPatches.clear();
+   mLedges.clear();
+
+   Point3F up;
+   mat.getColumn(2, &up);
+   F32 minScale = getMin(scale.x, getMin(scale.y, scale.z));
+   F32 maxScale = getMax(scale.x, getMax(scale.y, scale.z));
+   if (up.z < 0.95f || minScale <= 0.0f || maxScale > minScale * 1.5f)
+      return false;
+
+   mPatches.setSize(src.mPatches.size());
+   for (U32 i = 0; i < mPatches.size(); i++)
+   {
+      const Patch& in = src.mPatches[i];
+      Patch& out = mPatches[i];
+
+      Point3F normal = transformNormal(mat, scale, in.plane);
+      Point3F point = transformPoint(mat, scale, in.plane * -in.plane.d);
+      out.plane.set(point, normal);
+
+      out.bounds.minExtents = in.bounds.minExtents;
+      out.bounds.maxExtents = in.bounds.maxExtents;
+      out.bounds.minExtents.convolve(scale);
+      out.bounds.maxExtents.convolve(scale);
+      mat.mul(out.bounds);
+
+      //area scales with the scale across the plane
+      Point3F areaScale(in.plane.x / scale.x, in.plane.y / scale.y, in.plane.z / scale.z);
+      out.area = in.area * scale.x * scale.y * scale.z * areaScale.len();
+   }
+
+   mLedges.setSize(src.mLedges.size());
+   for (U32 i = 0; i < mLedges.size(); i++)
+   {
+      const Ledge& in = src.mLedges[i];
+      Ledge& out = mLedges[i];
+
+      out.start = transformPoint(mat, scale, in.start);
+      out.end = transformPoint(mat, scale, in.end);
+      out.polyNormal = transformNormal(mat, scale, in.polyNormal);
+      out.adjNormal = transformNormal(mat, scale, in.adjNormal);
+   }
+
+   return true;
+}
+
+String AAKNavData::getSidecarPath(const char* shapeFile)
+{
+   return String(shapeFile) + ".aaknav";
+}
+
+//-------------------------------------------------------------------
+// AAKNavData::find
+//
+// Each sidecar is read once, missing ones are remembered too so shapes
+// without one don't hit the disk every tick
+//-------------------------------------------------------------------
+AAKNavData* AAKNavData::find(const char* shapeFile)
+{
+   if (!shapeFile || !shapeFile[0])
+      return NULL;
+
+   for (U32 i = 0; i < smFiles.size(); i++)
+   {
+      if (smFiles[i].shapeFile.equal(shapeFile, String::NoCase))
+         return smFiles[i].data;
+   }
+
+   CachedFile file;
+   file.shapeFile = shapeFile;
+   file.data = NULL;
+
+   String path = getSidecarPath(shapeFile);
+   if (Platform::isFile(path))
+   {
+      if (Torque::FS::CompareModifiedTimes(shapeFile, path) > 0)
+      {
+         Con::warnf("AAKNavData::find - %s is older than its shape and was ignored, run bakeAAKNavData()", path.c_str());
+      }
+      else
+      {
+         FileStream stream;
+         if (stream.open(path, Torque::FS::File::Read))
+         {
+            file.data = new AAKNavData;
+            if (!file.data->read(stream))
+            {
+               Con::errorf("AAKNavData::find - unable to read %s", path.c_str());
+               SAFE_DELETE(file.data);
+            }
+         }
+      }
+   }
+
+   smFiles.push_back(file);
+   return file.data;
+}
+
+//-------------------------------------------------------------------
+// AAKNavData::getPlaced
+//
+// World space data is built lazily the first time a probe touches the
+// object and rebuilt only if it has moved since
+//-------------------------------------------------------------------
+const AAKNavData* AAKNavData::getPlaced(TSStatic* obj)
+{
+   Placed* placed = NULL;
+
+   HashTable<SimObjectId, Placed*>::Iterator itr = smPlaced.find(obj->getId());
+   if (itr != smPlaced.end())
+   {
+      placed = itr->value;
+   }
+   else
+   {
+      if (smPlaced.size() >= smPurgeSize)
+      {
+         purgePlaced();
+         smPurgeSize = getMax((U32)64, (U32)smPlaced.size() * 2);
+      }
+
+      placed = new Placed;
+      placed->data = new AAKNavData;
+      smPlaced.insertUnique(obj->getId(), placed);
+   }
+
+   //new entry, or the id now belongs to a different object
+   if (placed->object != obj)
+   {
+      placed->object = obj;
+      placed->source = find(obj->getShapeFileName());
+      placed->valid = false;
+      placed->scale.set(0, 0, 0);
+   }
+
+   if (!placed->source)
+      return NULL;
+
+   const MatrixF& mat = obj->getTransform();
+   const Point3F& scale = obj->getScale();
+   if (placed->scale != scale || dMemcmp(&placed->transform, &mat, sizeof(MatrixF)) != 0)
+   {
+      //speculative probes may be reading the old data
+      AAKPlayer::waitForSpeculativeProbes();
+
+      placed->transform = mat;
+      placed->scale = scale;
+      placed->valid = placed->data->transform(*placed->source, mat, scale);
+   }
+
+   return placed->valid ? placed->data : NULL;
+}
+
+void AAKNavData::purgePlaced()
+{
+   AAKPlayer::waitForSpeculativeProbes();
+
+   Vector<SimObjectId> dead;
+   for (HashTable<SimObjectId, Placed*>::Iterator itr = smPlaced.begin(); itr != smPlaced.end(); ++itr)
+   {
+      if (itr->value->object.isNull())
+         dead.push_back(itr->key);
+   }
+
+   for (U32 i = 0; i < dead.size(); i++)
+   {
+      HashTable<SimObjectId, Placed*>::Iterator itr = smPlaced.find(dead[i]);
+      delete itr->value->data;
+      delete itr->value;
+      smPlaced.erase(itr);
+   }
+}
+
+void AAKNavData::flush()
+{
+   //cached probe results were built from this data
+   AAKProbeCache::flush();
+   AAKPlayer::waitForSpeculativeProbes();
+
+   for (HashTable<SimObjectId, Placed*>::Iterator itr = smPlaced.begin(); itr != smPlaced.end(); ++itr)
+   {
+      delete itr->value->data;
+      delete itr->value;
+   }
+   smPlaced.clear();
+
+   for (U32 i = 0; i < smFiles.size(); i++)
+      delete smFiles[i].data;
+   smFiles.clear();
+}
+
+static void findAAKObjectsCallback(SceneObject* obj, void* key)
+{
+   Vector<TSStatic*>* list = (Vector<TSStatic*>*)key;
+
+   TSStatic* st = dynamic_cast<TSStatic*>(obj);
+   if (st && (st->allowPlayerClimb() || st->allowPlayerWallHug() || st->allowPlayerLedgeGrab()))
+      list->push_back(st);
+}
+
+void AAKNavData::findObjects(Vector<TSStatic*>* objects)
+{
+   gServerContainer.findObjects(StaticShapeObjectType, findAAKObjectsCallback, objects);
+}
+
+//-------------------------------------------------------------------
+// AAKNavData::bakeAll
+//
+// Bakes each shape once, from the first object found using it. Shapes
+// with an up to date sidecar are skipped unless force is set.
+//-------------------------------------------------------------------
+U32 AAKNavData::bakeAll(bool force)
+{
+   Vector<TSStatic*> objects;
+   findObjects(&objects);
+
+   Vector<String> baked;
+   U32 written = 0;
+
+   for (U32 i = 0; i < objects.size(); i++)
+   {
+      const char* shapeFile = objects[i]->getShapeFileName();
+      if (!shapeFile || !shapeFile[0] || baked.contains(String(shapeFile)))
+         continue;
+      baked.push_back(String(shapeFile));
+
+      String path = getSidecarPath(shapeFile);
+      if (!force && Platform::isFile(path) && Torque::FS::CompareModifiedTimes(shapeFile, path) <= 0)
+         continue;
+
+      AAKNavData data;
+      if (!data.bake(objects[i]))
+         continue;
+
+      FileStream stream;
+      if (!stream.open(path, Torque::FS::File::Write) || !data.write(stream))
+      {
+         Con::errorf("AAKNavData::bakeAll - unable to write %s", path.c_str());
+         continue;
+      }
+
+      Con::printf("AAKNavData::bakeAll - %s: %d patches, %d ledges", path.c_str(), data.mPatches.size(), data.mLedges.size());
+      written++;
+   }
+
+   //pick up the new files
+   flush();
+
+   return written;
+}
+
+DefineEngineFunction( bakeAAKNavData, S32, (bool force), (false),
+   "@brief Bakes climb, wall hug and ledge data for every shape used by a TSStatic "
+   "with AAK traversal enabled in the current mission.\n\n"
+   "Each shape gets a <shape>.aaknav file next to it which AAKPlayer uses instead "
+   "of building collision polygons at runtime. Must be run on the server.\n\n"
+   "@param force Rebake shapes whose files are already up to date.\n"
+   "@return The number of files written.\n")
+{
+   return AAKNavData::bakeAll(force);
+}
+
+DefineEngineFunction( flushAAKNavData, void, (), ,
+   "@brief Drops all loaded AAK nav data, it's reloaded from disk as needed.\n")
+{
+   AAKNavData::flush();
+}
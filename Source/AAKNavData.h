@@ -0,0 +1,142 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _AAKNAVDATA_H_
+#define _AAKNAVDATA_H_
+
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+
+#ifndef _TDICTIONARY_H_
+#include "core/util/tDictionary.h"
+#endif
+
+#ifndef _MPLANE_H_
+#include "math/mPlane.h"
+#endif
+
+#ifndef _MBOX_H_
+#include "math/mBox.h"
+#endif
+
+#ifndef _MMATRIX_H_
+#include "math/mMatrix.h"
+#endif
+
+#ifndef _SIMOBJECTREF_H_
+#include "console/simObjectRef.h"
+#endif
+
+class Stream;
+class TSStatic;
+
+//----------------------------------------------------------------------------
+// AAKNavData
+//
+// Precomputed climb, wall hug and ledge data for a shape. bake() walks the
+// collision polygons of a placed TSStatic once and keeps only what the
+// AAKPlayer probes look for: nearly vertical polygons (plane, bounds and
+// area) and the edges between upward-facing polygons and their
+// significantly different neighbours. Everything is stored in object space
+// in a sidecar file next to the shape (<shape>.aaknav).
+//
+// At runtime getPlaced() returns a world space copy for a TSStatic, built
+// the first time it's needed and again only when the object moves, so the
+// probes test a handful of patches & edges instead of building polylists.
+// Objects tilted away from +Z or scaled very unevenly return NULL, the bake
+// thresholds don't hold for them and the probes use polygons instead.
+//----------------------------------------------------------------------------
+class AAKNavData
+{
+public:
+   enum { FileVersion = 1 };
+
+   struct Patch
+   {
+      PlaneF plane;
+      Box3F bounds;     // bounds of the polygon
+      F32 area;
+   };
+
+   struct Ledge
+   {
+      Point3F start;    // wound like a polygon edge, so that
+      Point3F end;      // mCross(up, end - start) faces out from the ledge
+      VectorF polyNormal;  // normal of the upward-facing polygon
+      VectorF adjNormal;   // normal of the polygon on the other side
+   };
+
+   Vector<Patch> mPatches;
+   Vector<Ledge> mLedges;
+
+   bool bake(TSStatic* obj);
+   bool write(Stream& stream) const;
+   bool read(Stream& stream);
+
+   /// Transforms object space data into world space. Returns false if the
+   /// transform isn't suitable, see above.
+   bool transform(const AAKNavData& src, const MatrixF& mat, const Point3F& scale);
+
+   static String getSidecarPath(const char* shapeFile);
+
+   /// Loaded sidecar for a shape, NULL if there isn't one (or it's older
+   /// than the shape). Results are cached, see flush().
+   static AAKNavData* find(const char* shapeFile);
+
+   /// World space data for a placed object, NULL if it has none
+   static const AAKNavData* getPlaced(TSStatic* obj);
+
+   /// Every server TSStatic with climb, wall hug or ledge grab enabled
+   static void findObjects(Vector<TSStatic*>* objects);
+
+   /// Bakes and saves every shape used by a TSStatic with climb, wall hug
+   /// or ledge grab enabled. Returns the number of files written.
+   static U32 bakeAll(bool force);
+
+   /// Drops all loaded and placed data
+   static void flush();
+
+private:
+   struct CachedFile
+   {
+      String shapeFile;
+      AAKNavData* data;    // NULL if there is no usable sidecar
+   };
+   static Vector<CachedFile> smFiles;
+
+   struct Placed
+   {
+      SimObjectPtr<TSStatic> object;
+      const AAKNavData* source;
+      MatrixF transform;   // object transform the world data was built for
+      Point3F scale;
+      bool valid;          // false if the transform isn't suitable
+      AAKNavData* data;
+   };
+   static HashTable<SimObjectId, Placed*> smPlaced;
+   static U32 smPurgeSize;
+
+   static void purgePlaced();
+};
+
+#endif
@@ -0,0 +1,329 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include "platform/platform.h"
+#include "AAKProbeCache.h"
+#include "scene/sceneObject.h"
+#include "console/engineAPI.h"
+
+extern bool gEditingMission;
+
+const F32 AAKProbeCache::PositionGrid = 0.05f;
+
+S32 AAKProbeCache::smMaxEntries = 2048;
+Vector<AAKProbeCache::Entry> AAKProbeCache::smEntries;
+HashTable<U32, S32> AAKProbeCache::smIndex;
+S32 AAKProbeCache::smHead = -1;
+S32 AAKProbeCache::smTail = -1;
+S32 AAKProbeCache::smFree = -1;
+U32 AAKProbeCache::smCount = 0;
+bool AAKProbeCache::smWasEditing = false;
+Mutex AAKProbeCache::smMutex;
+
+U32 AAKProbeCache::smHits[AAKProbeCache::NumProbeTypes];
+U32 AAKProbeCache::smMisses[AAKProbeCache::NumProbeTypes];
+U32 AAKProbeCache::smInvalidations = 0;
+U32 AAKProbeCache::smEvictions = 0;
+
+static const char* sProbeTypeNames[AAKProbeCache::NumProbeTypes] = { "climb", "wall", "ledge" };
+
+//FNV-1a
+static U32 hashBytes(const void* data, U32 size, U32 hash = 2166136261u)
+{
+   const U8* bytes = (const U8*)data;
+   for (U32 i = 0; i < size; i++)
+   {
+      hash ^= bytes[i];
+      hash *= 16777619u;
+   }
+   return hash;
+}
+
+static S32 quantize(F32 value)
+{
+   return (S32)mFloor(value / AAKProbeCache::PositionGrid + 0.5f);
+}
+
+void AAKProbeCache::Key::set(ProbeType probeType, bool isServer, const Box3F& probeBox, F32 sweep)
+{
+   for (U32 i = 0; i < 3; i++)
+   {
+      box[i] = quantize(probeBox.minExtents[i]);
+      box[i + 3] = quantize(probeBox.maxExtents[i]);
+   }
+   drop = quantize(sweep);
+   type = probeType;
+   server = isServer;
+}
+
+U32 AAKProbeCache::Key::getHash() const
+{
+   return hashBytes(this, sizeof(Key));
+}
+
+void AAKProbeCache::Sources::add(SceneObject* obj)
+{
+   for (U32 i = 0; i < count; i++)
+      if (objects[i] == obj)
+         return;
+
+   if (count == MaxSources)
+      overflow = true;
+   else
+      objects[count++] = obj;
+}
+
+//-------------------------------------------------------------------
+// AAKProbeCache::isEnabled
+//
+// Editing can change anything, so the cache is bypassed while the
+// editor is open and starts again empty when it closes
+//-------------------------------------------------------------------
+bool AAKProbeCache::isEnabled()
+{
+   if (gEditingMission != smWasEditing)
+   {
+      smWasEditing = gEditingMission;
+      flush();
+   }
+
+   return smMaxEntries > 0 && !gEditingMission;
+}
+
+void AAKProbeCache::snapProbe(Point3F* pos, Point3F* forward, Key* key)
+{
+   for (U32 i = 0; i < 3; i++)
+      (*pos)[i] = quantize((*pos)[i]) * PositionGrid;
+
+   F32 yaw = mAtan2(forward->x, forward->y);
+   F32 pitch = mAsin(mClampF(forward->z, -1.0f, 1.0f));
+
+   S32 yawBucket = (S32)mFloor(yaw / M_2PI_F * YawBuckets + 0.5f);
+   yawBucket = ((yawBucket % YawBuckets) + YawBuckets) % YawBuckets;
+   S32 pitchBucket = mClamp((S32)mFloor((pitch / M_PI_F + 0.5f) * (PitchBuckets - 1) + 0.5f), 0, PitchBuckets - 1);
+
+   key->yaw = yawBucket;
+   key->pitch = pitchBucket;
+
+   yaw = yawBucket * M_2PI_F / YawBuckets;
+   pitch = (F32(pitchBucket) / (PitchBuckets - 1) - 0.5f) * M_PI_F;
+   F32 cosPitch = mCos(pitch);
+   forward->set(mSin(yaw) * cosPitch, mCos(yaw) * cosPitch, mSin(pitch));
+}
+
+F32 AAKProbeCache::snapDistance(F32 dist)
+{
+   return mCeil(dist / PositionGrid) * PositionGrid;
+}
+
+U32 AAKProbeCache::getStamp(SceneObject* obj)
+{
+   U32 hash = hashBytes(&obj->getTransform(), sizeof(MatrixF));
+   return hashBytes(&obj->getScale(), sizeof(Point3F), hash);
+}
+
+bool AAKProbeCache::isValid(const Entry& entry)
+{
+   for (U32 i = 0; i < entry.sourceCount; i++)
+   {
+      SceneObject* obj;
+      if (!Sim::findObject(entry.sources[i].id, obj) || getStamp(obj) != entry.sources[i].stamp)
+         return false;
+   }
+   return true;
+}
+
+void AAKProbeCache::unlink(S32 index)
+{
+   Entry& entry = smEntries[index];
+
+   if (entry.prev >= 0)
+      smEntries[entry.prev].next = entry.next;
+   else
+      smHead = entry.next;
+
+   if (entry.next >= 0)
+      smEntries[entry.next].prev = entry.prev;
+   else
+      smTail = entry.prev;
+}
+
+void AAKProbeCache::linkHead(S32 index)
+{
+   Entry& entry = smEntries[index];
+   entry.prev = -1;
+   entry.next = smHead;
+
+   if (smHead >= 0)
+      smEntries[smHead].prev = index;
+   else
+      smTail = index;
+   smHead = index;
+}
+
+void AAKProbeCache::remove(S32 index)
+{
+   unlink(index);
+   smIndex.erase(smEntries[index].hash);
+
+   smEntries[index].next = smFree;
+   smFree = index;
+   smCount--;
+}
+
+//-------------------------------------------------------------------
+// AAKProbeCache::find
+//
+// Returns true and fills in result if there is a valid entry for key
+//-------------------------------------------------------------------
+bool AAKProbeCache::find(const Key& key, Result* result)
+{
+   MutexHandle handle;
+   handle.lock(&smMutex, true);
+
+   HashTable<U32, S32>::Iterator itr = smIndex.find(key.getHash());
+   if (itr == smIndex.end() || !(smEntries[itr->value].key == key))
+   {
+      smMisses[key.type]++;
+      return false;
+   }
+
+   S32 index = itr->value;
+   if (!isValid(smEntries[index]))
+   {
+      remove(index);
+      smInvalidations++;
+      smMisses[key.type]++;
+      return false;
+   }
+
+   unlink(index);
+   linkHead(index);
+
+   *result = smEntries[index].result;
+   smHits[key.type]++;
+   return true;
+}
+
+//-------------------------------------------------------------------
+// AAKProbeCache::insert
+//
+// Remembers a probe result. Results that depend on more objects than an
+// entry can check aren't kept.
+//-------------------------------------------------------------------
+void AAKProbeCache::insert(const Key& key, const Result& result, const Sources& sources)
+{
+   if (sources.overflow || smMaxEntries <= 0)
+      return;
+
+   MutexHandle handle;
+   handle.lock(&smMutex, true);
+
+   U32 hash = key.getHash();
+
+   //replace whatever has the same hash
+   HashTable<U32, S32>::Iterator itr = smIndex.find(hash);
+   if (itr != smIndex.end())
+      remove(itr->value);
+
+   while (smCount >= (U32)smMaxEntries && smTail >= 0)
+   {
+      remove(smTail);
+      smEvictions++;
+   }
+
+   S32 index;
+   if (smFree >= 0)
+   {
+      index = smFree;
+      smFree = smEntries[index].next;
+   }
+   else
+   {
+      index = smEntries.size();
+      smEntries.increment();
+   }
+
+   Entry& entry = smEntries[index];
+   entry.key = key;
+   entry.hash = hash;
+   entry.result = result;
+   entry.sourceCount = sources.count;
+   for (U32 i = 0; i < sources.count; i++)
+   {
+      entry.sources[i].id = sources.objects[i]->getId();
+      entry.sources[i].stamp = getStamp(sources.objects[i]);
+   }
+
+   linkHead(index);
+   smIndex.insertUnique(hash, index);
+   smCount++;
+}
+
+void AAKProbeCache::flush()
+{
+   MutexHandle handle;
+   handle.lock(&smMutex, true);
+
+   smEntries.clear();
+   smIndex.clear();
+   smHead = smTail = smFree = -1;
+   smCount = 0;
+}
+
+void AAKProbeCache::resetStats()
+{
+   MutexHandle handle;
+   handle.lock(&smMutex, true);
+
+   dMemset(smHits, 0, sizeof(smHits));
+   dMemset(smMisses, 0, sizeof(smMisses));
+   smInvalidations = 0;
+   smEvictions = 0;
+}
+
+void AAKProbeCache::getStats(char* buffer, U32 size)
+{
+   MutexHandle handle;
+   handle.lock(&smMutex, true);
+
+   //storage is kept after evictions, so count what's allocated
+   U32 bytes = smEntries.capacity() * sizeof(Entry) + smIndex.size() * (sizeof(U32) + sizeof(S32) + sizeof(void*));
+
+   U32 len = dSprintf(buffer, size, "probe cache entries %d/%d, %d KB, evictions %d, invalidations %d",
+      smCount, getMax(smMaxEntries, 0), bytes / 1024, smEvictions, smInvalidations);
+
+   for (U32 i = 0; i < NumProbeTypes && len < size; i++)
+   {
+      U32 lookups = smHits[i] + smMisses[i];
+      F32 hitRate = lookups ? F32(smHits[i]) / lookups : 0.0f;
+      len += dSprintf(buffer + len, size - len, "\n%s probes cached %d of %d, hit rate %.1f%%",
+         sProbeTypeNames[i], smHits[i], lookups, hitRate * 100.0f);
+   }
+}
+
+DefineEngineFunction( flushAAKProbeCache, void, (), ,
+   "@brief Drops every cached AAKPlayer probe result. Needed only if static "
+   "objects are added near players outside the editor, moved or deleted "
+   "objects are noticed on their own.\n")
+{
+   AAKProbeCache::flush();
+}
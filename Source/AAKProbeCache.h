@@ -0,0 +1,187 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef _AAKPROBECACHE_H_
+#define _AAKPROBECACHE_H_
+
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+
+#ifndef _TDICTIONARY_H_
+#include "core/util/tDictionary.h"
+#endif
+
+#ifndef _MPLANE_H_
+#include "math/mPlane.h"
+#endif
+
+#ifndef _MBOX_H_
+#include "math/mBox.h"
+#endif
+
+#ifndef _PLATFORM_THREADS_MUTEX_H_
+#include "platform/threads/mutex.h"
+#endif
+
+class SceneObject;
+
+//----------------------------------------------------------------------------
+// AAKProbeCache
+//
+// World space cache of climb, wall hug and ledge probe results, shared by
+// every AAKPlayer on the same side (server or client). Players patrolling
+// the same routes or waiting at the same wall ask the same questions of the
+// same static geometry, so the answers are kept by probe type, quantized
+// probe box and facing bucket.
+//
+// For the results to be shareable the probe has to be a function of its
+// key, so while the cache is enabled the probes snap their position to
+// PositionGrid and their facing to YawBuckets x PitchBuckets (see
+// snapProbe) before building the probe box. Climb and wall planes and the
+// ledge plane & height don't move with the box, so the snapping doesn't
+// show.
+//
+// Each entry remembers the static objects that overlapped the probe box
+// and a stamp of their transforms. A hit whose objects have been deleted,
+// moved or rescaled is dropped and probed again. The cache is bypassed
+// while the mission editor is open and flushed when it closes, and is
+// flushed with the nav data (see AAKNavData::flush).
+//
+// The number of entries is capped by $AAKPlayer::probeCacheSize, least
+// recently used entries are evicted first.
+//----------------------------------------------------------------------------
+class AAKProbeCache
+{
+public:
+   enum ProbeType
+   {
+      ClimbProbe,
+      WallProbe,
+      LedgeProbe,
+      NumProbeTypes
+   };
+
+   enum { MaxSources = 8 };         // static objects an entry can depend on
+   enum { YawBuckets = 128 };       // facing buckets around +Z
+   enum { PitchBuckets = 64 };      // facing buckets from -Z to +Z
+   static const F32 PositionGrid;   // probe position & box quantization
+
+   struct Key
+   {
+      S32 box[6];       // quantized probe box
+      S32 drop;         // quantized sweep distance (ledge only)
+      U16 yaw;
+      U16 pitch;
+      U8 type;
+      U8 server;
+      U16 pad;
+
+      Key() { dMemset(this, 0, sizeof(Key)); }
+      void set(ProbeType probeType, bool isServer, const Box3F& probeBox, F32 sweep = 0.0f);
+      bool operator==(const Key& other) const { return dMemcmp(this, &other, sizeof(Key)) == 0; }
+      U32 getHash() const;
+   };
+
+   struct Result
+   {
+      bool found;
+      bool canMoveLeft;    // ledge only
+      bool canMoveRight;
+      PlaneF plane;        // climb & wall
+      VectorF normal;      // ledge
+      Point3F point;
+
+      Result() : found(false), canMoveLeft(false), canMoveRight(false), plane(0, 0, 0, 0), normal(0, 0, 0), point(0, 0, 0) {}
+   };
+
+   /// Static objects a probe looked at, collected while it runs
+   struct Sources
+   {
+      SceneObject* objects[MaxSources];
+      U32 count;
+      bool overflow;
+
+      Sources() : count(0), overflow(false) {}
+      void add(SceneObject* obj);
+   };
+
+   /// True if the probes should use the cache, see above
+   static bool isEnabled();
+
+   /// Snaps a probe's position and facing, and sets the facing in key
+   static void snapProbe(Point3F* pos, Point3F* forward, Key* key);
+
+   /// Rounds a sweep distance up to PositionGrid
+   static F32 snapDistance(F32 dist);
+
+   static bool find(const Key& key, Result* result);
+   static void insert(const Key& key, const Result& result, const Sources& sources);
+   static void flush();
+
+   static void resetStats();
+   static void getStats(char* buffer, U32 size);
+
+   static S32 smMaxEntries;   // $AAKPlayer::probeCacheSize
+
+   /// Hash of an object's transform and scale, a result read from the
+   /// object is stale once this changes
+   static U32 getStamp(SceneObject* obj);
+
+private:
+   struct Source
+   {
+      SimObjectId id;
+      U32 stamp;        // hash of the object's transform and scale
+   };
+
+   struct Entry
+   {
+      Key key;
+      U32 hash;
+      Result result;
+      Source sources[MaxSources];
+      U32 sourceCount;
+      S32 prev;         // LRU list, most recent first
+      S32 next;
+   };
+
+   static Vector<Entry> smEntries;
+   static HashTable<U32, S32> smIndex;    // key hash to entry
+   static S32 smHead;                     // most recently used
+   static S32 smTail;                     // least recently used
+   static S32 smFree;                     // unused entries, linked through next
+   static U32 smCount;
+   static bool smWasEditing;
+   static Mutex smMutex;
+
+   static U32 smHits[NumProbeTypes];
+   static U32 smMisses[NumProbeTypes];
+   static U32 smInvalidations;            // hits dropped because an object changed
+   static U32 smEvictions;                // entries dropped for space
+
+   static bool isValid(const Entry& entry);
+   static void unlink(S32 index);
+   static void linkHead(S32 index);
+   static void remove(S32 index);
+};
+
+#endif
@@ -0,0 +1,233 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "AAKProbeScratch.h"
+#include "AAKProbeCache.h"
+#include "console/engineAPI.h"
+
+const F32 AAKProbeScratch::BoxQueryGrid = 0.01f;
+
+AAKProbeScratch::AAKProbeScratch()
+{
+   mBoxQueryCount = 0;
+   mBoxQueryNext = 0;
+   mBoxExactHits = 0;
+   mBoxContainHits = 0;
+   mBoxMisses = 0;
+   mLedgeProbes = 0;
+   mLedgeCandidates = 0;
+   mLedgeAdjacencySearches = 0;
+   dMemset(mSpeculation, 0, sizeof(mSpeculation));
+   mTicks = 0;
+   mTickDepth = 0;
+}
+
+AAKProbeScratch& AAKProbeScratch::get()
+{
+   static thread_local AAKProbeScratch sScratch;
+   return sScratch;
+}
+
+void AAKProbeScratch::endTick()
+{
+   AssertWarn(mConcrete.used == 0 && mClipped.used == 0 && mEarlyOut.used == 0,
+      "AAKProbeScratch::endTick - a polylist is still checked out");
+
+   mBoxQueryCount = 0;
+   mBoxQueryNext = 0;
+   mTicks++;
+}
+
+//snap a coordinate to the grid, never past the original value (float
+//error in the multiply can land one step the wrong way, so check it)
+static F32 quantizeDown(F32 value)
+{
+   F32 result = mFloor(value / AAKProbeScratch::BoxQueryGrid) * AAKProbeScratch::BoxQueryGrid;
+   return result > value ? result - AAKProbeScratch::BoxQueryGrid : result;
+}
+
+static F32 quantizeUp(F32 value)
+{
+   F32 result = mCeil(value / AAKProbeScratch::BoxQueryGrid) * AAKProbeScratch::BoxQueryGrid;
+   return result < value ? result + AAKProbeScratch::BoxQueryGrid : result;
+}
+
+//grid box that contains the original
+static Box3F quantizeBoxOut(const Box3F& box)
+{
+   Box3F result;
+   for (U32 i = 0; i < 3; i++)
+   {
+      result.minExtents[i] = quantizeDown(box.minExtents[i]);
+      result.maxExtents[i] = quantizeUp(box.maxExtents[i]);
+   }
+   return result;
+}
+
+//grid box inside the original (inverted if the original is thinner than a cell)
+static Box3F quantizeBoxIn(const Box3F& box)
+{
+   Box3F result;
+   for (U32 i = 0; i < 3; i++)
+   {
+      result.minExtents[i] = quantizeUp(box.minExtents[i]);
+      result.maxExtents[i] = quantizeDown(box.maxExtents[i]);
+   }
+   return result;
+}
+
+static bool boxContains(const Box3F& outer, const Box3F& inner)
+{
+   return outer.minExtents.x <= inner.minExtents.x && outer.minExtents.y <= inner.minExtents.y && outer.minExtents.z <= inner.minExtents.z
+      && outer.maxExtents.x >= inner.maxExtents.x && outer.maxExtents.y >= inner.maxExtents.y && outer.maxExtents.z >= inner.maxExtents.z;
+}
+
+bool AAKProbeScratch::findBoxQuery(const Box3F& box, U32 mask, bool* clear)
+{
+   if (mTickDepth == 0)
+      return false;
+
+   //a clear result is stored shrunk and a blocked one grown, so testing
+   //the query grown against clear boxes and shrunk against blocked ones
+   //only ever reuses a result that holds for the exact box
+   Box3F outBox = quantizeBoxOut(box);
+   Box3F inBox = quantizeBoxIn(box);
+
+   for (U32 i = 0; i < mBoxQueryCount; i++)
+   {
+      const BoxQuery& query = mBoxQueries[i];
+      if (query.mask != mask)
+         continue;
+
+      const Box3F& qBox = query.clear ? outBox : inBox;
+      if (query.box.minExtents == qBox.minExtents && query.box.maxExtents == qBox.maxExtents)
+      {
+         mBoxExactHits++;
+         *clear = query.clear;
+         return true;
+      }
+
+      //inside a clear box, or around a blocked one
+      if ((query.clear && boxContains(query.box, qBox)) || (!query.clear && boxContains(qBox, query.box)))
+      {
+         mBoxContainHits++;
+         *clear = query.clear;
+         return true;
+      }
+   }
+
+   mBoxMisses++;
+   return false;
+}
+
+void AAKProbeScratch::addBoxQuery(const Box3F& box, U32 mask, bool clear)
+{
+   if (mTickDepth == 0)
+      return;
+
+   BoxQuery* query;
+   if (mBoxQueryCount < MaxBoxQueries)
+      query = &mBoxQueries[mBoxQueryCount++];
+   else
+   {
+      query = &mBoxQueries[mBoxQueryNext];
+      mBoxQueryNext = (mBoxQueryNext + 1) % MaxBoxQueries;
+   }
+
+   query->box = clear ? quantizeBoxIn(box) : quantizeBoxOut(box);
+   query->mask = mask;
+   query->clear = clear;
+}
+
+void AAKProbeScratch::resetStats()
+{
+   mConcrete.highWater = mConcrete.maxVerts = mConcrete.overflows = 0;
+   mClipped.highWater = mClipped.maxVerts = mClipped.overflows = 0;
+   mEarlyOut.highWater = mEarlyOut.maxVerts = mEarlyOut.overflows = 0;
+   mBoxExactHits = mBoxContainHits = mBoxMisses = 0;
+   mLedgeProbes = mLedgeCandidates = mLedgeAdjacencySearches = 0;
+   dMemset(mSpeculation, 0, sizeof(mSpeculation));
+   mTicks = 0;
+}
+
+const char* AAKProbeScratch::getStats() const
+{
+   U32 boxQueries = mBoxExactHits + mBoxContainHits + mBoxMisses;
+   F32 boxHitRate = boxQueries ? F32(mBoxExactHits + mBoxContainHits) / boxQueries : 0.0f;
+
+   const Speculation& climb = mSpeculation[AAKProbeCache::ClimbProbe];
+   const Speculation& ledge = mSpeculation[AAKProbeCache::LedgeProbe];
+   U32 climbUsed = climb.hits + climb.misses + climb.late;
+   U32 ledgeUsed = ledge.hits + ledge.misses + ledge.late;
+   F32 climbHitRate = climbUsed ? F32(climb.hits) / climbUsed : 0.0f;
+   F32 ledgeHitRate = ledgeUsed ? F32(ledge.hits) / ledgeUsed : 0.0f;
+
+   char* ret = Con::getReturnBuffer(1024);
+   dSprintf(ret, 1024,
+      "ticks %d\n"
+      "concrete lists %d, verts %d, overflows %d\n"
+      "clipped lists %d, verts %d, overflows %d\n"
+      "earlyOut lists %d, verts %d, overflows %d\n"
+      "box queries %d, exact hits %d, containment hits %d, hit rate %.1f%%\n"
+      "ledge probes %d, candidate edges %d, adjacency searches %d\n"
+      "speculative climb probes %d, hits %d, misses %d, late %d, unused %d, skipped %d, hit rate %.1f%%\n"
+      "speculative ledge probes %d, hits %d, misses %d, late %d, unused %d, skipped %d, hit rate %.1f%%",
+      mTicks,
+      mConcrete.highWater, mConcrete.maxVerts, mConcrete.overflows,
+      mClipped.highWater, mClipped.maxVerts, mClipped.overflows,
+      mEarlyOut.highWater, mEarlyOut.maxVerts, mEarlyOut.overflows,
+      boxQueries, mBoxExactHits, mBoxContainHits, boxHitRate * 100.0f,
+      mLedgeProbes, mLedgeCandidates, mLedgeAdjacencySearches,
+      climb.issued, climb.hits, climb.misses, climb.late, climb.unused, climb.skipped, climbHitRate * 100.0f,
+      ledge.issued, ledge.hits, ledge.misses, ledge.late, ledge.unused, ledge.skipped, ledgeHitRate * 100.0f);
+   return ret;
+}
+
+DefineEngineFunction( getAAKStats, const char*, (), ,
+   "@brief Returns AAKPlayer probe statistics for this thread since the last "
+   "resetAAKStats(): for each kind of polylist, the most checked out at once, "
+   "the most verticies one held and how many checkouts had to allocate, then the "
+   "box-clear queries and how many were answered without the container, "
+   "the edges reached by ledge sweeps and how many needed an adjacency search, "
+   "and what became of the speculative climb and ledge probes. "
+   "Last the shared probe cache (see AAKProbeCache): its entries and memory, "
+   "and the hit rate for each kind of probe.\n")
+{
+   char scratchStats[1024];
+   dStrncpy(scratchStats, AAKProbeScratch::get().getStats(), sizeof(scratchStats));
+   scratchStats[sizeof(scratchStats) - 1] = 0;
+
+   char cacheStats[512];
+   AAKProbeCache::getStats(cacheStats, sizeof(cacheStats));
+
+   char* ret = Con::getReturnBuffer(1536);
+   dSprintf(ret, 1536, "%s\n%s", scratchStats, cacheStats);
+   return ret;
+}
+
+DefineEngineFunction( resetAAKStats, void, (), ,
+   "@brief Resets the statistics reported by getAAKStats().\n")
+{
+   AAKProbeScratch::get().resetStats();
+   AAKProbeCache::resetStats();
+}
@@ -0,0 +1,195 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _AAKPROBESCRATCH_H_
+#define _AAKPROBESCRATCH_H_
+
+#ifndef _CONCRETEPOLYLIST_H_
+#include "collision/concretePolyList.h"
+#endif
+
+#ifndef _CLIPPEDPOLYLIST_H_
+#include "collision/clippedPolyList.h"
+#endif
+
+#ifndef _EARLYOUTPOLYLIST_H_
+#include "collision/earlyOutPolyList.h"
+#endif
+
+#ifndef _AAKPROBECACHE_H_
+#include "AAKProbeCache.h"
+#endif
+
+//----------------------------------------------------------------------------
+// AAKProbeScratch
+//
+// Per thread scratch space for the AAKPlayer collision probes. Polylists
+// are checked out for one probe (see AAKScratchPolyList) and keep their
+// vertex, index and polygon storage afterwards, so once they have grown to
+// fit the level, steady state movement doesn't allocate. Nothing is shared
+// between threads and nothing is function static, so probes can run from
+// any thread.
+//
+// A tick is one AAKPlayer::processTick (see TickScope). At the end of each
+// tick every list must have been returned, and the high-water marks are
+// updated for getStats().
+//
+// The scratch also remembers the box-clear queries made during a tick
+// (see AAKPlayer::worldBoxIsClear). Boxes are quantized to BoxQueryGrid,
+// so nearly identical boxes share a result. A box inside one that was
+// clear is clear too, and a box around one that was blocked is blocked,
+// neither needs the container. Clear boxes are rounded inward and
+// blocked ones outward, so a reused result is never more optimistic
+// than the exact query would have been.
+//
+// The sim thread's scratch also counts what became of the speculative
+// probes it issued (see AAKSpeculativeProbe).
+//----------------------------------------------------------------------------
+class AAKProbeScratch
+{
+public:
+   enum { MaxDepth = 4 };  // lists of one type checked out at once before falling back to the heap
+   enum { MaxBoxQueries = 16 };     // box queries remembered per tick
+   static const F32 BoxQueryGrid;   // quantization of box query extents
+
+   template<class T> struct Pool
+   {
+      T lists[MaxDepth];
+      U32 used;            // lists currently checked out
+      U32 highWater;       // most lists checked out at once
+      U32 maxVerts;        // most verticies held by one list
+      U32 overflows;       // checkouts that had to allocate
+
+      Pool() : used(0), highWater(0), maxVerts(0), overflows(0) {}
+
+      T* alloc()
+      {
+         T* list = (used < MaxDepth) ? &lists[used] : new T;
+         if (used >= MaxDepth)
+            overflows++;
+         used++;
+         highWater = getMax(highWater, used);
+         list->clear();
+         return list;
+      }
+
+      void release(T* list)
+      {
+         maxVerts = getMax(maxVerts, (U32)list->mVertexList.size());
+         used--;
+         if (list < lists || list >= lists + MaxDepth)
+            delete list;
+      }
+   };
+
+   Pool<ConcretePolyList> mConcrete;
+   Pool<ClippedPolyList> mClipped;
+   Pool<EarlyOutPolyList> mEarlyOut;
+
+   struct BoxQuery
+   {
+      Box3F box;        // quantized
+      U32 mask;
+      bool clear;
+   };
+   BoxQuery mBoxQueries[MaxBoxQueries];
+   U32 mBoxQueryCount;
+   U32 mBoxQueryNext;   // next entry to overwrite once full
+
+   U32 mBoxExactHits;   // same quantized box
+   U32 mBoxContainHits; // answered by containment
+   U32 mBoxMisses;      // went to the container
+
+   U32 mLedgeProbes;             // ledge probes run
+   U32 mLedgeCandidates;         // edges the ledge sweeps reached
+   U32 mLedgeAdjacencySearches;  // of those, edges searched for a neighbouring polygon
+
+   struct Speculation
+   {
+      U32 issued;       // probes sent to a worker
+      U32 hits;         // results used the next tick
+      U32 misses;       // the probe input had changed
+      U32 late;         // the worker hadn't finished
+      U32 unused;       // no probe asked for the result
+      U32 skipped;      // not sent, an object needed its polygons
+   };
+   Speculation mSpeculation[AAKProbeCache::NumProbeTypes];
+
+   U32 mTicks;          // ticks since the stats were reset
+   U32 mTickDepth;      // nested TickScopes
+
+   AAKProbeScratch();
+
+   /// Looks for a box query this tick that answers box. Only used inside a
+   /// TickScope, outside one the world may have changed between queries.
+   bool findBoxQuery(const Box3F& box, U32 mask, bool* clear);
+   void addBoxQuery(const Box3F& box, U32 mask, bool clear);
+
+   /// This thread's scratch
+   static AAKProbeScratch& get();
+
+   template<class T> Pool<T>& getPool();
+
+   void endTick();
+   void resetStats();
+   const char* getStats() const;
+
+   /// Marks one tick, endTick() runs when the outermost scope closes
+   struct TickScope
+   {
+      TickScope() { get().mTickDepth++; }
+      ~TickScope()
+      {
+         AAKProbeScratch& scratch = get();
+         if (--scratch.mTickDepth == 0)
+            scratch.endTick();
+      }
+   };
+};
+
+template<> inline AAKProbeScratch::Pool<ConcretePolyList>& AAKProbeScratch::getPool() { return mConcrete; }
+template<> inline AAKProbeScratch::Pool<ClippedPolyList>& AAKProbeScratch::getPool() { return mClipped; }
+template<> inline AAKProbeScratch::Pool<EarlyOutPolyList>& AAKProbeScratch::getPool() { return mEarlyOut; }
+
+//----------------------------------------------------------------------------
+// AAKScratchPolyList
+//
+// Checks a cleared polylist out of this thread's scratch for the lifetime
+// of the object:
+//
+//    AAKScratchPolyList<ConcretePolyList> polyList;
+//    polyList->...
+//----------------------------------------------------------------------------
+template<class T> class AAKScratchPolyList
+{
+   T* mList;
+
+public:
+   AAKScratchPolyList() { mList = AAKProbeScratch::get().getPool<T>().alloc(); }
+   ~AAKScratchPolyList() { AAKProbeScratch::get().getPool<T>().release(mList); }
+
+   T* operator->() { return mList; }
+   T& operator*() { return *mList; }
+   T* ptr() { return mList; }
+};
+
+#endif
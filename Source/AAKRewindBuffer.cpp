@@ -0,0 +1,151 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "AAKRewindBuffer.h"
+
+AAKRewindBuffer::AAKRewindBuffer()
+{
+   mData = NULL;
+   mCapacity = 0;
+   mFirst = 0;
+   mCount = 0;
+}
+
+AAKRewindBuffer::~AAKRewindBuffer()
+{
+   dFree(mData);
+}
+
+void AAKRewindBuffer::setCapacity(U32 bytes)
+{
+   if (bytes == mCapacity)
+      return;
+
+   //storage is allocated by the first push, players that never record
+   //anything don't pay for the cap
+   dFree(mData);
+   mData = NULL;
+   mCapacity = bytes;
+   clear();
+}
+
+void AAKRewindBuffer::clear()
+{
+   mFirst = 0;
+   mCount = 0;
+}
+
+void AAKRewindBuffer::dropOldest()
+{
+   mFirst = (mFirst + 1) % MaxRecords;
+   mCount--;
+}
+
+//-------------------------------------------------------------------
+// AAKRewindBuffer::push
+//
+// Records are stored back to back, wrapping to the start of the
+// storage when the next one won't fit at the end
+//-------------------------------------------------------------------
+bool AAKRewindBuffer::push(const U8* data, U32 size, U32 time)
+{
+   if (size == 0 || size > mCapacity)
+      return false;
+
+   if (!mData)
+      mData = (U8*)dMalloc(mCapacity);
+
+   if (mCount == MaxRecords)
+      dropOldest();
+
+   U32 offset = 0;
+   if (mCount > 0)
+   {
+      const Record& newest = getRecord(mCount - 1);
+      offset = newest.offset + newest.size;
+   }
+
+   if (offset + size > mCapacity)
+   {
+      // Wrap, everything past the newest record is older than the
+      // records at the start of the storage and is lost
+      while (mCount > 0 && getRecord(0).offset >= offset)
+         dropOldest();
+
+      offset = 0;
+   }
+
+   // Drop the oldest records we're about to overwrite
+   while (mCount > 0)
+   {
+      const Record& oldest = getRecord(0);
+      if (oldest.offset >= offset + size || oldest.offset + oldest.size <= offset)
+         break;
+
+      dropOldest();
+   }
+
+   dMemcpy(mData + offset, data, size);
+
+   Record& record = mRecords[(mFirst + mCount) % MaxRecords];
+   record.offset = offset;
+   record.size = size;
+   record.time = time;
+   mCount++;
+
+   return true;
+}
+
+S32 AAKRewindBuffer::findRecord(U32 time) const
+{
+   if (mCount == 0 || getRecord(0).time > time)
+      return -1;
+
+   // Records are in time order
+   S32 lo = 0, hi = mCount - 1;
+   while (lo < hi)
+   {
+      S32 mid = (lo + hi + 1) / 2;
+      if (getRecord(mid).time <= time)
+         lo = mid;
+      else
+         hi = mid - 1;
+   }
+
+   return lo;
+}
+
+void AAKRewindBuffer::truncate(U32 index)
+{
+   if (index < mCount)
+      mCount = index + 1;
+}
+
+U32 AAKRewindBuffer::getBytesStored() const
+{
+   U32 bytes = 0;
+   for (U32 i = 0; i < mCount; i++)
+      bytes += getRecord(i).size;
+
+   return bytes;
+}
@@ -0,0 +1,91 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _AAKREWINDBUFFER_H_
+#define _AAKREWINDBUFFER_H_
+
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+
+//----------------------------------------------------------------------------
+// AAKRewindBuffer
+//
+// Fixed size ring of variable length state records (snapshots). The byte
+// storage is allocated once up to the memory cap, when the first record is
+// pushed, recording a new state overwrites the oldest ones that are in the
+// way. Records are found by the
+// time they were taken, so "rewind N ms" is a search over at most
+// MaxRecords entries and a snapshot read, no objects are created.
+//----------------------------------------------------------------------------
+class AAKRewindBuffer
+{
+public:
+   enum { MaxRecords = 256 };
+
+private:
+   struct Record
+   {
+      U32 offset;    // position in mData
+      U32 size;      // bytes
+      U32 time;      // sim time the record was taken (ms)
+   };
+
+   U8* mData;
+   U32 mCapacity;
+
+   Record mRecords[MaxRecords];
+   U32 mFirst;       // index of the oldest record in mRecords
+   U32 mCount;       // number of valid records
+
+   Record& getRecord(U32 i) { return mRecords[(mFirst + i) % MaxRecords]; }
+   const Record& getRecord(U32 i) const { return mRecords[(mFirst + i) % MaxRecords]; }
+   void dropOldest();
+
+public:
+   AAKRewindBuffer();
+   ~AAKRewindBuffer();
+
+   /// Sets the memory cap (bytes). Existing records are discarded if the
+   /// cap changes, 0 frees the storage.
+   void setCapacity(U32 bytes);
+   U32 getCapacity() const { return mCapacity; }
+
+   void clear();
+   bool push(const U8* data, U32 size, U32 time);
+
+   /// Newest record taken at or before time, -1 if there isn't one
+   S32 findRecord(U32 time) const;
+   const U8* getRecordData(U32 index) const { return mData + getRecord(index).offset; }
+   U32 getRecordSize(U32 index) const { return getRecord(index).size; }
+   U32 getRecordTime(U32 index) const { return getRecord(index).time; }
+   U32 getRecordCount() const { return mCount; }
+
+   /// Drops every record newer than index
+   void truncate(U32 index);
+
+   /// Bytes held by records / total memory used by the buffer
+   U32 getBytesStored() const;
+   U32 getBytesUsed() const { return (mData ? mCapacity : 0) + sizeof(*this); }
+};
+
+#endif
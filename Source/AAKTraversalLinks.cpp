@@ -0,0 +1,297 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "AAKTraversalLinks.h"
+#include "AAKNavData.h"
+#include "AAKplayer.h"
+#include "console/engineAPI.h"
+#include "scene/sceneContainer.h"
+#include "T3D/tsStatic.h"
+
+#ifdef TORQUE_NAVIGATION_ENABLED
+#include "navigation/navMesh.h"
+#endif
+
+Vector<AAKTraversalLinks::Link> AAKTraversalLinks::smLinks;
+
+static const char* sLinkTypeNames[AAKTraversalLinks::NumLinkTypes] =
+{
+   "climbUp",
+   "ledgeUp",
+   "shimmy",
+   "dropDown"
+};
+
+//gravity used for jump & fall estimates, the player default
+static const F32 sLinkGravity = 20.0f;
+
+//ground the links start or end on
+static const U32 sLinkGroundMask = TerrainObjectType | StaticShapeObjectType;
+
+const char* AAKTraversalLinks::getTypeName(LinkType type)
+{
+   return type < NumLinkTypes ? sLinkTypeNames[type] : "";
+}
+
+bool AAKTraversalLinks::getType(const char* name, LinkType* type)
+{
+   for (U32 i = 0; i < NumLinkTypes; i++)
+   {
+      if (dStricmp(name, sLinkTypeNames[i]) == 0)
+      {
+         *type = (LinkType)i;
+         return true;
+      }
+   }
+   return false;
+}
+
+void AAKTraversalLinks::addLink(LinkType type, const Point3F& start, const Point3F& end, F32 cost)
+{
+   Link link;
+   link.type = type;
+   link.start = start;
+   link.end = end;
+   link.cost = cost;
+   smLinks.push_back(link);
+}
+
+//-------------------------------------------------------------------
+// AAKTraversalLinks::build
+//-------------------------------------------------------------------
+U32 AAKTraversalLinks::build(AAKPlayerData* data, F32 maxDropHeight)
+{
+   smLinks.clear();
+
+   Vector<TSStatic*> objects;
+   AAKNavData::findObjects(&objects);
+
+   U32 unbaked = 0;
+   for (U32 i = 0; i < objects.size(); i++)
+   {
+      if (!objects[i]->allowPlayerLedgeGrab())
+         continue;
+
+      const AAKNavData* nav = AAKNavData::getPlaced(objects[i]);
+      if (!nav)
+      {
+         unbaked++;
+         continue;
+      }
+
+      addLedgeLinks(data, objects[i], nav, maxDropHeight);
+   }
+
+   if (unbaked > 0)
+      Con::warnf("AAKTraversalLinks::build - %d objects have no usable nav data, run bakeAAKNavData()", unbaked);
+
+   return smLinks.size();
+}
+
+//-------------------------------------------------------------------
+// AAKTraversalLinks::addLedgeLinks
+//
+// Links are placed at the middle of each ledge: on top, half a player
+// depth back from the edge, and on the ground half a player depth out
+//-------------------------------------------------------------------
+void AAKTraversalLinks::addLedgeLinks(AAKPlayerData* data, TSStatic* obj, const AAKNavData* nav, F32 maxDropHeight)
+{
+   //highest ledge (above the feet) that can be grabbed from a standing jump
+   F32 jumpSpeed = data->mass > 0.0f ? data->jumpForce / data->mass : 0.0f;
+   F32 jumpTime = jumpSpeed / sLinkGravity;
+   F32 reach = data->grabHeightMax + (jumpSpeed * jumpSpeed) / (2.0f * sLinkGravity);
+
+   //ledge up animation runs from 0 to 1 at grabSpeedUp per second
+   F32 ledgeUpTime = data->grabSpeedUp > 0.0f ? 1.0f / data->grabSpeedUp : 1.0f;
+
+   F32 offset = data->boxSize.y * 0.5f + 0.1f;
+
+   for (U32 i = 0; i < nav->mLedges.size(); i++)
+   {
+      const AAKNavData::Ledge& ledge = nav->mLedges[i];
+
+      //same tests the ledge probe makes, except facing the player
+      if (ledge.polyNormal.z <= 0.9f || mDot(ledge.polyNormal, ledge.adjNormal) > 0.1f)
+         continue;
+
+      //too short to hang from?
+      Point3F along = ledge.end - ledge.start;
+      F32 length = along.len();
+      if (length < data->boxSize.x)
+         continue;
+
+      Point3F normal = mCross(Point3F(0, 0, 1), along);
+      normal.normalizeSafe();
+
+      Point3F mid = (ledge.start + ledge.end) * 0.5f;
+      Point3F top = mid - normal * offset;
+      top.z += 0.1f;
+
+      //find the ground below the ledge
+      Point3F below = mid + normal * offset;
+      RayInfo rInfo;
+      if (!gServerContainer.castRay(below, below - Point3F(0, 0, maxDropHeight), sLinkGroundMask, &rInfo))
+         continue;
+
+      Point3F ground = rInfo.point;
+      F32 height = mid.z - ground.z;
+
+      //low enough to just walk up?
+      if (height < data->grabHeightMin)
+         continue;
+
+      if (height <= reach)
+      {
+         addLink(LedgeUpLink, ground, top, jumpTime + ledgeUpTime);
+      }
+      else if (obj->allowPlayerClimb() && mFabs(ledge.adjNormal.z) < 0.2f && data->climbSpeedUp > 0.0f)
+      {
+         //climb until the ledge is in reach, then pull up
+         addLink(ClimbUpLink, ground, top, (height - data->grabHeightMax) / data->climbSpeedUp + ledgeUpTime);
+      }
+
+      //drop from the top, landing stalls the player for landDuration
+      addLink(DropDownLink, top, ground, mSqrt(2.0f * height / sLinkGravity) + data->landDuration * 0.001f);
+
+      //shimmy from one end of the ledge to the other
+      if (data->grabSpeedSide > 0.0f)
+      {
+         Point3F inset = along * (data->boxSize.x * 0.5f / length);
+         Point3F start = ledge.start + inset - normal * offset;
+         Point3F end = ledge.end - inset - normal * offset;
+         addLink(ShimmyLink, start, end, (length - data->boxSize.x) / data->grabSpeedSide);
+      }
+   }
+}
+
+//-------------------------------------------------------------------
+// AAKTraversalLinks::findLink
+//-------------------------------------------------------------------
+S32 AAKTraversalLinks::findLink(const Point3F& pos, F32 radius, S32 type)
+{
+   S32 best = -1;
+   F32 radiusSq = radius * radius;
+
+   for (U32 i = 0; i < smLinks.size(); i++)
+   {
+      const Link& link = smLinks[i];
+      if (type >= 0 && link.type != type)
+         continue;
+
+      if ((link.start - pos).lenSquared() > radiusSq)
+         continue;
+
+      if (best < 0 || link.cost < smLinks[best].cost)
+         best = i;
+   }
+
+   return best;
+}
+
+DefineEngineFunction( buildAAKTraversalLinks, S32, (AAKPlayerData* datablock, F32 maxDropHeight, const char* navMesh), (10.0f, ""),
+   "@brief Builds AI traversal links (climb-up, ledge-up, shimmy and drop-down) from "
+   "baked AAK nav data, see bakeAAKNavData().\n\n"
+   "@param datablock Player datablock used for reach and cost estimates.\n"
+   "@param maxDropHeight Highest ledge considered for drop-down (and the furthest "
+   "the ground below a ledge is searched for).\n"
+   "@param navMesh Optional NavMesh the links are added to as off-mesh connections.\n"
+   "@return The number of links built.\n")
+{
+   if (!datablock)
+   {
+      Con::errorf("buildAAKTraversalLinks - invalid datablock");
+      return 0;
+   }
+
+   U32 count = AAKTraversalLinks::build(datablock, maxDropHeight);
+
+   if (navMesh && navMesh[0])
+   {
+#ifdef TORQUE_NAVIGATION_ENABLED
+      NavMesh* mesh;
+      if (!Sim::findObject(navMesh, mesh))
+      {
+         Con::errorf("buildAAKTraversalLinks - unable to find NavMesh %s", navMesh);
+         return count;
+      }
+
+      static const U32 sLinkFlags[AAKTraversalLinks::NumLinkTypes] =
+      {
+         ClimbFlag,
+         LedgeFlag,
+         LedgeFlag,
+         DropFlag
+      };
+
+      const Vector<AAKTraversalLinks::Link>& links = AAKTraversalLinks::getLinks();
+      for (U32 i = 0; i < links.size(); i++)
+         mesh->addLink(links[i].start, links[i].end, sLinkFlags[links[i].type]);
+#else
+      Con::errorf("buildAAKTraversalLinks - the navigation module isn't enabled");
+#endif
+   }
+
+   return count;
+}
+
+DefineEngineFunction( getAAKTraversalLinkCount, S32, (), ,
+   "@brief Returns the number of links built by buildAAKTraversalLinks().\n")
+{
+   return AAKTraversalLinks::getLinks().size();
+}
+
+DefineEngineFunction( getAAKTraversalLink, const char*, (S32 index), ,
+   "@brief Returns a traversal link as \"type TAB start TAB end TAB cost\", cost "
+   "is the estimated traversal time in seconds.\n")
+{
+   const Vector<AAKTraversalLinks::Link>& links = AAKTraversalLinks::getLinks();
+   if (index < 0 || index >= links.size())
+      return "";
+
+   const AAKTraversalLinks::Link& link = links[index];
+   char* ret = Con::getReturnBuffer(256);
+   dSprintf(ret, 256, "%s\t%g %g %g\t%g %g %g\t%g", AAKTraversalLinks::getTypeName(link.type),
+      link.start.x, link.start.y, link.start.z, link.end.x, link.end.y, link.end.z, link.cost);
+   return ret;
+}
+
+DefineEngineFunction( findAAKTraversalLink, S32, (Point3F pos, F32 radius, const char* type), (""),
+   "@brief Finds the lowest cost traversal link starting within radius of pos.\n\n"
+   "@param type Only consider links of this type (climbUp, ledgeUp, shimmy or "
+   "dropDown), any type if empty.\n"
+   "@return The link index, or -1 if there isn't one.\n")
+{
+   S32 linkType = -1;
+   if (type && type[0])
+   {
+      AAKTraversalLinks::LinkType t;
+      if (!AAKTraversalLinks::getType(type, &t))
+      {
+         Con::errorf("findAAKTraversalLink - unknown link type %s", type);
+         return -1;
+      }
+      linkType = t;
+   }
+
+   return AAKTraversalLinks::findLink(pos, radius, linkType);
+}
@@ -0,0 +1,92 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _AAKTRAVERSALLINKS_H_
+#define _AAKTRAVERSALLINKS_H_
+
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+
+#ifndef _MPOINT3_H_
+#include "math/mPoint3.h"
+#endif
+
+struct AAKPlayerData;
+class AAKNavData;
+class TSStatic;
+
+//----------------------------------------------------------------------------
+// AAKTraversalLinks
+//
+// Off-mesh links for AI, derived from baked AAK nav data (see AAKNavData)
+// instead of the runtime probes. Each ledge edge of a baked shape gives a
+// way up from the ground in front of it (a ledge-up if it can be reached
+// with a jump, a climb-up if the wall below is climbable), a drop-down
+// back to that ground and a shimmy along the ledge. Every link carries an
+// estimated traversal time (seconds) from the player datablock.
+//
+// The links are kept for script queries and, with the navigation module,
+// added to a NavMesh as off-mesh connections.
+//----------------------------------------------------------------------------
+class AAKTraversalLinks
+{
+public:
+   enum LinkType
+   {
+      ClimbUpLink,
+      LedgeUpLink,
+      ShimmyLink,
+      DropDownLink,
+      NumLinkTypes
+   };
+
+   struct Link
+   {
+      LinkType type;
+      Point3F start;
+      Point3F end;
+      F32 cost;      // estimated traversal time (seconds)
+   };
+
+   static const char* getTypeName(LinkType type);
+   static bool getType(const char* name, LinkType* type);
+
+   /// Rebuilds the links for every baked TSStatic in the mission, returns
+   /// the number of links
+   static U32 build(AAKPlayerData* data, F32 maxDropHeight);
+   static void clear() { smLinks.clear(); }
+
+   /// Lowest cost link of the given type (or any type) starting within
+   /// radius of pos, -1 if there isn't one
+   static S32 findLink(const Point3F& pos, F32 radius, S32 type = -1);
+
+   static const Vector<Link>& getLinks() { return smLinks; }
+
+private:
+   static Vector<Link> smLinks;
+
+   static void addLedgeLinks(AAKPlayerData* data, TSStatic* obj, const AAKNavData* nav, F32 maxDropHeight);
+   static void addLink(LinkType type, const Point3F& start, const Point3F& end, F32 cost);
+};
+
+#endif
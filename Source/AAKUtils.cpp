@@ -21,6 +21,9 @@
 //-----------------------------------------------------------------------------
 
 #include "AAKUtils.h"
+#include "core/stream/stream.h"
+#include "console/console.h"
+
 namespace AAKUtils
 {
    void getAnglesFromVector(const VectorF& vec, F32& yawAng, F32& pitchAng)
@@ -34,4 +37,70 @@ namespace AAKUtils
       F32 vert = vec.z / XYdist;
       pitchAng = mAtan2(vert, 1.0f);
    }
+
+   void writeSnapshotHeader(Stream& stream, U32 tag, U16 version)
+   {
+      stream.write(tag);
+      stream.write(version);
+   }
+
+   bool readSnapshotHeader(Stream& stream, U32 tag, U16 maxVersion, U16* version, const char* className)
+   {
+      U32 readTag = 0;
+      if (!stream.read(&readTag) || readTag != tag)
+      {
+         Con::errorf("%s::readSnapshot - not a %s snapshot", className, className);
+         return false;
+      }
+
+      if (!stream.read(version) || *version > maxVersion)
+      {
+         Con::errorf("%s::readSnapshot - unsupported snapshot version %d", className, *version);
+         return false;
+      }
+
+      return true;
+   }
+
+   const char* snapshotToString(const U8* data, U32 size)
+   {
+      static const char* sHexDigits = "0123456789abcdef";
+
+      char* ret = Con::getReturnBuffer(size * 2 + 1);
+      for (U32 i = 0; i < size; i++)
+      {
+         ret[i * 2] = sHexDigits[data[i] >> 4];
+         ret[i * 2 + 1] = sHexDigits[data[i] & 0xf];
+      }
+      ret[size * 2] = '\0';
+
+      return ret;
+   }
+
+   static inline S32 hexValue(char c)
+   {
+      if (c >= '0' && c <= '9') return c - '0';
+      if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+      if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+      return -1;
+   }
+
+   U32 snapshotFromString(const char* str, U8* buffer, U32 bufferSize)
+   {
+      U32 len = dStrlen(str);
+      if (len == 0 || (len & 1) || len / 2 > bufferSize)
+         return 0;
+
+      for (U32 i = 0; i < len / 2; i++)
+      {
+         S32 hi = hexValue(str[i * 2]);
+         S32 lo = hexValue(str[i * 2 + 1]);
+         if (hi < 0 || lo < 0)
+            return 0;
+
+         buffer[i] = (U8)((hi << 4) | lo);
+      }
+
+      return len / 2;
+   }
 }
@@ -23,6 +23,9 @@
 #ifndef _AAKUTILS_H_
 #define _AAKUTILS_H_
 #include "math/mathUtils.h"
+
+class Stream;
+
 namespace AAKUtils
 {   /// Returns yaw and pitch angles from a given vector.
    ///
@@ -34,5 +37,25 @@ namespace AAKUtils
    ///
    /// <b>ASSUMES Z AXIS IS UP</b>
    void getAnglesFromVector(const VectorF& vec, F32& yawAng, F32& pitchAng);
+
+   /// Snapshots are binary blobs of an object's full state, used for save
+   /// games (see AAKPlayer::writeSnapshot). Each one starts with a tag
+   /// identifying the class and a version number.
+   enum { MaxSnapshotSize = 8192 };
+
+   void writeSnapshotHeader(Stream& stream, U32 tag, U16 version);
+
+   /// Returns false (and reports an error) if the tag doesn't match or the
+   /// version is newer than maxVersion. The stored version is returned so
+   /// readers can handle older snapshots.
+   bool readSnapshotHeader(Stream& stream, U32 tag, U16 maxVersion, U16* version, const char* className);
+
+   /// Hex encodes a snapshot into a console return buffer so it can be
+   /// stored by script.
+   const char* snapshotToString(const U8* data, U32 size);
+
+   /// Decodes a string from snapshotToString, returns the number of bytes
+   /// written to buffer (0 if the string is invalid or too long).
+   U32 snapshotFromString(const char* str, U8* buffer, U32 bufferSize);
 }
 #endif
@@ -41,6 +41,7 @@
 #include "core/stringTable.h"
 #include "core/volume.h"
 #include "core/stream/bitStream.h"
+#include "core/stream/memStream.h"
 #include "console/consoleTypes.h"
 #include "console/engineAPI.h"
 #include "collision/extrudedPolyList.h"
@@ -70,7 +71,15 @@
 #include "materials/baseMatInstance.h"
 #include "terrain/terrData.h"
 #include "gfx/sim/debugDraw.h"
+#include "platform/threads/threadPool.h"
 #include "AAKUtils.h"
+#include "AAKNavData.h"
+#include "AAKProbeScratch.h"
+#include "AAKProbeCache.h"
+#include "cameraGoalPlayer.h"
+#include "cameraGoalFollower.h"
+#include "cameraGoalActivation.h"
+#include "climbZone.h"
 
 #ifdef TORQUE_EXTENDED_MOVE
    #include "T3D/gameBase/extended/extendedMove.h"
@@ -135,6 +144,30 @@ static S32 sMaxPredictionTicks = 30;   // Number of ticks to predict
 // Anchor point compression
 const F32 sAnchorMaxDistance = 32.0f;
 
+// Rewind buffer
+static S32 sRewindInterval = 4;            // Ticks between rewind snapshots
+static S32 sRewindMemoryCap = 64 * 1024;   // Bytes per player, 0 disables rewind
+
+// Animation LOD
+static S32 sAnimLODTicks = 4;              // Ticks between skeleton updates for unseen ghosts, 0 disables
+
+// Remote ghosts
+static bool sRemoteGhostProbes = false;    // Remote ghosts run the full movement probes instead of the net state
+
+// Speculative probes
+static bool sAsyncProbes = false;          // Run next tick's climb & ledge probes on a worker at the end of the tick
+
+// Surface-relative moves
+static const F32 sSurfaceCoordScale = 100.0f;   // Surface coordinates are sent in cm
+static const S32 sSurfaceCoordBits = 16;        // +/- 327m from the anchor
+static const F32 sSurfaceTolerance = 0.02f;     // Re-anchor if the coordinates miss the player by more than this
+
+// Moving platforms
+static const S32 sPlatformLostTicks = 2;        // Ticks without contact before we let go of a platform
+
+// Ledge up
+static const F32 sLedgeUpTolerance = 0.05f;     // Ghosts only snap to the server's climb up position if further out than this
+
 //
 static U32 sCollisionMoveMask =  TerrainObjectType       |
                                  WaterObjectType         | 
@@ -435,12 +468,13 @@ bool AAKPlayerData::preload(bool server, String& errorStr)
       AssertFatal(actionCount <= NumActionAnims, "Too many action animations!");
       delete si;
 
+      //Ubiq: resolve flags, speeds and names once
+      buildActionCache();
+
       // Resolve lookAction index
-      dp = &actionList[0];
-      String lookName("look");
-      for (S32 c = 0; c < actionCount; c++, dp++)
-         if (dStricmp(dp->name, lookName) == 0)
-            lookAction = c;
+      S32 look = findAction("look");
+      if (look != -1)
+         lookAction = look;
 
       // Resolve spine
       spineNode[0] = shape->findNode("Bip01 Pelvis");
@@ -535,33 +569,103 @@ bool AAKPlayerData::preload(bool server, String& errorStr)
    return true;
 }
 
-//Ubiq:
-bool AAKPlayerData::isLedgeAction(U32 action)
+//-------------------------------------------------------------------
+// AAKPlayerData::buildActionCache
+//
+// Packs the resolved actionList into mActionCache and hashes the
+// sequence names so nothing downstream has to compare strings
+//-------------------------------------------------------------------
+void AAKPlayerData::buildActionCache()
 {
-	return (action == LedgeIdleAnim
-		|| action == LedgeLeftAnim
-		|| action == LedgeRightAnim
-		|| action == LedgeUpAnim
-		);
-}
+   mActionCache.setSize(actionCount);
+   mActionNames.clear();
 
-bool AAKPlayerData::isClimbAction(U32 action)
-{
-	return (action == ClimbIdleAnim
-		|| action == ClimbLeftAnim
-		|| action == ClimbRightAnim
-		|| action == ClimbUpAnim
-		|| action == ClimbDownAnim
-		);
+   for (S32 i = 0; i < actionCount; i++)
+   {
+      const ActionAnimation& anim = actionList[i];
+      ActionCacheEntry& entry = mActionCache[i];
+
+      entry.dir = anim.dir;
+      entry.speed = anim.speed;
+      entry.sequence = anim.sequence;
+      entry.transitionTime = 0.0f;
+      entry.pad = 0;
+
+      entry.flags = 0;
+      if (anim.sequence != -1)
+         entry.flags |= ActionValid;
+      if (anim.velocityScale)
+         entry.flags |= ActionVelocityScale;
+
+      switch (i)
+      {
+      case Death1Anim:
+         entry.flags |= ActionDeath;
+         break;
+
+      case JumpAnim:
+      case StandJumpAnim:
+         entry.flags |= ActionJump;
+         break;
+
+      case StandingLandAnim:
+      case RunningLandAnim:
+         entry.flags |= ActionLand;
+         break;
+
+      case LedgeIdleAnim:
+      case LedgeLeftAnim:
+      case LedgeRightAnim:
+      case LedgeUpAnim:
+         entry.flags |= ActionLedge;
+         break;
+
+      case ClimbIdleAnim:
+      case ClimbUpAnim:
+      case ClimbDownAnim:
+      case ClimbLeftAnim:
+      case ClimbRightAnim:
+         entry.flags |= ActionClimb;
+         break;
+      }
+
+      //Stop animation needs a fast blend to look right
+      if (i == StopAnim)
+         entry.transitionTime = 0.15f;
+
+      //Jump, ledge and climb actions need a faster blend to look right
+      if (entry.flags & (ActionJump | ActionLedge | ActionClimb))
+         entry.transitionTime = 0.1f;
+
+      //Land animations need a super-fast blend to look right
+      if (entry.flags & ActionLand)
+         entry.transitionTime = 0.05f;
+
+      //first one wins, same as the old linear search (root is never looked up by name)
+      if (i > 0 && anim.name)
+      {
+         StringTableEntry name = StringTable->insert(anim.name);
+         if (mActionNames.find(name) == mActionNames.end())
+            mActionNames.insertUnique(name, i);
+      }
+   }
 }
 
-bool AAKPlayerData::isLandAction(U32 action)
+//-------------------------------------------------------------------
+// AAKPlayerData::findAction
+//
+// Returns the action index for a sequence name, or -1
+//-------------------------------------------------------------------
+S32 AAKPlayerData::findAction(const char* name) const
 {
-	return (action == StandingLandAnim
-		|| action == RunningLandAnim
-		);
-}
+   //lookup never adds to the string table; unknown names can't be actions
+   StringTableEntry key = StringTable->lookup(name);
+   if (!key)
+      return -1;
 
+   HashTable<StringTableEntry, U32>::ConstIterator itr = mActionNames.find(key);
+   return itr != mActionNames.end() ? (S32)itr->value : -1;
+}
 
 void AAKPlayerData::initPersistFields()
 {
@@ -832,6 +936,7 @@ AAKPlayer::AAKPlayer() : Player()
 
 	//Ubiq: Climb state
 	mClimbTriggerCount = 0;
+	mClimbZoneCount = 0;
 	mClimbState.active = false;
 	mClimbState.direction = MOVE_DIR_NONE;
 	mClimbState.surfaceNormal.set(0,0,0);
@@ -857,6 +962,27 @@ AAKPlayer::AAKPlayer() : Player()
 
 	//Ubiq: Stop state
 	mStoppingTimer = 0;
+
+	//Ubiq: Moving platforms
+	mPlatformState.lostTicks = 0;
+
+	//Ubiq: Rewind
+	mRewindTickCount = 0;
+
+	//Ubiq: Animation LOD
+	mAnimLOD.stale = false;
+	mAnimLOD.ticksSkipped = 0;
+
+	//Ubiq: Net state
+	dMemset(&mNetState, 0, sizeof(mNetState));
+	dMemset(&mSurfaceNet, 0, sizeof(mSurfaceNet));
+
+	//Ubiq: Speculative probes
+	for (U32 i = 0; i < AAKProbeCache::NumProbeTypes; i++)
+		mSpeculativeProbes[i] = NULL;
+
+	//Ubiq: Camera stage
+	mCameraStageTick = U32_MAX;
 }
 
 
@@ -869,6 +995,9 @@ void AAKPlayer::onRemove()
       SFX_DELETE( mSlideSound );
    }
 
+   releaseSpeculativeProbes();
+   releaseCameraDependents();
+
    Parent::onRemove();
 }
 
@@ -897,13 +1026,13 @@ bool AAKPlayer::onNewDataBlock( GameBaseData *dptr, bool reload )
 void AAKPlayer::processTick(const Move* move)
 {
    PROFILE_SCOPE(AAKPlayer_ProcessTick);
+   AAKProbeScratch::TickScope scratchScope;
 
    bool prevMoveMotion = mMoveMotion;
    Pose prevPose = getPose();
 
-   //Ubiq:
-   if(mShapeInstance)
-      mShapeInstance->animate();
+   //Ubiq: ghosts nobody is looking at only rebuild their skeleton every few ticks
+   updateAnimationLOD();
 
    // If we're not being controlled by a client, let the
    // AI sub-module get a chance at producing a move.
@@ -912,10 +1041,16 @@ void AAKPlayer::processTick(const Move* move)
       move = &aiMove;
 
    // Manage the control object and filter moves for the player
+   //Ubiq: a camera goal tracking us waits for the camera stage, after we've moved,
+   //and a dormant one (no follower is using it) isn't ticked at all
    Move pMove,cMove;
+   const Move* controlMove = NULL;
    if (mControlObject) {
-      if (!move)
-         mControlObject->processTick(0);
+      bool deferControl = isCameraGoal(mControlObject) || CameraGoalActivation::isDormant(mControlObject);
+      if (!move) {
+         if (!deferControl)
+            mControlObject->processTick(0);
+      }
       else {
          //Ubiq: if mounted, only vehicle will get the move
          if (isMounted())
@@ -944,7 +1079,9 @@ void AAKPlayer::processTick(const Move* move)
             pMove = *move;
             cMove = *move;
          }
-         mControlObject->processTick((mDamageState == Enabled)? &cMove: &NullMove);
+         controlMove = (mDamageState == Enabled)? &cMove: &NullMove;
+         if (!deferControl)
+            mControlObject->processTick(controlMove);
          move = &pMove;
       }
    }
@@ -1025,8 +1162,10 @@ void AAKPlayer::processTick(const Move* move)
          if (isGhost()) {
             // If we haven't run out of prediction time,
             // predict using the last known move.
-            if (mPredictionCount-- <= 0)
+            if (mPredictionCount-- <= 0) {
+               updateCameraStage(controlMove);
                return;
+            }
 
             move = &mDelta.move;
          }
@@ -1037,7 +1176,14 @@ void AAKPlayer::processTick(const Move* move)
          updateAnimation(TickSec);
 
       PROFILE_START(AAKPlayer_PhysicsSection);
-      if ( isServerObject() || didRenderLastRender() || getControllingClient() )
+      if ( isRemoteGhost() )
+      {
+         //Ubiq: the server already worked out our climb/wall/ledge state,
+         //just coast along with it until the next update
+         if ( didRenderLastRender() )
+            updateRemoteGhost();
+      }
+      else if ( isServerObject() || didRenderLastRender() || getControllingClient() )
       {
          if ( !mPhysicsRep )
          {
@@ -1053,6 +1199,7 @@ void AAKPlayer::processTick(const Move* move)
             }
          }
 
+         updateClimbZones();
          updateState();
          updateMove(move);
          updateLookAnimation();
@@ -1099,7 +1246,18 @@ void AAKPlayer::processTick(const Move* move)
    }
 
    if (!isGhost())
+   {
       updateAttachment();
+      updateRewind();
+      updateNetState();
+      updateSurfaceAnchor();
+   }
+
+   //Ubiq: camera goals & followers see where we ended up this tick
+   updateCameraStage(controlMove);
+
+   //Ubiq: start next tick's climb & ledge probes
+   issueSpeculativeProbes();
 }
 
 void AAKPlayer::interpolateTick(F32 dt)
@@ -1121,7 +1279,8 @@ void AAKPlayer::interpolateTick(F32 dt)
       if (mActionAnimation.thread)
       {
          //ideally we wouldn't clearTransition, but it gets "stuck" otherwise
-         mShapeInstance->clearTransition(mActionAnimation.thread);
+         if (mShapeInstance->inTransition())
+            mShapeInstance->clearTransition(mActionAnimation.thread);
          mShapeInstance->setPos(mActionAnimation.thread, animPos);
       }
    }
@@ -1157,10 +1316,26 @@ void AAKPlayer::interpolateTick(F32 dt)
    mDelta.dt = dt;
 
    updateRenderChangesByParent();
+
+   //Ubiq: our camera dependents are off the tick, and the process list only
+   //interpolates objects that tick. Goals first, followers blend them
+   for (S32 i = 0; i < mCameraGoals.size(); i++)
+   {
+      if (mCameraGoals[i] && mCameraGoals[i] != mControlObject)
+         mCameraGoals[i]->interpolateTick(dt);
+   }
+   for (S32 i = 0; i < mCameraFollowers.size(); i++)
+   {
+      if (mCameraFollowers[i])
+         mCameraFollowers[i]->interpolateTick(dt);
+   }
 }
 
 void AAKPlayer::advanceTime(F32 dt)
 {
+   //Ubiq: camera dependents aren't forwarded here, the process list advances
+   //every object whether it ticks or not
+
    // Client side animations
    Parent::Parent::advanceTime(dt);
    // Increment timer for triggering idle events.
@@ -1266,47 +1441,69 @@ void AAKPlayer::updateState()
    }
 }
 
+//-------------------------------------------------------------------
+// AAKPlayer::getContactPlatform
+//
+// Returns the path shape findContact found us standing on this tick,
+// if any
+//-------------------------------------------------------------------
+SceneObject* AAKPlayer::getContactPlatform()
+{
+   //findContact doesn't run while mounted or swimming, mContactInfo is stale
+   if (isMounted() || mSwimming || !mContactInfo.contacted || !mContactInfo.contactObject)
+      return NULL;
+
+   if (!(mContactInfo.contactObject->getTypeMask() & PathShapeObjectType)) //Ramen
+      return NULL;
+
+   return mContactInfo.contactObject;
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::updateAttachment
+//
+// Attaches us to (and detaches us from) moving platforms based on the
+// contact findContact already found this tick. Once attached, the
+// scene graph carries us along with the platform and interpolates us
+// relative to it, so we never snap to the platform surface ourselves.
+//-------------------------------------------------------------------
 void AAKPlayer::updateAttachment()
 {
-   Point3F rot, pos;
-   RayInfo rInfo;
-   MatrixF mat = getTransform();
-   mat.getColumn(3, &pos);
-   F32 height = mObjBox.getExtents().z + 0.1;
-   disableCollision();
-   if (gServerContainer.castRay(Point3F(pos.x, pos.y, pos.z + height / 2),
-      Point3F(pos.x, pos.y, pos.z - height / 2),
-      sCollisionMoveMask, &rInfo))
+   SceneObject* platform = getContactPlatform();
+   SceneObject* parent = getParent();
+
+   if (platform)
    {
-      if (rInfo.object->getTypeMask() & PathShapeObjectType) //Ramen
+      mPlatformState.lostTicks = 0;
+
+      //first contact, or stepping from one platform onto another
+      if (platform != parent)
       {
-         if (!mJumpState.active && !mClimbState.active && !mLedgeState.active && !mSlideState.active && !mSwimming)
-            setPosition(rInfo.point, getRotation());
-
-         if (getParent() == NULL)
-         { // ONLY do this if we are not parented
-            //Con::printf("I'm on a pathshape object. Going to attempt attachment.");
-            ShapeBase* col = static_cast<ShapeBase*>(rInfo.object);
-            if (!isGhost())
-            {
-               this->attachToParent(col);
-            }
+         if (parent)
+         {
+            clearProcessAfter();
+            attachToParent(NULL);
          }
+         attachToParent(platform);
       }
-      else
-      {
-         //Con::printf("object %i",rInfo.object->getId());
-      }
+      return;
    }
-   else
+
+   if (!parent)
+      return;
+
+   //jumping off, grabbing something or standing on something else
+   //detaches straight away. Losing contact for a tick or two (bumps, a
+   //fast platform dipping away under us) doesn't.
+   bool leaving = mJumping || mJumpState.active || mLedgeState.active || mClimbState.active
+      || isMounted() || mSwimming || mContactInfo.contacted;
+
+   if (leaving || ++mPlatformState.lostTicks > sPlatformLostTicks)
    {
-      if (getParent() != NULL)
-      {
-         clearProcessAfter();
-         attachToParent(NULL);
-      }
+      clearProcessAfter();
+      attachToParent(NULL);
+      mPlatformState.lostTicks = 0;
    }
-   enableCollision();
 }
 
 void AAKPlayer::updateMove(const Move* move)
@@ -1618,6 +1815,8 @@ void AAKPlayer::updateMove(const Move* move)
    mJumpSurface = mRunSurface = mSlideSurface = false;
    if ( !isMounted() && !mSwimming )	//Ubiq: don't check for surfaces when swimming
       findContact(&mRunSurface,&mJumpSurface,&mSlideSurface,&contactNormal);
+   else
+      mOverlaps.clear();	//Ubiq: start afresh when we come back, triggers may have let us go meanwhile
    if (mJumpSurface)
       mJumpSurfaceNormal = contactNormal;
    if (!mClimbState.active && !mLedgeState.active)
@@ -2041,6 +2240,7 @@ void AAKPlayer::updateMove(const Move* move)
 			mLedgeState.animPos = 0.0f;
 			mLedgeState.deltaAnimPos = 0.0f;
 			mLedgeState.deltaAnimPosVec = 0.0f;
+			mLedgeState.upDir = 0;
 			setMaskBits(LedgeUpMask);
 		}
 
@@ -2064,6 +2264,7 @@ void AAKPlayer::updateMove(const Move* move)
 			mLedgeState.animPos = 0.0f;
 			mLedgeState.deltaAnimPos = 0.0f;
 			mLedgeState.deltaAnimPosVec = 0.0f;
+			mLedgeState.upDir = 0;
 			setMaskBits(LedgeUpMask);
 
 			//clear climbing
@@ -2098,6 +2299,7 @@ void AAKPlayer::updateMove(const Move* move)
 			mLedgeState.animPos = 0.0f;
 			mLedgeState.deltaAnimPos = 0.0f;
 			mLedgeState.deltaAnimPosVec = 0.0f;
+			mLedgeState.upDir = 0;
 			setMaskBits(LedgeUpMask);
 		}
 		else if(ledge)
@@ -2844,19 +3046,8 @@ bool AAKPlayer::canCrouch()
       // we want to move into.
       Box3F B(position - extent, position + extent, true);
 
-      EarlyOutPolyList polyList;
-      polyList.mPlaneList.clear();
-      polyList.mNormal.set( 0,0,0 );
-      polyList.mPlaneList.setSize( 6 );
-      polyList.mPlaneList[0].set( B.minExtents, VectorF( -1,0,0 ) );
-      polyList.mPlaneList[1].set( B.maxExtents, VectorF( 0,1,0 ) );
-      polyList.mPlaneList[2].set( B.maxExtents, VectorF( 1,0,0 ) );
-      polyList.mPlaneList[3].set( B.minExtents, VectorF( 0,-1,0 ) );
-      polyList.mPlaneList[4].set( B.minExtents, VectorF( 0,0,-1 ) );
-      polyList.mPlaneList[5].set( B.maxExtents, VectorF( 0,0,1 ) );
-
       // If an object exists in this space, we must stay prone. Otherwise we are free to crouch.
-      return !getContainer()->buildPolyList( PLC_Collision, B, StaticShapeObjectType, &polyList );
+      return worldBoxIsClear( B, StaticShapeObjectType );
    }
 
    return mPhysicsRep->testSpacials( getPosition(), mDataBlock->crouchBoxSize );
@@ -2868,17 +3059,13 @@ bool AAKPlayer::setActionThread(const char* sequence, bool forward, bool hold, b
 {
    if (anim_clip_flags & ANIM_OVERRIDDEN)
       return false;
-   for (U32 i = 1; i < mDataBlock->actionCount; i++)
-   {
-      AAKPlayerData::ActionAnimation &anim = mDataBlock->actionList[i];
-      if (!dStricmp(anim.name,sequence))
-      {
-         setActionThread(i,forward,hold,wait,fsp,forceSet,useSynchedPos);
-         setMaskBits(ActionMask);
-         return true;
-      }
-   }
-   return false;
+   S32 action = mDataBlock->findAction(sequence);
+   if (action <= 0)
+      return false;
+
+   setActionThread(action,forward,hold,wait,fsp,forceSet,useSynchedPos);
+   setMaskBits(ActionMask);
+   return true;
 }
 
 void AAKPlayer::setActionThread(U32 action, bool forward, bool hold, bool wait, bool fsp, bool forceSet, bool useSynchedPos)
@@ -2909,8 +3096,8 @@ void AAKPlayer::setActionThread(U32 action, bool forward, bool hold, bool wait,
       mark_idle = (action == AAKPlayerData::RootAnim);
       idle_timer = (mark_idle) ? 0.0f : -1.0f;
    }
-   AAKPlayerData::ActionAnimation &anim = mDataBlock->actionList[action];
-   if (anim.sequence != -1)
+   const AAKPlayerData::ActionCacheEntry* anim = mDataBlock->getActionEntry(action);
+   if (anim && (anim->flags & AAKPlayerData::ActionValid))
    {
       mActionAnimation.action          = action;
       mActionAnimation.forward         = forward;
@@ -2927,22 +3114,9 @@ void AAKPlayer::setActionThread(U32 action, bool forward, bool hold, bool wait,
       {
          // The transition code needs the timeScale to be set in the
          // right direction to know which way to go.
-         F32   transTime = sAnimationTransitionTime;
-
-			//Stop animation needs a fast blend to look right
-			if(action == AAKPlayerData::StopAnim)
-				transTime = 0.15f;
-
-			//Jump, ledge and climb actions need a faster blend to look right
-			if(mDataBlock && (mDataBlock->isJumpAction(action)
-            || mDataBlock->isLedgeAction(action)
-            || mDataBlock->isClimbAction(action)))
-				transTime = 0.1f;
-
-			//Land animations need a super-fast blend to look right
-			if(action == AAKPlayerData::StandingLandAnim
-				|| action == AAKPlayerData::RunningLandAnim)
-				transTime = 0.05f;
+         //Stop, jump, ledge, climb and land actions carry their own (faster)
+         //blend time, see AAKPlayerData::buildActionCache
+         F32   transTime = anim->transitionTime > 0.0f ? anim->transitionTime : sAnimationTransitionTime;
 
 			F32 pos;
 			if(reversingSameAnimation || bothUseSynchedPos)
@@ -2951,11 +3125,11 @@ void AAKPlayer::setActionThread(U32 action, bool forward, bool hold, bool wait,
 				pos = mActionAnimation.forward ? 0.0f : 1.0f;
 
          mShapeInstance->setTimeScale(mActionAnimation.thread, mActionAnimation.forward ? 1.0f : -1.0f);
-         mShapeInstance->transitionToSequence(mActionAnimation.thread, anim.sequence, pos, transTime, true);
+         mShapeInstance->transitionToSequence(mActionAnimation.thread, anim->sequence, pos, transTime, true);
       }
       else
       {
-         S32 seq = anim.sequence;
+         S32 seq = anim->sequence;
          S32 imageBasedSeq = convertActionToImagePrefix(mActionAnimation.action);
          if (imageBasedSeq != -1)
             seq = imageBasedSeq;
@@ -3134,17 +3308,14 @@ void AAKPlayer::updateActionThread()
       pickActionAnimation();
    }
 
-   if ( (mActionAnimation.action != AAKPlayerData::StandingLandAnim) &&
-      (mActionAnimation.action != AAKPlayerData::RunningLandAnim) &&
-      (mActionAnimation.action != AAKPlayerData::NullAnimation)  && !(anim_clip_flags & ANIM_OVERRIDDEN))   {
+   const AAKPlayerData::ActionCacheEntry* anim = mDataBlock->getActionEntry(mActionAnimation.action);
+   if (anim && !(anim->flags & AAKPlayerData::ActionLand) && !(anim_clip_flags & ANIM_OVERRIDDEN))   {
       // Update action animation time scale to match ground velocity
-      AAKPlayerData::ActionAnimation &anim =
-         mDataBlock->actionList[mActionAnimation.action];
       F32 scale = 1;
-      if (anim.velocityScale && anim.speed) {
+      if ((anim->flags & AAKPlayerData::ActionVelocityScale) && anim->speed) {
          VectorF vel;
          mWorldToObj.mulV(mVelocity,&vel);
-         scale = mFabs(mDot(vel, anim.dir) / anim.speed);
+         scale = mFabs(mDot(vel, anim->dir) / anim->speed);
 
          if (scale > mDataBlock->maxTimeScale)
             scale = mDataBlock->maxTimeScale;
@@ -3156,6 +3327,16 @@ void AAKPlayer::updateActionThread()
    PROFILE_END();
 }
 
+//Ubiq: same answer as Player::inDeathAnim, but read from the action cache
+//instead of the engine's action list
+bool AAKPlayer::inDeathAction() const
+{
+   if ((anim_clip_flags & ANIM_OVERRIDDEN) && !(anim_clip_flags & IS_DEATH_ANIM))
+      return false;
+
+   return mActionAnimation.thread && mDataBlock->isDeathAction(mActionAnimation.action);
+}
+
 void AAKPlayer::pickActionAnimation()
 {
    // Only select animations in our normal move state.
@@ -3178,6 +3359,10 @@ void AAKPlayer::pickActionAnimation()
 
    U32 action = AAKPlayerData::RootAnim;
 
+	//Ubiq: speed is needed by most branches below, work it out once
+	const F32 speedSq = mVelocity.lenSquared();
+	const bool moving = speedSq >= 0.1f * 0.1f;
+
 	//Ubiq: death overrides everything else
 	if(mDamageState != Enabled)
 	{
@@ -3204,7 +3389,7 @@ void AAKPlayer::pickActionAnimation()
 		action = AAKPlayerData::LedgeIdleAnim;
 
 		//are we moving fast enough to warrant a move animation?
-		if(mVelocity.len() >= 0.1f)
+		if(moving)
 		{
 			//choose the appropriate animation
 			if(mLedgeState.direction == MOVE_DIR_LEFT)
@@ -3221,7 +3406,7 @@ void AAKPlayer::pickActionAnimation()
 		action = AAKPlayerData::ClimbIdleAnim;
 
 		//are we moving fast enough to warrant a move animation?
-		if(mVelocity.len() >= 0.1f)
+		if(moving)
 		{
 			//choose the appropriate animation
 			switch(mClimbState.direction)
@@ -3254,7 +3439,7 @@ void AAKPlayer::pickActionAnimation()
 		action = AAKPlayerData::WallIdleAnim;
 
 		//are we moving fast enough to warrant a move animation?
-		if(mVelocity.len() >= 0.1f)
+		if(moving)
 		{
 			//choose the appropriate animation
 			switch(mWallHugState.direction)
@@ -3332,13 +3517,13 @@ void AAKPlayer::pickActionAnimation()
 			mWorldToObj.mulV(mVelocity,&vel);
 
 			//are we moving?
-			if(vel.len() > 0.01f)
+			if(vel.lenSquared() > 0.01f * 0.01f)
 			{
 				//forward
 				if(mDot(vel, Point3F(0,1,0)) > 0.5)
 				{
 					//run
-					if(mVelocity.len() > mDataBlock->walkRunAnimVelocity)
+					if(speedSq > mDataBlock->walkRunAnimVelocity * mDataBlock->walkRunAnimVelocity)
 					{
 						action = AAKPlayerData::RunForwardAnim;
 						useSynchedPos = true;
@@ -3390,7 +3575,8 @@ bool AAKPlayer::step(Point3F *pos,F32 *maxStep,F32 time)
    box.maxExtents = mObjBox.maxExtents + offset + *pos;
    box.maxExtents.z += mDataBlock->maxStepHeight * scale.z + sMinFaceDistance;
 
-	ConcretePolyList polyList;
+	AAKScratchPolyList<ConcretePolyList> scratchList;
+	ConcretePolyList& polyList = *scratchList;
 	CollisionWorkingList& rList = mConvex.getWorkingList();
 	CollisionWorkingList* pList = rList.wLink.mNext;
 	while (pList != &rList)
@@ -3534,48 +3720,15 @@ void AAKPlayer::findContact( bool *run, bool *jump, bool *slide, VectorF *contac
 {
    SceneObject *contactObject = NULL;
 
-   Vector<SceneObject*> overlapObjects;
+   //Ubiq: reuse the overlap list, it keeps its capacity from tick to tick
+   mOverlapObjects.clear();
    if ( mPhysicsRep )
-      mPhysicsRep->findContact( &contactObject, contactNormal, &overlapObjects );
+      mPhysicsRep->findContact( &contactObject, contactNormal, &mOverlapObjects );
    else
-      _findContact( &contactObject, contactNormal, &overlapObjects );
+      _findContact( &contactObject, contactNormal, &mOverlapObjects );
 
    // Check for triggers, corpses and items.
-   const U32 filterMask = isGhost() ? sClientCollisionContactMask : sServerCollisionContactMask;
-   for ( U32 i=0; i < overlapObjects.size(); i++ )
-   {
-      SceneObject *obj = overlapObjects[i];
-      U32 objectMask = obj->getTypeMask();
-
-      if ( !( objectMask & filterMask ) )
-         continue;
-
-      // Check: triggers, corpses and items...
-      //
-      if (objectMask & TriggerObjectType)
-      {
-         Trigger* pTrigger = static_cast<Trigger*>( obj );
-         pTrigger->potentialEnterObject(this);
-      }
-      else if (objectMask & CorpseObjectType)
-      {
-         // If we've overlapped the worldbounding boxes, then that's it...
-         if ( getWorldBox().isOverlapped( obj->getWorldBox() ) )
-         {
-            ShapeBase* col = static_cast<ShapeBase*>( obj );
-            queueCollision(col,getVelocity() - col->getVelocity());
-         }
-      }
-      else if (objectMask & ItemObjectType)
-      {
-         // If we've overlapped the worldbounding boxes, then that's it...
-         Item* item = static_cast<Item*>( obj );
-         if (  getWorldBox().isOverlapped(item->getWorldBox()) &&
-               item->getCollisionObject() != this && 
-               !item->isHidden() )
-            queueCollision(item,getVelocity() - item->getVelocity());
-      }
-   }
+   updateOverlaps( isGhost() ? sClientCollisionContactMask : sServerCollisionContactMask );
 
    if(contactObject != NULL) {		//Ubiq: this test is necessary or slide is always set true
    F32 vd = (*contactNormal).z;
@@ -3597,6 +3750,123 @@ void AAKPlayer::findContact( bool *run, bool *jump, bool *slide, VectorF *contac
    mContactInfo.slide = *slide;
 }
 
+//does the trigger hold obj at the moment?
+static bool isInTrigger(Trigger* trigger, SceneObject* obj)
+{
+   for ( U32 i = 0; i < trigger->getNumTriggeringObjects(); i++ )
+      if ( trigger->getObject(i) == obj )
+         return true;
+   return false;
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::updateOverlaps
+//
+// Diffs this tick's triggers, corpses and items against last tick's.
+// A trigger that has accepted us only costs a look at its object list
+// until it lets us go; items and corpses are offered every tick of
+// contact until they take us up (an item refused by a full inventory
+// is picked up as soon as there's room). Objects we've stopped
+// overlapping just drop out, triggers notice we've left in their own
+// processTick.
+//-------------------------------------------------------------------
+void AAKPlayer::updateOverlaps(U32 filterMask)
+{
+   const U32 contactMask = TriggerObjectType | CorpseObjectType | ItemObjectType;
+
+   //keep the ones we care about, sorted by id (there are only ever a handful)
+   U32 count = 0;
+   for ( U32 i = 0; i < mOverlapObjects.size(); i++ )
+   {
+      SceneObject* obj = mOverlapObjects[i];
+      U32 objectMask = obj->getTypeMask();
+      if ( !( objectMask & filterMask ) || !( objectMask & contactMask ) )
+         continue;
+
+      U32 j = count++;
+      for ( ; j > 0 && mOverlapObjects[j - 1]->getId() > obj->getId(); j-- )
+         mOverlapObjects[j] = mOverlapObjects[j - 1];
+      mOverlapObjects[j] = obj;
+   }
+
+   //walk both sorted lists together
+   mOverlapsPrev = mOverlaps;
+   mOverlaps.clear();
+
+   U32 prev = 0;
+   for ( U32 i = 0; i < count; i++ )
+   {
+      SceneObject* obj = mOverlapObjects[i];
+      SimObjectId id = obj->getId();
+
+      while ( prev < mOverlapsPrev.size() && mOverlapsPrev[prev].id < id )
+         prev++;
+
+      OverlapEntry entry;
+      if ( prev < mOverlapsPrev.size() && mOverlapsPrev[prev].id == id )
+         entry = mOverlapsPrev[prev++];
+      else
+      {
+         entry.id = id;
+         entry.pending = true;
+      }
+
+      //triggers can drop us while we're still in their box (odd shaped
+      //polyhedrons), offer ourselves again the tick that happens
+      if ( !entry.pending && ( obj->getTypeMask() & TriggerObjectType ) )
+         entry.pending = !isInTrigger( static_cast<Trigger*>( obj ), this );
+
+      if ( entry.pending )
+         entry.pending = !deliverOverlapEnter( obj );
+
+      mOverlaps.push_back( entry );
+   }
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::deliverOverlapEnter
+//
+// Offers us to a trigger, corpse or item we're overlapping. Returns
+// false if we should try again next tick: the trigger didn't take us,
+// or the corpse / item is still there to collide with.
+//-------------------------------------------------------------------
+bool AAKPlayer::deliverOverlapEnter(SceneObject* obj)
+{
+   U32 objectMask = obj->getTypeMask();
+
+   if (objectMask & TriggerObjectType)
+   {
+      Trigger* pTrigger = static_cast<Trigger*>( obj );
+      pTrigger->potentialEnterObject(this);
+      return isInTrigger( pTrigger, this );
+   }
+   else if (objectMask & CorpseObjectType)
+   {
+      // If we've overlapped the worldbounding boxes, then that's it...
+      if ( !getWorldBox().isOverlapped( obj->getWorldBox() ) )
+         return false;
+
+      ShapeBase* col = static_cast<ShapeBase*>( obj );
+      queueCollision(col,getVelocity() - col->getVelocity());
+      return false;
+   }
+   else if (objectMask & ItemObjectType)
+   {
+      // If we've overlapped the worldbounding boxes, then that's it...
+      Item* item = static_cast<Item*>( obj );
+      if ( !getWorldBox().isOverlapped(item->getWorldBox()) ||
+           item->getCollisionObject() == this ||
+           item->isHidden() )
+         return false;
+
+      //a refused pickup (full inventory...) has to be offered again
+      queueCollision(item,getVelocity() - item->getVelocity());
+      return false;
+   }
+
+   return true;
+}
+
 //----------------------------------------------------------------------------
 
 void AAKPlayer::setPosition(const Point3F& pos,const Point3F& rot)
@@ -3641,7 +3911,7 @@ void AAKPlayer::setRenderPosition(const Point3F& pos, const Point3F& rot, F32 dt
 	//-------------------------------------------------------------------
 	// Orient to ground
 	//-------------------------------------------------------------------
-   else if (inDeathAnim() || (mDataBlock->orientToGround && mContactTimer < sContactTickTime))
+   else if (inDeathAction() || (mDataBlock->orientToGround && mContactTimer < sContactTickTime))
 	{
 		VectorF normal;
 		Point3F corner[3], hit[3]; S32 c;
@@ -3801,7 +4071,38 @@ void AAKPlayer::writePacketData(GameConnection *connection, BitStream *stream)
 	//----------------------------------------------------------------------------
 	// Ubiq custom
 	//----------------------------------------------------------------------------
+	writeMoveStates(stream);
+}
+
+void AAKPlayer::readPacketData(GameConnection *connection, BitStream *stream)
+{
+   Parent::readPacketData(connection, stream);
+
+   Point3F rot;
+   
+   stream->read(&rot.x);
+   stream->read(&rot.y);
+
+   if (!ignore_updates)
+      setPosition(getPosition(), Point3F(rot.x, rot.y, mRot.z));
+   
+	//----------------------------------------------------------------------------
+	// Ubiq custom
+	//----------------------------------------------------------------------------
+	MoveStates states;
+	getMoveStates(&states);
+	readMoveStates(stream, &states);
+	setMoveStates(states);
+}
 
+//-------------------------------------------------------------------
+// AAKPlayer::writeMoveStates
+//
+// Ubiq custom movement states, shared by the control object packet
+// data and snapshots
+//-------------------------------------------------------------------
+void AAKPlayer::writeMoveStates(Stream *stream)
+{
 	//Ubiq: Slide state
 	stream->write(mSlideState.active);
 	stream->write(mSlideState.surfaceNormal.x);
@@ -3849,121 +4150,868 @@ void AAKPlayer::writePacketData(GameConnection *connection, BitStream *stream)
 	stream->write(mStoppingTimer);
 }
 
-void AAKPlayer::readPacketData(GameConnection *connection, BitStream *stream)
+void AAKPlayer::readMoveStates(Stream *stream, MoveStates* states)
 {
-   Parent::readPacketData(connection, stream);
-
-   Point3F rot;
-   
-   stream->read(&rot.x);
-   stream->read(&rot.y);
-
-   if (!ignore_updates)
-      setPosition(getPosition(), Point3F(rot.x, rot.y, mRot.z));
-   
-	//----------------------------------------------------------------------------
-	// Ubiq custom
-	//----------------------------------------------------------------------------
-
 	//Ubiq: Slide state
-	stream->read(&mSlideState.active);
-	stream->read(&mSlideState.surfaceNormal.x);
-	stream->read(&mSlideState.surfaceNormal.y);
-	stream->read(&mSlideState.surfaceNormal.z);
+	stream->read(&states->slide.active);
+	stream->read(&states->slide.surfaceNormal.x);
+	stream->read(&states->slide.surfaceNormal.y);
+	stream->read(&states->slide.surfaceNormal.z);
 
 	//Ubiq: Jump state
-	stream->read(&mJumpState.active);
-	stream->read(&mJumpState.isCrouching);
-	stream->read(&mJumpState.crouchDelay);
+	stream->read(&states->jump.active);
+	stream->read(&states->jump.isCrouching);
+	stream->read(&states->jump.crouchDelay);
 	U16 jumpType;
 	stream->read(&jumpType);
-	mJumpState.jumpType = (JumpType)jumpType;
+	states->jump.jumpType = (JumpType)jumpType;
 
 	//Ubiq: Climb state
-	stream->read(&mClimbState.active);
+	stream->read(&states->climb.active);
 	U16 climbDirTemp;
 	stream->read(&climbDirTemp);
-	mClimbState.direction = (MoveDir)climbDirTemp;
-	stream->read(&mClimbState.surfaceNormal.x);
-	stream->read(&mClimbState.surfaceNormal.y);
-	stream->read(&mClimbState.surfaceNormal.z);
-	stream->read(&mClimbTriggerCount);
+	states->climb.direction = (MoveDir)climbDirTemp;
+	stream->read(&states->climb.surfaceNormal.x);
+	stream->read(&states->climb.surfaceNormal.y);
+	stream->read(&states->climb.surfaceNormal.z);
+	stream->read(&states->climbTriggerCount);
 
 	//Ubiq: Wallhug state
-	stream->read(&mWallHugState.active);
-	stream->read(&mWallHugState.surfaceNormal.x);
-	stream->read(&mWallHugState.surfaceNormal.y);
-	stream->read(&mWallHugState.surfaceNormal.z);
+	stream->read(&states->wallHug.active);
+	stream->read(&states->wallHug.surfaceNormal.x);
+	stream->read(&states->wallHug.surfaceNormal.y);
+	stream->read(&states->wallHug.surfaceNormal.z);
 	U16 wallDirTemp;
 	stream->read(&wallDirTemp);
-	mWallHugState.direction = (MoveDir)wallDirTemp;
+	states->wallHug.direction = (MoveDir)wallDirTemp;
 
 	//Ubiq: Ledge state
-	stream->read(&mLedgeState.active);
-	stream->read(&mLedgeState.ledgeNormal.x);
-	stream->read(&mLedgeState.ledgeNormal.y);
-	stream->read(&mLedgeState.ledgeNormal.z);
-	stream->read(&mLedgeState.ledgePoint.x);
-	stream->read(&mLedgeState.ledgePoint.y);
-	stream->read(&mLedgeState.ledgePoint.z);
+	stream->read(&states->ledge.active);
+	stream->read(&states->ledge.ledgeNormal.x);
+	stream->read(&states->ledge.ledgeNormal.y);
+	stream->read(&states->ledge.ledgeNormal.z);
+	stream->read(&states->ledge.ledgePoint.x);
+	stream->read(&states->ledge.ledgePoint.y);
+	stream->read(&states->ledge.ledgePoint.z);
 	U16 grabDirTemp;
 	stream->read(&grabDirTemp);
-	mLedgeState.direction = (MoveDir)grabDirTemp;
-	stream->read(&mLedgeState.climbingUp);
-	stream->read(&mLedgeState.animPos);
+	states->ledge.direction = (MoveDir)grabDirTemp;
+	stream->read(&states->ledge.climbingUp);
+	stream->read(&states->ledge.animPos);
 
 	//Ubiq: Land state
-	stream->read(&mLandState.active);
-	stream->read(&mLandState.timer);
+	stream->read(&states->land.active);
+	stream->read(&states->land.timer);
 
 	//Ubiq: Stop state
-	stream->read(&mStoppingTimer);
+	stream->read(&states->stoppingTimer);
 }
 
-U32 AAKPlayer::packUpdate(NetConnection *con, U32 mask, BitStream *stream)
+//-------------------------------------------------------------------
+// AAKPlayer::getMoveStates / setMoveStates
+//
+// readMoveStates fills a copy of the states so a caller can drop a
+// truncated read instead of applying half of it
+//-------------------------------------------------------------------
+void AAKPlayer::getMoveStates(MoveStates* states)
 {
-   U32 retMask = Parent::packUpdate(con, mask, stream);
+	states->slide = mSlideState;
+	states->jump = mJumpState;
+	states->climb = mClimbState;
+	states->climbTriggerCount = mClimbTriggerCount;
+	states->wallHug = mWallHugState;
+	states->ledge = mLedgeState;
+	states->land = mLandState;
+	states->stoppingTimer = mStoppingTimer;
+}
 
-   //LedgeUpMask
-   if (stream->writeFlag(mask & LedgeUpMask))
-   {
-      stream->write(mLedgeState.animPos);
-   }
+void AAKPlayer::setMoveStates(const MoveStates& states)
+{
+	mSlideState = states.slide;
+	mJumpState = states.jump;
+	mClimbState = states.climb;
+	mClimbTriggerCount = states.climbTriggerCount;
+	mWallHugState = states.wallHug;
+	mLedgeState = states.ledge;
+	mLandState = states.land;
+	mStoppingTimer = states.stoppingTimer;
+}
 
-   return retMask;
+//-------------------------------------------------------------------
+// AAKPlayer::getNetState
+//
+// Gathers the movement states remote ghosts need to pick the right
+// animations and extrapolate without probing
+//-------------------------------------------------------------------
+void AAKPlayer::getNetState(NetState* state)
+{
+	state->flags = 0;
+	if(mSlideState.active)		state->flags |= NetSlide;
+	if(mJumpState.active)		state->flags |= NetJump;
+	if(mClimbState.active)		state->flags |= NetClimb;
+	if(mWallHugState.active)	state->flags |= NetWallHug;
+	if(mLedgeState.active)		state->flags |= NetLedge;
+	if(mLedgeState.climbingUp)	state->flags |= NetClimbingUp;
+	if(mLandState.active)		state->flags |= NetLand;
+	if(mFalling)				state->flags |= NetFalling;
+	if(mContactTimer < sContactTickTime)	state->flags |= NetContact;
+	if(mClimbZoneCount > 0)		state->flags |= NetClimbZone;
+
+	state->jumpType = (U8)mJumpState.jumpType;
+	state->climbDir = (U8)mClimbState.direction;
+	state->wallDir = (U8)mWallHugState.direction;
+	state->ledgeDir = (U8)mLedgeState.direction;
+
+	//same priority as pickActionAnimation
+	if(mLedgeState.active)
+		state->normal = mLedgeState.ledgeNormal;
+	else if(mClimbState.active)
+		state->normal = mClimbState.surfaceNormal;
+	else if(mWallHugState.active)
+		state->normal = mWallHugState.surfaceNormal;
+	else if(mSlideState.active)
+		state->normal = mSlideState.surfaceNormal;
+	else
+		state->normal.set(0.0f, 0.0f, 1.0f);
+
+	state->ledgePoint = mLedgeState.active ? mLedgeState.ledgePoint : Point3F::Zero;
 }
 
-void AAKPlayer::unpackUpdate(NetConnection *con, BitStream *stream)
+//-------------------------------------------------------------------
+// AAKPlayer::netStateChanged
+//
+// Returns true if state differs enough from what we last sent to be
+// worth an update. Normals and ledge points that drift a little while
+// moving along curved geometry don't count.
+//-------------------------------------------------------------------
+bool AAKPlayer::netStateChanged(const NetState& state) const
 {
-   Parent::unpackUpdate(con,stream);
+	if(state.flags != mNetState.flags
+		|| state.jumpType != mNetState.jumpType
+		|| state.climbDir != mNetState.climbDir
+		|| state.wallDir != mNetState.wallDir
+		|| state.ledgeDir != mNetState.ledgeDir)
+		return true;
 
-   //LedgeUpMask
-   if (stream->readFlag())
-   {
-      stream->read(&mLedgeState.animPos);
+	if(mDot(state.normal, mNetState.normal) < 0.999f)
+		return true;
 
-      // New delta for client-side interpolation
-      mLedgeState.deltaAnimPos = mLedgeState.animPos;
-      mLedgeState.deltaAnimPosVec = 0.0f;
-   }
+	return (state.ledgePoint - mNetState.ledgePoint).lenSquared() > 0.05f * 0.05f;
 }
 
-DefineEngineMethod( AAKPlayer, setActionThread, bool, ( const char* name, bool hold, bool fsp ), ( false, true ),
-   "@brief Set the main action sequence to play for this player.\n\n"
-   "@param name Name of the action sequence to set\n"
-   "@param hold Set to false to get a callback on the datablock when the sequence ends (AAKPlayerData::animationDone()).  "
-   "When set to true no callback is made.\n"
-   "@param fsp True if first person and none of the spine nodes in the shape should animate.  False will allow the shape's "
-   "spine nodes to animate.\n"
-   "@return True if succesful, false if failed\n"
-   
-   "@note The spine nodes for the Player's shape are named as follows:\n\n<ul>"
-   "<li>Bip01 Pelvis</li>"
-   "<li>Bip01 Spine</li>"
-   "<li>Bip01 Spine1</li>"
-   "<li>Bip01 Spine2</li>"
-   "<li>Bip01 Neck</li>"
-   "<li>Bip01 Head</li></ul>\n\n"
+//-------------------------------------------------------------------
+// AAKPlayer::writeNetState
+//-------------------------------------------------------------------
+void AAKPlayer::writeNetState(BitStream* stream)
+{
+	stream->writeInt(mNetState.flags, NetStateBits);
+
+	if(mNetState.flags & NetJump)
+		stream->writeFlag(mNetState.jumpType == JumpType_Stand);
+
+	if(mNetState.flags & NetClimb)
+		stream->writeInt(mNetState.climbDir, 3);
+	if(mNetState.flags & NetWallHug)
+		stream->writeInt(mNetState.wallDir, 3);
+	if(mNetState.flags & NetLedge)
+	{
+		stream->writeInt(mNetState.ledgeDir, 3);
+		stream->writeCompressedPoint(mNetState.ledgePoint);
+	}
+
+	if(mNetState.flags & (NetSlide | NetClimb | NetWallHug | NetLedge))
+		stream->writeNormalVector(mNetState.normal, 10);
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::readNetState
+//-------------------------------------------------------------------
+void AAKPlayer::readNetState(BitStream* stream)
+{
+	mNetState.flags = stream->readInt(NetStateBits);
+
+	mNetState.jumpType = JumpType_Run;
+	if(mNetState.flags & NetJump)
+		mNetState.jumpType = stream->readFlag() ? JumpType_Stand : JumpType_Run;
+
+	mNetState.climbDir = mNetState.wallDir = mNetState.ledgeDir = MOVE_DIR_NONE;
+	mNetState.ledgePoint.zero();
+	if(mNetState.flags & NetClimb)
+		mNetState.climbDir = stream->readInt(3);
+	if(mNetState.flags & NetWallHug)
+		mNetState.wallDir = stream->readInt(3);
+	if(mNetState.flags & NetLedge)
+	{
+		mNetState.ledgeDir = stream->readInt(3);
+		stream->readCompressedPoint(&mNetState.ledgePoint);
+	}
+
+	mNetState.normal.set(0.0f, 0.0f, 1.0f);
+	if(mNetState.flags & (NetSlide | NetClimb | NetWallHug | NetLedge))
+		stream->readNormalVector(&mNetState.normal, 10);
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::applyNetState
+//
+// Copies the received net state into the movement states
+//-------------------------------------------------------------------
+void AAKPlayer::applyNetState()
+{
+	const NetState& state = mNetState;
+	const VectorF none(0.0f, 0.0f, 0.0f);
+
+	mSlideState.active = (state.flags & NetSlide) != 0;
+	mSlideState.surfaceNormal = mSlideState.active ? state.normal : none;
+
+	mJumpState.active = (state.flags & NetJump) != 0;
+	mJumpState.jumpType = (JumpType)state.jumpType;
+
+	mClimbState.active = (state.flags & NetClimb) != 0;
+	mClimbState.direction = (MoveDir)state.climbDir;
+	mClimbState.surfaceNormal = mClimbState.active ? state.normal : none;
+
+	mWallHugState.active = (state.flags & NetWallHug) != 0;
+	mWallHugState.direction = (MoveDir)state.wallDir;
+	mWallHugState.surfaceNormal = mWallHugState.active ? state.normal : none;
+
+	mLedgeState.active = (state.flags & NetLedge) != 0;
+	mLedgeState.direction = (MoveDir)state.ledgeDir;
+	mLedgeState.ledgeNormal = mLedgeState.active ? state.normal : none;
+	mLedgeState.ledgePoint = state.ledgePoint;
+	mLedgeState.climbingUp = (state.flags & NetClimbingUp) != 0;
+
+	mLandState.active = (state.flags & NetLand) != 0;
+
+	mFalling = (state.flags & NetFalling) != 0;
+	mContactTimer = (state.flags & NetContact) ? 0 : sContactTickTime;
+	mClimbZoneCount = (state.flags & NetClimbZone) ? 1 : 0;
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::updateNetState
+//
+// Server side, flags the net state dirty when it changes
+//-------------------------------------------------------------------
+void AAKPlayer::updateNetState()
+{
+	NetState state;
+	getNetState(&state);
+
+	if(netStateChanged(state))
+	{
+		mNetState = state;
+		setMaskBits(NetStateMask);
+	}
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::isRemoteGhost
+//
+// Returns true if this is a ghost of somebody else's player, which
+// takes its movement states from the server rather than probing
+//-------------------------------------------------------------------
+bool AAKPlayer::isRemoteGhost()
+{
+	return isGhost() && !sRemoteGhostProbes && !isControlObject();
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::updateRemoteGhost
+//
+// Lightweight stand-in for updateMove/updatePos on remote ghosts.
+// Velocity from the last update is kept flat against whatever surface
+// the server says we're on and gravity only applies in the air; no
+// collision, the next server update corrects any drift.
+//-------------------------------------------------------------------
+void AAKPlayer::updateRemoteGhost()
+{
+	bool onSurface = mLedgeState.active || mClimbState.active || mWallHugState.active;
+	bool onGround = mContactTimer < sContactTickTime && !mJumpState.active;
+
+	if(onSurface && mSurfaceNet.kind != SurfaceNone)
+	{
+		//dead reckon along the line / plane the server anchored us to
+		constrainToSurface(NULL, &mVelocity);
+
+		if(mLedgeState.climbingUp)
+			mVelocity.zero();
+	}
+	else if(onSurface)
+	{
+		if(mLedgeState.active)
+			mVelocity -= mLedgeState.ledgeNormal * mDot(mVelocity, mLedgeState.ledgeNormal);
+		else if(mClimbState.active)
+			mVelocity -= mClimbState.surfaceNormal * mDot(mVelocity, mClimbState.surfaceNormal);
+		else
+			mVelocity -= mWallHugState.surfaceNormal * mDot(mVelocity, mWallHugState.surfaceNormal);
+
+		//ledge up is driven by the animation position, not velocity
+		if(mLedgeState.climbingUp)
+			mVelocity.zero();
+	}
+	else if(onGround)
+	{
+		if(mVelocity.z < 0.0f && !mSlideState.active)
+			mVelocity.z = 0.0f;
+	}
+	else if(!mSwimming)
+	{
+		mVelocity.z += mNetGravity * TickSec;
+		mVelocity.z = getMax(mVelocity.z, -sMaxVelocity);
+	}
+
+	Point3F pos = getPosition();
+	mDelta.posVec = pos;
+	pos += mVelocity * TickSec;
+	if(onSurface)
+		constrainToSurface(&pos, NULL);
+	mDelta.pos = pos;
+	mDelta.posVec -= pos;
+
+	mDelta.rot = mRot;
+	mDelta.rotVec.zero();
+	mDelta.head = mHead;
+	mDelta.headVec.zero();
+
+	setPosition(pos, mRot);
+	updateLookAnimation();
+	updateDeathOffsets();
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::getSurfaceKind
+//
+// Returns which surface (if any) the player's motion is confined to
+//-------------------------------------------------------------------
+U32 AAKPlayer::getSurfaceKind(VectorF* normal)
+{
+	if(isMounted())
+		return SurfaceNone;
+
+	//ledge up is driven by its own animation position
+	if(mLedgeState.active && !mLedgeState.climbingUp)
+	{
+		*normal = mLedgeState.ledgeNormal;
+		return SurfaceLine;
+	}
+
+	if(mClimbState.active && !mLedgeState.active)
+	{
+		*normal = mClimbState.surfaceNormal;
+		return SurfacePlane;
+	}
+
+	if(mWallHugState.active)
+	{
+		*normal = mWallHugState.surfaceNormal;
+		return SurfaceLine;
+	}
+
+	return SurfaceNone;
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::getSurfaceAxes
+//
+// Builds the surface axes from a normal; u runs horizontally along the
+// surface and v up it. Server and client both derive them from the
+// same (unquantized) normal so coordinates line up exactly.
+//-------------------------------------------------------------------
+bool AAKPlayer::getSurfaceAxes(const VectorF& normal, VectorF* u, VectorF* v)
+{
+	*u = mCross(normal, VectorF(0.0f, 0.0f, 1.0f));
+	if(u->lenSquared() < 0.01f)
+		return false;	//floor or ceiling, not something we hang off
+
+	u->normalize();
+	*v = mCross(*u, normal);
+	v->normalize();
+	return true;
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::getSurfaceCoords
+//
+// Quantized surface coordinates of pos. Returns false if pos is off
+// the anchored line/plane or out of range, in which case a new anchor
+// (or a full position update) is needed.
+//-------------------------------------------------------------------
+bool AAKPlayer::getSurfaceCoords(const Point3F& pos, S32* s, S32* t) const
+{
+	const S32 maxCoord = (1 << (sSurfaceCoordBits - 1)) - 1;
+
+	Point3F offset = pos - mSurfaceNet.anchor;
+	F32 fs = mDot(offset, mSurfaceNet.u) * sSurfaceCoordScale;
+	F32 ft = mSurfaceNet.kind == SurfacePlane ? mDot(offset, mSurfaceNet.v) * sSurfaceCoordScale : 0.0f;
+	if(mFabs(fs) > maxCoord || mFabs(ft) > maxCoord)
+		return false;
+
+	*s = (S32)mFloor(fs + 0.5f);
+	*t = (S32)mFloor(ft + 0.5f);
+
+	return (getSurfacePoint(*s, *t) - pos).lenSquared() <= sSurfaceTolerance * sSurfaceTolerance;
+}
+
+Point3F AAKPlayer::getSurfacePoint(S32 s, S32 t) const
+{
+	return mSurfaceNet.anchor
+		+ mSurfaceNet.u * (s / sSurfaceCoordScale)
+		+ mSurfaceNet.v * (t / sSurfaceCoordScale);
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::updateSurfaceAnchor
+//
+// Server side. Drops a new anchor when the player enters a surface
+// state, switches surface, or wanders off the anchored line/plane
+// (curved ledges and walls). The full position goes out alongside it.
+//-------------------------------------------------------------------
+void AAKPlayer::updateSurfaceAnchor()
+{
+	VectorF normal;
+	U32 kind = getSurfaceKind(&normal);
+
+	VectorF u, v;
+	if(kind != SurfaceNone && !getSurfaceAxes(normal, &u, &v))
+		kind = SurfaceNone;
+
+	if(kind == SurfaceNone)
+	{
+		if(mSurfaceNet.kind != SurfaceNone)
+		{
+			mSurfaceNet.kind = SurfaceNone;
+			setMaskBits(SurfaceAnchorMask | MoveMask);
+		}
+		return;
+	}
+
+	S32 s, t;
+	if(kind == mSurfaceNet.kind
+		&& mDot(normal, mSurfaceNet.normal) >= 0.999f
+		&& getSurfaceCoords(getPosition(), &s, &t))
+		return;
+
+	mSurfaceNet.kind = kind;
+	mSurfaceNet.anchorId = (mSurfaceNet.anchorId + 1) & ((1 << SurfaceAnchorIdBits) - 1);
+	mSurfaceNet.anchor = getPosition();
+	mSurfaceNet.normal = normal;
+	mSurfaceNet.u = u;
+	mSurfaceNet.v = kind == SurfacePlane ? v : VectorF(0.0f, 0.0f, 0.0f);
+	setMaskBits(SurfaceAnchorMask | MoveMask);
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::writeSurfaceAnchor
+//-------------------------------------------------------------------
+void AAKPlayer::writeSurfaceAnchor(BitStream* stream)
+{
+	stream->writeInt(mSurfaceNet.kind, SurfaceKindBits);
+	if(mSurfaceNet.kind == SurfaceNone)
+		return;
+
+	//sent once per anchor, so full precision
+	stream->writeInt(mSurfaceNet.anchorId, SurfaceAnchorIdBits);
+	mathWrite(*stream, mSurfaceNet.anchor);
+	mathWrite(*stream, mSurfaceNet.normal);
+}
+
+void AAKPlayer::readSurfaceAnchor(BitStream* stream)
+{
+	mSurfaceNet.kind = stream->readInt(SurfaceKindBits);
+	if(mSurfaceNet.kind == SurfaceNone)
+		return;
+
+	mSurfaceNet.anchorId = stream->readInt(SurfaceAnchorIdBits);
+	mathRead(*stream, &mSurfaceNet.anchor);
+	mathRead(*stream, &mSurfaceNet.normal);
+
+	VectorF u, v;
+	if(!getSurfaceAxes(mSurfaceNet.normal, &u, &v))
+	{
+		mSurfaceNet.kind = SurfaceNone;
+		return;
+	}
+	mSurfaceNet.u = u;
+	mSurfaceNet.v = mSurfaceNet.kind == SurfacePlane ? v : VectorF(0.0f, 0.0f, 0.0f);
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::writeSurfaceMove
+//
+// Stands in for Player's MoveMask block: surface coordinates and
+// speeds, yaw and head. Pose, state and the move itself don't change
+// while we're on a surface and remote ghosts don't use the move.
+//-------------------------------------------------------------------
+void AAKPlayer::writeSurfaceMove(BitStream* stream, S32 s, S32 t)
+{
+	stream->writeInt(mSurfaceNet.anchorId, SurfaceAnchorIdBits);
+
+	stream->writeSignedInt(s, sSurfaceCoordBits);
+	stream->writeSignedFloat(mClampF(mDot(mVelocity, mSurfaceNet.u) / sMaxVelocity, -1.0f, 1.0f), 10);
+
+	if(stream->writeFlag(mSurfaceNet.kind == SurfacePlane))
+	{
+		stream->writeSignedInt(t, sSurfaceCoordBits);
+		stream->writeSignedFloat(mClampF(mDot(mVelocity, mSurfaceNet.v) / sMaxVelocity, -1.0f, 1.0f), 10);
+	}
+
+	stream->writeFloat(mRot.z / M_2PI_F, 7);
+	stream->writeSignedFloat(mClampF(mHead.x / M_PI_F, -1.0f, 1.0f), 6);
+	stream->writeSignedFloat(mClampF(mHead.z / M_PI_F, -1.0f, 1.0f), 6);
+}
+
+void AAKPlayer::readSurfaceMove(BitStream* stream)
+{
+	U32 anchorId = stream->readInt(SurfaceAnchorIdBits);
+
+	S32 s = stream->readSignedInt(sSurfaceCoordBits);
+	F32 speedU = stream->readSignedFloat(10) * sMaxVelocity;
+
+	S32 t = 0;
+	F32 speedV = 0.0f;
+	if(stream->readFlag())
+	{
+		t = stream->readSignedInt(sSurfaceCoordBits);
+		speedV = stream->readSignedFloat(10) * sMaxVelocity;
+	}
+
+	F32 rotZ = stream->readFloat(7) * M_2PI_F;
+	F32 headX = stream->readSignedFloat(6) * M_PI_F;
+	F32 headZ = stream->readSignedFloat(6) * M_PI_F;
+
+	//a move against an anchor we haven't got (lost or late packet), the
+	//resent anchor brings a full position with it
+	if(mSurfaceNet.kind == SurfaceNone || anchorId != mSurfaceNet.anchorId)
+		return;
+
+	//control object gets its position from readPacketData
+	if(isControlObject())
+		return;
+
+	mHead.x = headX;
+	mHead.z = headZ;
+
+	applySurfaceMove(getSurfacePoint(s, t),
+		mSurfaceNet.u * speedU + mSurfaceNet.v * speedV,
+		Point3F(mRot.x, mRot.y, rotZ));
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::applySurfaceMove
+//
+// Same warp as Player::unpackUpdate, but both ends of the warp are on
+// the anchored surface, so corrections slide along it
+//-------------------------------------------------------------------
+void AAKPlayer::applySurfaceMove(const Point3F& pos, const VectorF& vel, const Point3F& rot)
+{
+	F32 prevSpeed = mVelocity.len();
+	mVelocity = vel;
+	mPredictionCount = sMaxPredictionTicks;
+
+	if(!isProperlyAdded())
+	{
+		mDelta.pos = pos;
+		mDelta.posVec.zero();
+		mDelta.rot = rot;
+		mDelta.rotVec.zero();
+		mDelta.warpTicks = 0;
+		mDelta.dt = 0.0f;
+		setPosition(pos, rot);
+		return;
+	}
+
+	Point3F cp = mDelta.pos + mDelta.posVec * mDelta.dt;
+	constrainToSurface(&cp, NULL);
+
+	//ticks needed to cover the correction at the average speed
+	F32 dt, as = (vel.len() + prevSpeed) * 0.5f * TickSec;
+	if(!as || (dt = (pos - cp).len() / as) > sMaxWarpTicks)
+		dt = mDelta.dt + sMaxWarpTicks;
+	else
+		dt = (dt <= mDelta.dt) ? mDelta.dt : mCeil(dt - mDelta.dt) + mDelta.dt;
+
+	if(mDelta.dt)
+	{
+		mDelta.pos = cp + (pos - cp) * (mDelta.dt / dt);
+		mDelta.posVec = (cp - mDelta.pos) / mDelta.dt;
+	}
+
+	mDelta.warpCount = 0;
+	mDelta.warpTicks = (S32)mFloor(dt);
+	if(mDelta.warpTicks)
+	{
+		mDelta.warpOffset = (pos - mDelta.pos) / (F32)mDelta.warpTicks;
+
+		mDelta.rotOffset = rot - mDelta.rot;
+		if(mDelta.rotOffset.z < -M_PI_F)
+			mDelta.rotOffset.z += M_2PI_F;
+		else if(mDelta.rotOffset.z > M_PI_F)
+			mDelta.rotOffset.z -= M_2PI_F;
+		mDelta.rotOffset /= (F32)mDelta.warpTicks;
+	}
+	else
+	{
+		mDelta.pos = pos;
+		mDelta.posVec.zero();
+		mDelta.rot = rot;
+		mDelta.rotVec.zero();
+		setPosition(pos, rot);
+	}
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::constrainToSurface
+//
+// Projects pos and/or vel onto the anchored line/plane. Returns
+// false if there's no anchor.
+//-------------------------------------------------------------------
+bool AAKPlayer::constrainToSurface(Point3F* pos, VectorF* vel)
+{
+	if(mSurfaceNet.kind == SurfaceNone)
+		return false;
+
+	if(pos)
+	{
+		Point3F offset = *pos - mSurfaceNet.anchor;
+		*pos = mSurfaceNet.anchor
+			+ mSurfaceNet.u * mDot(offset, mSurfaceNet.u)
+			+ mSurfaceNet.v * mDot(offset, mSurfaceNet.v);
+	}
+
+	if(vel)
+		*vel = mSurfaceNet.u * mDot(*vel, mSurfaceNet.u) + mSurfaceNet.v * mDot(*vel, mSurfaceNet.v);
+
+	return true;
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::writeSnapshot
+//
+// Writes the full player state (transform, velocity, damage and every
+// movement state) for save games. Contacts are not saved, they're
+// found again on the next tick
+//-------------------------------------------------------------------
+static const U32 sPlayerSnapshotTag = 0x504b4141;	//"AAKP"
+
+bool AAKPlayer::writeSnapshot(Stream& stream)
+{
+	AAKUtils::writeSnapshotHeader(stream, sPlayerSnapshotTag, SnapshotVersion);
+
+	mathWrite(stream, getPosition());
+	mathWrite(stream, mRot);
+	mathWrite(stream, mHead);
+	mathWrite(stream, mVelocity);
+	stream.write(getDamageLevel());
+	stream.write(getEnergyLevel());
+	stream.write(mDieOnNextCollision);
+
+	writeMoveStates(&stream);
+
+	//state not needed by the control object packets
+	stream.write(mJumping);
+	stream.write(mClimbState.ignoreClimb);
+	stream.write(mLedgeState.ignoreLedge);
+	stream.write(mLedgeState.deltaAnimPos);
+	stream.write(mLedgeState.deltaAnimPosVec);
+
+	return stream.getStatus() == Stream::Ok;
+}
+
+bool AAKPlayer::readSnapshot(Stream& stream)
+{
+	U16 version;
+	if (!AAKUtils::readSnapshotHeader(stream, sPlayerSnapshotTag, SnapshotVersion, &version, "AAKPlayer"))
+		return false;
+
+	Point3F pos, rot, head;
+	VectorF vel;
+	F32 damage, energy;
+	mathRead(stream, &pos);
+	mathRead(stream, &rot);
+	mathRead(stream, &head);
+	mathRead(stream, &vel);
+	stream.read(&damage);
+	stream.read(&energy);
+	bool dieOnNextCollision;
+	stream.read(&dieOnNextCollision);
+
+	//everything lands in locals first, a truncated snapshot leaves us untouched
+	MoveStates states;
+	getMoveStates(&states);
+	readMoveStates(&stream, &states);
+
+	bool jumping;
+	stream.read(&jumping);
+	stream.read(&states.climb.ignoreClimb);
+	stream.read(&states.ledge.ignoreLedge);
+	stream.read(&states.ledge.deltaAnimPos);
+	stream.read(&states.ledge.deltaAnimPosVec);
+
+	if (stream.getStatus() != Stream::Ok)
+	{
+		Con::errorf("AAKPlayer::readSnapshot - snapshot is truncated");
+		return false;
+	}
+
+	mDieOnNextCollision = dieOnNextCollision;
+	setMoveStates(states);
+	mJumping = jumping;
+
+	setPosition(pos, rot);
+	mHead = head;
+	setVelocity(vel);
+	setDamageLevel(damage);
+	setEnergyLevel(energy);
+	mContactInfo.clear();
+
+	setMaskBits(MoveMask | LedgeUpMask);
+	return true;
+}
+
+DefineEngineMethod( AAKPlayer, getSnapshot, const char*, (), ,
+   "@brief Returns the full player state as a string for save games.\n\n"
+   "@see setSnapshot()\n")
+{
+	U8 buffer[AAKUtils::MaxSnapshotSize];
+	MemStream stream(sizeof(buffer), buffer, false, true);
+	if (!object->writeSnapshot(stream))
+	{
+		Con::errorf("AAKPlayer::getSnapshot - snapshot too large");
+		return "";
+	}
+
+	return AAKUtils::snapshotToString(buffer, stream.getPosition());
+}
+
+DefineEngineMethod( AAKPlayer, setSnapshot, bool, (const char* snapshot), ,
+   "@brief Restores the player state from a string returned by getSnapshot().\n\n"
+   "@return True if successful, false if the snapshot is invalid\n")
+{
+	U8 buffer[AAKUtils::MaxSnapshotSize];
+	U32 size = AAKUtils::snapshotFromString(snapshot, buffer, sizeof(buffer));
+	if (!size)
+	{
+		Con::errorf("AAKPlayer::setSnapshot - invalid snapshot string");
+		return false;
+	}
+
+	MemStream stream(size, buffer, true, false);
+	return object->readSnapshot(stream);
+}
+
+U32 AAKPlayer::packUpdate(NetConnection *con, U32 mask, BitStream *stream)
+{
+   //Ubiq: while on a ledge, climb or wall the move goes out as surface
+   //coordinates instead of the full Player position update
+   S32 surfaceS = 0, surfaceT = 0;
+   bool surfaceMove = (mask & MoveMask)
+      && !(mask & (InitialUpdateMask | NoWarpMask | SurfaceAnchorMask))
+      && mSurfaceNet.kind != SurfaceNone
+      && getSurfaceCoords(getPosition(), &surfaceS, &surfaceT);
+
+   U32 retMask = Parent::packUpdate(con, surfaceMove ? (mask & ~MoveMask) : mask, stream);
+
+   //LedgeUpMask: a climb up started, reversed or finished. Clients
+   //play the animation out themselves from here.
+   if (stream->writeFlag(mask & LedgeUpMask))
+   {
+      if (stream->writeFlag(mLedgeState.climbingUp))
+      {
+         stream->write(mLedgeState.animPos);
+         stream->writeFlag(mLedgeState.upDir < 0);
+      }
+   }
+
+   //NetStateMask
+   if (stream->writeFlag(mask & (NetStateMask | InitialUpdateMask)))
+   {
+      writeNetState(stream);
+   }
+
+   //SurfaceAnchorMask
+   if (stream->writeFlag(mask & (SurfaceAnchorMask | InitialUpdateMask)))
+   {
+      writeSurfaceAnchor(stream);
+   }
+
+   //surface-relative move
+   if (stream->writeFlag(surfaceMove))
+   {
+      writeSurfaceMove(stream, surfaceS, surfaceT);
+   }
+
+   return retMask;
+}
+
+void AAKPlayer::unpackUpdate(NetConnection *con, BitStream *stream)
+{
+   Parent::unpackUpdate(con,stream);
+
+   //LedgeUpMask
+   if (stream->readFlag())
+   {
+      F32 animPos = 0.0f;
+      S8 upDir = 0;
+      if (stream->readFlag())
+      {
+         stream->read(&animPos);
+         upDir = stream->readFlag() ? -1 : 1;
+      }
+
+      //keep our own integration unless it has drifted or changed direction
+      if (upDir == 0 || upDir != mLedgeState.upDir
+         || mFabs(animPos - mLedgeState.animPos) > sLedgeUpTolerance)
+      {
+         mLedgeState.animPos = animPos;
+
+         // New delta for client-side interpolation
+         mLedgeState.deltaAnimPos = mLedgeState.animPos;
+         mLedgeState.deltaAnimPosVec = 0.0f;
+      }
+      mLedgeState.upDir = upDir;
+   }
+
+   //NetStateMask
+   if (stream->readFlag())
+   {
+      readNetState(stream);
+
+      //the control object gets the full states in readPacketData and
+      //predicts the rest itself
+      if (!isControlObject())
+         applyNetState();
+   }
+
+   //SurfaceAnchorMask
+   if (stream->readFlag())
+   {
+      readSurfaceAnchor(stream);
+   }
+
+   //surface-relative move
+   if (stream->readFlag())
+   {
+      readSurfaceMove(stream);
+   }
+}
+
+DefineEngineMethod( AAKPlayer, setActionThread, bool, ( const char* name, bool hold, bool fsp ), ( false, true ),
+   "@brief Set the main action sequence to play for this player.\n\n"
+   "@param name Name of the action sequence to set\n"
+   "@param hold Set to false to get a callback on the datablock when the sequence ends (AAKPlayerData::animationDone()).  "
+   "When set to true no callback is made.\n"
+   "@param fsp True if first person and none of the spine nodes in the shape should animate.  False will allow the shape's "
+   "spine nodes to animate.\n"
+   "@return True if succesful, false if failed\n"
+   
+   "@note The spine nodes for the Player's shape are named as follows:\n\n<ul>"
+   "<li>Bip01 Pelvis</li>"
+   "<li>Bip01 Spine</li>"
+   "<li>Bip01 Spine1</li>"
+   "<li>Bip01 Spine2</li>"
+   "<li>Bip01 Neck</li>"
+   "<li>Bip01 Head</li></ul>\n\n"
    
    "You cannot use setActionThread() to have the Player play one of the motion "
    "determined action animation sequences.  These sequences are chosen based on how "
@@ -4001,473 +5049,1585 @@ DefineEngineMethod( AAKPlayer, setActionThread, bool, ( const char* name, bool h
       "%player.setActionThread( \"sitting\", true, true );\n"
 	"@endtsexample\n")
 {
-   return object->setActionThread( name, true, hold, true, fsp, false, false);
+   return object->setActionThread( name, true, hold, true, fsp, false, false);
+}
+
+//----------------------------------------------------------------------------
+void AAKPlayer::consoleInit()
+{
+   Con::addVariable("$AAKPlayer::renderMyPlayer",TypeBool, &sRenderMyPlayer,
+      "@brief Determines if the player is rendered or not.\n\n"
+      "Used on the client side to disable the rendering of all AAKPlayer objects.  This is "
+      "mainly for the tools or debugging.\n"
+	   "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::renderMyItems",TypeBool, &sRenderMyItems,
+      "@brief Determines if mounted shapes are rendered or not.\n\n"
+      "Used on the client side to disable the rendering of all AAKPlayer mounted objects.  This is "
+      "mainly used for the tools or debugging.\n"
+	   "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::renderCollision", TypeBool, &sRenderPlayerCollision, 
+      "@brief Determines if the player's collision mesh should be rendered.\n\n"
+      "This is mainly used for the tools and debugging.\n"
+	   "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::renderHelpers", TypeBool, &sRenderHelpers,
+      "@brief Determines if the player's nodes, mantle-able geometry et al should be rendered.\n\n"
+      "This is mainly used for the tools and debugging.\n"
+      "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::minWarpTicks",TypeF32,&sMinWarpTicks, 
+      "@brief Fraction of tick at which instant warp occures on the client.\n\n"
+	   "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::maxWarpTicks",TypeS32,&sMaxWarpTicks, 
+      "@brief When a warp needs to occur due to the client being too far off from the server, this is the "
+      "maximum number of ticks we'll allow the client to warp to catch up.\n\n"
+	   "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::maxPredictionTicks",TypeS32,&sMaxPredictionTicks, 
+      "@brief Maximum number of ticks to predict on the client from the last known move obtained from the server.\n\n"
+	   "@ingroup GameObjects\n");
+
+   Con::addVariable("$AAKPlayer::maxImpulseVelocity", TypeF32, &sMaxImpulseVelocity, 
+      "@brief The maximum velocity allowed due to a single impulse.\n\n"
+	   "@ingroup GameObjects\n");
+
+   // Move triggers
+   Con::addVariable("$AAKPlayer::jumpTrigger", TypeS32, &sJumpTrigger, 
+      "@brief The move trigger index used for player jumping.\n\n"
+	   "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::crouchTrigger", TypeS32, &sCrouchTrigger, 
+      "@brief The move trigger index used for player crouching.\n\n"
+	   "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::proneTrigger", TypeS32, &sProneTrigger, 
+      "@brief The move trigger index used for player prone pose.\n\n"
+	   "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::sprintTrigger", TypeS32, &sSprintTrigger, 
+      "@brief The move trigger index used for player sprinting.\n\n"
+	   "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::imageTrigger0", TypeS32, &sImageTrigger0, 
+      "@brief The move trigger index used to trigger mounted image 0.\n\n"
+	   "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::imageTrigger1", TypeS32, &sImageTrigger1, 
+      "@brief The move trigger index used to trigger mounted image 1 or alternate fire "
+      "on mounted image 0.\n\n"
+	   "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::jumpJetTrigger", TypeS32, &sJumpJetTrigger, 
+      "@brief The move trigger index used for player jump jetting.\n\n"
+	   "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::vehicleDismountTrigger", TypeS32, &sVehicleDismountTrigger, 
+      "@brief The move trigger index used to dismount player.\n\n"
+	   "@ingroup GameObjects\n");
+
+   //Ubiq: TODO: add documentation strings
+   addField("climbTriggerCount", TypeS32, Offset(mClimbTriggerCount, AAKPlayer), "");
+   addField("dieOnNextCollision", TypeBool, Offset(mDieOnNextCollision, AAKPlayer), "");
+
+   Con::addVariable("$AAKPlayer::rewindInterval", TypeS32, &sRewindInterval,
+      "@brief Number of ticks between rewind snapshots.\n\n"
+      "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::rewindMemoryCap", TypeS32, &sRewindMemoryCap,
+      "@brief Memory (bytes) each player may use for its rewind buffer, 0 disables rewind.\n\n"
+      "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::remoteGhostProbes", TypeBool, &sRemoteGhostProbes,
+      "@brief If true, ghosts of other clients' players run the full climb, wall and ledge "
+      "probes instead of using the movement state sent by the server.\n\n"
+      "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::animLODTicks", TypeS32, &sAnimLODTicks,
+      "@brief Ticks between skeleton updates for player ghosts that were not rendered "
+      "last frame, 0 animates every ghost every tick.\n\n"
+      "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::asyncProbes", TypeBool, &sAsyncProbes,
+      "@brief If true, players start next tick's climb and ledge probes on a worker thread "
+      "at the end of each tick and use the results if nothing has changed (see AAKSpeculativeProbe).\n\n"
+      "@ingroup GameObjects\n");
+   Con::addVariable("$AAKPlayer::probeCacheSize", TypeS32, &AAKProbeCache::smMaxEntries,
+      "@brief Number of climb, wall hug and ledge probe results shared between players "
+      "(see AAKProbeCache), 0 disables the cache and probes aren't snapped.\n\n"
+      "@ingroup GameObjects\n");
+   afx_consoleInit();
+}
+
+void AAKPlayer::initPersistFields()
+{
+   addField("inWater", TypeBool, Offset(mInWater, AAKPlayer),
+      "@brief script exposure of inWater state.");
+   addField("isFalling", TypeBool, Offset(mFalling, AAKPlayer),
+      "@brief script exposure of falling state.");
+   addField("isRunSurface", TypeBool, Offset(mRunSurface, AAKPlayer),
+      "@brief script exposure of runSurface state.");
+
+   Parent::initPersistFields();
+}
+
+//-----------------------------------------------------------------------------
+
+void AAKPlayer::playFootstepSound( bool triggeredLeft, Material* contactMaterial, SceneObject* contactObject )
+{
+   if (footfallSoundOverride > 0)
+      return;
+   MatrixF footMat = getTransform();
+   if( mWaterCoverage > 0.0 && mWaterCoverage < 1.0 )
+   {
+      if ( mWaterCoverage < mDataBlock->footSplashHeight )
+         SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootShallowSplash), &getTransform());
+      else
+         SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootWading), &getTransform());
+   }
+
+   if (mWaterCoverage >= 1.0)
+   {
+	   if ( triggeredLeft )
+	   {
+         SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootUnderWater), &getTransform());
+         SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootBubbles), &getTransform());
+	   }
+   }
+
+   else if( contactMaterial && contactMaterial->isCustomFootstepSoundValid())
+   {
+      // Footstep sound defined on material.
+      //Ubiq: set volume and pitch based on player velocity (landing is always max volume)
+      F32 speedFactor = mLandState.active ? 1.0f : mVelocity.len()/mDataBlock->maxForwardSpeed;
+      speedFactor = mClampF(speedFactor, 0.3f, 1.0f);
+      
+      F32 volume = speedFactor;
+      F32 pitch = (0.85f * (1.0f - speedFactor)) + (1.15f * speedFactor); //map (0 - 1) to (0.85 - 1.15)
+      
+      SFXSource* source = SFX->createSource(contactMaterial->getCustomFootstepSoundProfile(), &footMat);
+      source->setVolume(volume);
+      source->setPitch(pitch);
+      source->play();
+      SFX->deleteWhenStopped(source);
+   }
+   else
+   {
+      S32 sound = -1;
+      if( contactMaterial && contactMaterial->mFootstepSoundId != -1 )
+         sound = contactMaterial->mFootstepSoundId;
+      else if( contactObject && contactObject->getTypeMask() & VehicleObjectType )
+         sound = 2;
+
+      SFXSource* source = NULL;
+      switch (sound)
+      {
+      case 0: // Soft
+         source = SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootSoft), &getTransform());
+         break;
+      case 1: // Hard
+         source = SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootHard), &getTransform());
+         break;
+      case 2: // Metal
+         source = SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootMetal), &getTransform());
+         break;
+      case 3: // Snow
+         source = SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootSnow), &getTransform());
+         break;
+      }
+
+      if (source)
+      {
+         F32 pitch = mRandF(0.5f, 1.5f);
+         source->setPitch(pitch);
+      }
+   }
+}
+
+void AAKPlayer::playImpactSound()
+{
+   if( mWaterCoverage == 0.0f )
+   {
+      Point3F pos;
+      RayInfo rInfo;
+      MatrixF mat = getTransform();
+      mat.mulP(Point3F(mDataBlock->decalOffset,0.0f,0.0f), &pos);
+
+      if( gClientContainer.castRay( Point3F( pos.x, pos.y, pos.z + 0.01f ),
+                                    Point3F( pos.x, pos.y, pos.z - 2.0f ),
+                                    STATIC_COLLISION_TYPEMASK | VehicleObjectType,
+                                    &rInfo ) )
+      {
+         Material* material = ( rInfo.material ? dynamic_cast< Material* >( rInfo.material->getMaterial() ) : 0 );
+
+         if( material && material->isCustomImpactSoundValid())
+            SFX->playOnce( material->getCustomImpactSoundProfile(), &getTransform() );
+         else
+         {
+            S32 sound = -1;
+            if( material && material->mImpactSoundId )
+               sound = material->mImpactSoundId;
+            else if( rInfo.object->getTypeMask() & VehicleObjectType )
+               sound = 2; // Play metal;
+
+            switch( sound )
+            {
+            case 0:
+               //Soft
+               SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::ImpactSoft), &getTransform());
+               break;
+            case 1:
+               //Hard
+               SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::ImpactHard), &getTransform());
+               break;
+            case 2:
+               //Metal
+               SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::ImpactMetal), &getTransform());
+               break;
+            case 3:
+               //Snow
+               SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::ImpactSnow), &getTransform());
+               break;
+               /*
+            default:
+               //Hard
+               alxPlay(mDataBlock->sound[AAKPlayerData::ImpactHard], &getTransform());
+               break;
+               */
+            }
+         }
+      }
+   }
+
+   mImpactSound = 0;
+}
+
+//--------------------------------------------------------------------------
+
+void AAKPlayer::updateFroth( F32 dt )
+{
+   // update bubbles
+   Point3F moveDir = getVelocity();
+   mBubbleEmitterTime += dt;
+
+   if (mBubbleEmitterTime < mDataBlock->bubbleEmitTime) {
+      if (mSplashEmitter[AAKPlayerData::BUBBLE_EMITTER]) {
+         Point3F emissionPoint = getRenderPosition();
+         U32 emitNum = AAKPlayerData::BUBBLE_EMITTER;
+         mSplashEmitter[emitNum]->emitParticles(mLastPos, emissionPoint,
+            Point3F( 0.0, 0.0, 1.0 ), moveDir, (U32)(dt * 1000.0));
+      }
+   }
+
+   Point3F contactPoint;
+   if (!collidingWithWater(contactPoint)) {
+      mLastWaterPos = mLastPos;
+      return;
+   }
+
+   F32 speed = moveDir.len();
+   if ( speed < mDataBlock->splashVelEpsilon ) 
+      speed = 0.0;
+
+   U32 emitRate = (U32) (speed * mDataBlock->splashFreqMod * dt);
+
+   // If we're in the water, swimming, but not
+   // moving, then lets emit some particles because
+   // we're treading water.  
+   //Ubiq: actually it looks kinda silly - removing
+   /*if ( mSwimming && speed == 0.0 )
+   {
+      emitRate = (U32) (2.0f * mDataBlock->splashFreqMod * dt);
+   }*/
+
+   U32 i;
+   for ( i=0; i<AAKPlayerData::BUBBLE_EMITTER; i++ ) {
+      if (mSplashEmitter[i] )
+         mSplashEmitter[i]->emitParticles( mLastWaterPos,
+            contactPoint, Point3F( 0.0, 0.0, 1.0 ),
+            moveDir, emitRate );
+   }
+   mLastWaterPos = contactPoint;
+}
+
+//----------------------------------------------------------------------------
+// Ubiq custom
+//----------------------------------------------------------------------------
+//-------------------------------------------------------------------
+// AAKPlayer::getNodePosition
+//
+// Returns the current world coordinates of the named node
+//-------------------------------------------------------------------
+Point3F AAKPlayer::getNodePosition(const char *nodeName)
+{
+   if (!mDataBlock || mDataBlock->shapeAssetRef.isNull())
+      return Point3F::Zero;
+
+   Resource<TSShape> shape = mDataBlock->shapeAssetRef.assetPtr->getShapeResource();
+
+	const MatrixF& mat = this->getTransform();
+	Point3F nodePoint;
+	MatrixF nodeMat;
+	S32 ni = shape->findNode(nodeName);
+	AssertFatal(ni >= 0, "ShapeBase::getNodePosition() - couldn't find node!");
+
+	//Ubiq: bring a throttled skeleton up to date before handing out node positions
+	if(mAnimLOD.stale)
+		refreshAnimation();
+
+	nodeMat = mShapeInstance->mNodeTransforms[ni];
+	nodePoint = nodeMat.getPosition();
+	mat.mulP(nodePoint);
+	return nodePoint;
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::setObjectBox
+//
+// Sets the player object box / convex box from the one provided
+//-------------------------------------------------------------------
+void AAKPlayer::setObjectBox(Point3F size)
+{
+   mObjBox = createObjectBox(size);
+
+   // Setup the box for our convex object...
+   mObjBox.getCenter(&mConvex.mCenter);
+   mConvex.mSize.x = mObjBox.len_x() / 2.0f;
+   mConvex.mSize.y = mObjBox.len_y() / 2.0f;
+   mConvex.mSize.z = mObjBox.len_z() / 2.0f;
+
+   // Initialize our scaled attributes as well
+   onScaleChanged();
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::createObjectBox
+//
+// Given a point (containing length, width & height) makes an object box
+//-------------------------------------------------------------------
+Box3F AAKPlayer::createObjectBox(Point3F size)
+{
+   Box3F returnBox;
+   returnBox.maxExtents.x = size.x * 0.5f;
+   returnBox.maxExtents.y = size.y * 0.5f;
+   returnBox.maxExtents.z = size.z;
+   returnBox.minExtents.x = -returnBox.maxExtents.x;
+   returnBox.minExtents.y = -returnBox.maxExtents.y;
+   returnBox.minExtents.z = 0.0f;
+   return returnBox;
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::getSurfaceType
+//
+// Returns the type mask of the object the player is standing on
+//-------------------------------------------------------------------
+U32 AAKPlayer::getSurfaceType()
+{
+   Point3F pos = getPosition();
+   RayInfo rInfo;
+   disableCollision();
+   if (getContainer()->castRay(Point3F(pos.x, pos.y, pos.z + 0.2f), Point3F(pos.x, pos.y, pos.z - 0.2f), 0xffffffff, &rInfo))
+   {
+      enableCollision();
+      return rInfo.object->getTypeMask();;
+   }
+   else
+   {
+      enableCollision();
+      return DefaultObjectType;
+   }
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::worldBoxIsClear
+//
+// Returns true if there are no obstructions inside the given world space box
+//-------------------------------------------------------------------
+bool AAKPlayer::worldBoxIsClear(Box3F objSpaceBox, Point3F worldOffset)
+{
+   //this overload takes a box in object space and a world space offset
+   //convert objSpaceBox to a world space box by adding the offset
+   objSpaceBox.minExtents += worldOffset;
+   objSpaceBox.maxExtents += worldOffset;
+
+   return worldBoxIsClear(objSpaceBox);
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::worldBoxIsClear
+//
+// Returns true if there are no obstructions inside the given world space box
+//-------------------------------------------------------------------
+bool AAKPlayer::worldBoxIsClear(Box3F worldSpaceBox)
+{
+   return worldBoxIsClear(worldSpaceBox, sCollisionMoveMask);
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::worldBoxIsClear
+//
+// Returns true if no objects of typeMask obstruct the given world space
+// box. Results are remembered for the rest of the tick, see AAKProbeScratch
+//-------------------------------------------------------------------
+bool AAKPlayer::worldBoxIsClear(const Box3F& worldSpaceBox, U32 typeMask)
+{
+   bool isClear;
+   if (AAKProbeScratch::get().findBoxQuery(worldSpaceBox, typeMask, &isClear))
+      return isClear;
+
+   AAKScratchPolyList<EarlyOutPolyList> scratchList;
+   EarlyOutPolyList& polyList = *scratchList;
+   polyList.mNormal.set(0.0f, 0.0f, 0.0f);
+   polyList.mPlaneList.clear();
+   polyList.mPlaneList.setSize(6);
+   polyList.mPlaneList[0].set(worldSpaceBox.minExtents, VectorF(-1.0f, 0.0f, 0.0f));
+   polyList.mPlaneList[1].set(worldSpaceBox.maxExtents, VectorF(0.0f, 1.0f, 0.0f));
+   polyList.mPlaneList[2].set(worldSpaceBox.maxExtents, VectorF(1.0f, 0.0f, 0.0f));
+   polyList.mPlaneList[3].set(worldSpaceBox.minExtents, VectorF(0.0f, -1.0f, 0.0f));
+   polyList.mPlaneList[4].set(worldSpaceBox.minExtents, VectorF(0.0f, 0.0f, -1.0f));
+   polyList.mPlaneList[5].set(worldSpaceBox.maxExtents, VectorF(0.0f, 0.0f, 1.0f));
+
+   //is there geometry in the way?
+   disableCollision();
+   isClear = !getContainer()->buildPolyList(PLC_Collision, worldSpaceBox, typeMask, &polyList);
+   enableCollision();
+
+   AAKProbeScratch::get().addBoxQuery(worldSpaceBox, typeMask, isClear);
+
+#ifdef ENABLE_DEBUGDRAW
+   if (sRenderHelpers)
+   {
+      LinearColorF color;
+      if (isClear)
+         color = LinearColorF(0, 1, 0);
+      else
+         color = LinearColorF(1, 0, 0);
+
+      DebugDrawer::get()->drawBox(worldSpaceBox.minExtents, worldSpaceBox.maxExtents, color);
+      DebugDrawer::get()->setLastTTL(TickMs);
+   }
+#endif
+
+   return isClear;
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::updateSounds
+//
+// Update all our player sound effects
+//-------------------------------------------------------------------
+void AAKPlayer::updateSounds(F32 dt)
+{
+   //turn on/off slide sounds
+   if (mSlideSound)
+   {
+      if ((mSlideState.active || mStoppingTimer > 16)
+         && (mRunSurface || mSlideSurface)
+         && mVelocity.len() > 0.01f)
+      {
+         if (!mSlideSound->isPlaying())
+            mSlideSound->play();
+
+         //set volume and pitch based on speed
+         F32 speedFactor = mVelocity.len() / 16.0f;
+         speedFactor = mClampF(speedFactor, 0, 1);
+
+         F32 volume = speedFactor;
+         F32 pitch = (0.75f * (1.0f - speedFactor)) + (1.25f * speedFactor); //map (0 - 1) to (0.75 - 1.25)
+
+         mSlideSound->setVolume(volume);
+         mSlideSound->setPitch(pitch);
+         mSlideSound->setTransform(getRenderTransform());
+         mSlideSound->setVelocity(mVelocity);
+      }
+      else if (mSlideSound->isPlaying())
+         mSlideSound->pause();
+   }
+
+   //Ubiq: moved here from updateWaterSounds()
+   if (mWaterCoverage < 1.0f || mDamageState != Enabled)
+   {
+      // Stop everything
+      if (mMoveBubbleSound)
+         mMoveBubbleSound->stop();
+      if (mWaterBreathSound)
+         mWaterBreathSound->stop();
+      return;
+   }
+
+   if (mMoveBubbleSound)
+   {
+      // We're under water and still alive, so let's play something
+      if (mVelocity.len() > 1.0f)
+      {
+         if (!mMoveBubbleSound->isPlaying())
+            mMoveBubbleSound->play();
+
+         mMoveBubbleSound->setTransform(getTransform());
+      }
+      else
+         mMoveBubbleSound->stop();
+   }
+
+   if (mWaterBreathSound)
+   {
+      if (!mWaterBreathSound->isPlaying())
+         mWaterBreathSound->play();
+
+      mWaterBreathSound->setTransform(getTransform());
+   }
 }
 
-//----------------------------------------------------------------------------
-void AAKPlayer::consoleInit()
+//-------------------------------------------------------------------
+// Probe helpers
+//
+// Terrain and baked shapes (see AAKNavData) skip the polylists used by
+// the climb, wall hug and ledge probes. Their surfaces go through the
+// same tests and weighting as polygons do, using the helpers below.
+//-------------------------------------------------------------------
+
+//the fraction of bounds inside box, per axis so that flat bounds work
+static F32 getBoxOverlapFraction(const Box3F& bounds, const Box3F& box)
 {
-   Con::addVariable("$AAKPlayer::renderMyPlayer",TypeBool, &sRenderMyPlayer,
-      "@brief Determines if the player is rendered or not.\n\n"
-      "Used on the client side to disable the rendering of all AAKPlayer objects.  This is "
-      "mainly for the tools or debugging.\n"
-	   "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::renderMyItems",TypeBool, &sRenderMyItems,
-      "@brief Determines if mounted shapes are rendered or not.\n\n"
-      "Used on the client side to disable the rendering of all AAKPlayer mounted objects.  This is "
-      "mainly used for the tools or debugging.\n"
-	   "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::renderCollision", TypeBool, &sRenderPlayerCollision, 
-      "@brief Determines if the player's collision mesh should be rendered.\n\n"
-      "This is mainly used for the tools and debugging.\n"
-	   "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::renderHelpers", TypeBool, &sRenderHelpers,
-      "@brief Determines if the player's nodes, mantle-able geometry et al should be rendered.\n\n"
-      "This is mainly used for the tools and debugging.\n"
-      "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::minWarpTicks",TypeF32,&sMinWarpTicks, 
-      "@brief Fraction of tick at which instant warp occures on the client.\n\n"
-	   "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::maxWarpTicks",TypeS32,&sMaxWarpTicks, 
-      "@brief When a warp needs to occur due to the client being too far off from the server, this is the "
-      "maximum number of ticks we'll allow the client to warp to catch up.\n\n"
-	   "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::maxPredictionTicks",TypeS32,&sMaxPredictionTicks, 
-      "@brief Maximum number of ticks to predict on the client from the last known move obtained from the server.\n\n"
-	   "@ingroup GameObjects\n");
+	F32 fraction = 1.0f;
+	for (U32 i = 0; i < 3; i++)
+	{
+		F32 overlap = getMin(bounds.maxExtents[i], box.maxExtents[i]) - getMax(bounds.minExtents[i], box.minExtents[i]);
+		if (overlap < 0.0f)
+			return 0.0f;
+
+		F32 len = bounds.maxExtents[i] - bounds.minExtents[i];
+		if (len > 0.001f)
+			fraction *= overlap / len;
+	}
+	return fraction;
+}
+
+//adds a surface to a climb/wall plane average if it's nearly vertical
+//and faces the player
+static void addWallPatch(const PlaneF& surfacePlane, F32 area, const Point3F& forward, PlaneF* plane, F32* totalWeight)
+{
+	if (mFabs(surfacePlane.z) >= 0.2f || mDot(surfacePlane, forward) >= -0.5f || area <= 0.0f)
+		return;
+
+	*totalWeight += area;
+	*plane += surfacePlane * area;
+	plane->d += surfacePlane.d * area;
+}
+
+//adds an edge between an upward-facing surface and its neighbour to the
+//ledge average if it passes the ledge tests, returns true if it was added
+static bool addLedgeEdge(const Box3F& wBox, const Point3F& forward,
+	const Point3F& vertex1, const Point3F& vertex2, const Point3F& polyNormal, const Point3F& adjPolyNormal,
+	VectorF* ledgeNormal, Point3F* ledgePoint, F32* totalWeight, bool* canMoveLeft, bool* canMoveRight)
+{
+	//is player facing this edge?
+	Point3F normal = mCross(Point3F(0,0,1), vertex2 - vertex1);
+	normal.normalizeSafe();
+	if (mDot(forward, normal) > 0)
+		return false;
+
+	//does the edge normal face the player?
+	Point3F edgeNormal = (polyNormal + adjPolyNormal) / 2.0f;
+	if (mDot(edgeNormal, forward) > -0.2f)
+		return false;
+
+	//is this a "significant edge"?
+	if (mDot(polyNormal, adjPolyNormal) > 0.1f)
+		return false;
+
+	//does this edge pass through our box? (from both directions)
+	F32 t1; Point3F n1;
+	F32 t2; Point3F n2;
+	if (!wBox.collideLine(vertex1, vertex2, &t1, &n1) || !wBox.collideLine(vertex2, vertex1, &t2, &n2))
+		return false;
+
+	Point3F collisionPoint1, collisionPoint2;
+	collisionPoint1.interpolate(vertex1, vertex2, t1);
+	collisionPoint2.interpolate(vertex2, vertex1, t2);
+
+	//weight by the length inside the box
+	F32 weight = (collisionPoint1 - collisionPoint2).len();
+	Point3F collisionPoint = (collisionPoint1 + collisionPoint2) / 2.0f;
+
+	*totalWeight += weight;
+	*ledgeNormal += normal * weight;
+	*ledgePoint += collisionPoint * weight;
+	*canMoveLeft = *canMoveLeft || !wBox.isContained(vertex2);
+	*canMoveRight = *canMoveRight || !wBox.isContained(vertex1);
+
+	#ifdef ENABLE_DEBUGDRAW
+	if (sRenderHelpers)
+	{
+		DebugDrawer::get()->drawLine(vertex1, vertex2, LinearColorF(1.0f, 0.0f, 0.5f));
+		DebugDrawer::get()->setLastTTL(TickMs);
+	}
+	#endif
+
+	return true;
+}
+
+//-------------------------------------------------------------------
+// LedgeSweep
+//
+// The ledge grab zone moves down by 'drop' over a tick. Rather than
+// testing every edge in the box stretched over the whole fall, edges
+// are collected with the time (0 - 1) the zone first reaches them, and
+// only the earliest get the adjacency search and full edge tests.
+//-------------------------------------------------------------------
+struct LedgeSweep
+{
+	enum { MaxCandidates = 64 };
+
+	struct Candidate
+	{
+		Point3F vertex1, vertex2;
+		Point3F polyNormal, adjPolyNormal;
+		S32 polyIndex;		//polylist polygon whose neighbour is still to be found, -1 if adjPolyNormal is known
+		F32 t;				//when the zone reaches the edge
+	};
+
+	Box3F box;				//grab zone at the start of the tick
+	F32 drop;				//distance the zone moves down over the tick
+	Box3F sweptBox;			//everything the zone passes through
+	Point3F forward;
+
+	Candidate candidates[MaxCandidates];
+	U32 count;
+
+	LedgeSweep(const Box3F& grabBox, F32 dropDist, const Point3F& fwd);
+	bool getCrossing(const Point3F& vertex1, const Point3F& vertex2, F32* t) const;
+	void add(const Point3F& vertex1, const Point3F& vertex2, const Point3F& polyNormal, const Point3F* adjPolyNormal, S32 polyIndex);
+	Box3F getBoxAt(const Point3F& vertex1, const Point3F& vertex2) const;
+	void resolve(ConcretePolyList* polyList, VectorF* ledgeNormal, Point3F* ledgePoint, F32* totalWeight, bool* canMoveLeft, bool* canMoveRight);
+};
+
+//edges reached within this distance of the first ledge found are averaged with it
+static const F32 sLedgeSweepTolerance = 0.1f;
+
+LedgeSweep::LedgeSweep(const Box3F& grabBox, F32 dropDist, const Point3F& fwd)
+{
+	box = grabBox;
+	drop = getMax(dropDist, 0.0f);
+	sweptBox = grabBox;
+	sweptBox.minExtents.z -= drop;
+	forward = fwd;
+	count = 0;
+}
+
+//when does the zone first reach this edge?
+bool LedgeSweep::getCrossing(const Point3F& vertex1, const Point3F& vertex2, F32* t) const
+{
+	//clip the edge to the zone's footprint, which doesn't change
+	F32 s0 = 0.0f, s1 = 1.0f;
+	Point3F dir = vertex2 - vertex1;
+	for (U32 i = 0; i < 2; i++)
+	{
+		if (mFabs(dir[i]) < 0.0001f)
+		{
+			if (vertex1[i] < box.minExtents[i] || vertex1[i] > box.maxExtents[i])
+				return false;
+			continue;
+		}
+
+		F32 a = (box.minExtents[i] - vertex1[i]) / dir[i];
+		F32 b = (box.maxExtents[i] - vertex1[i]) / dir[i];
+		s0 = getMax(s0, getMin(a, b));
+		s1 = getMin(s1, getMax(a, b));
+		if (s0 > s1)
+			return false;
+	}
+
+	F32 z0 = vertex1.z + dir.z * s0;
+	F32 z1 = vertex1.z + dir.z * s1;
+	F32 top = getMax(z0, z1);
+	F32 bottom = getMin(z0, z1);
+
+	//the bottom of the zone reaches the top of the edge first
+	F32 distance = getMax(box.minExtents.z - top, 0.0f);
+	if (distance > drop)
+		return false;
+
+	//and the edge mustn't be above the zone at that point
+	if (bottom > box.maxExtents.z - distance)
+		return false;
+
+	*t = drop > 0.0f ? distance / drop : 0.0f;
+	return true;
+}
+
+void LedgeSweep::add(const Point3F& vertex1, const Point3F& vertex2, const Point3F& polyNormal, const Point3F* adjPolyNormal, S32 polyIndex)
+{
+	//quick test: is player facing this edge?
+	Point3F normal = mCross(Point3F(0,0,1), vertex2 - vertex1);
+	if (mDot(forward, normal) > 0)
+		return;
+
+	//if the neighbour is known, reject edges addLedgeEdge would
+	if (adjPolyNormal)
+	{
+		if (mDot((polyNormal + *adjPolyNormal) / 2.0f, forward) > -0.2f || mDot(polyNormal, *adjPolyNormal) > 0.1f)
+			return;
+	}
+
+	F32 t;
+	if (!getCrossing(vertex1, vertex2, &t))
+		return;
+
+	//when full, replace the latest candidate
+	U32 index = count;
+	if (count == MaxCandidates)
+	{
+		index = 0;
+		for (U32 i = 1; i < count; i++)
+			if (candidates[i].t > candidates[index].t)
+				index = i;
+
+		if (candidates[index].t <= t)
+			return;
+	}
+	else
+		count++;
+
+	Candidate& c = candidates[index];
+	c.vertex1 = vertex1;
+	c.vertex2 = vertex2;
+	c.polyNormal = polyNormal;
+	c.adjPolyNormal = adjPolyNormal ? *adjPolyNormal : Point3F::Zero;
+	c.polyIndex = adjPolyNormal ? -1 : polyIndex;
+	c.t = t;
+
+	AAKProbeScratch::get().mLedgeCandidates++;
+}
+
+//the zone at the point it's centred on the edge (as near as the sweep allows)
+Box3F LedgeSweep::getBoxAt(const Point3F& vertex1, const Point3F& vertex2) const
+{
+	F32 midZ = (vertex1.z + vertex2.z) * 0.5f;
+	F32 offset = drop > 0.0f ? mClampF(box.getCenter().z - midZ, 0.0f, drop) : 0.0f;
+
+	Box3F result = box;
+	result.minExtents.z -= offset;
+	result.maxExtents.z -= offset;
+	return result;
+}
+
+//runs the full edge tests on the earliest candidates until a ledge is found
+void LedgeSweep::resolve(ConcretePolyList* polyList, VectorF* ledgeNormal, Point3F* ledgePoint, F32* totalWeight, bool* canMoveLeft, bool* canMoveRight)
+{
+	//earliest first
+	for (U32 i = 1; i < count; i++)
+	{
+		Candidate c = candidates[i];
+		S32 j = i - 1;
+		for (; j >= 0 && candidates[j].t > c.t; j--)
+			candidates[j + 1] = candidates[j];
+		candidates[j + 1] = c;
+	}
+
+	F32 tolerance = drop > 0.0f ? sLedgeSweepTolerance / drop : 1.0f;
+	F32 foundT = -1.0f;
+
+	for (U32 i = 0; i < count; i++)
+	{
+		Candidate& c = candidates[i];
+		if (foundT >= 0.0f && c.t > foundT + tolerance)
+			break;
+
+		//find the polygon on the other side of this edge
+		if (c.polyIndex >= 0)
+		{
+			AAKProbeScratch::get().mLedgeAdjacencySearches++;
+
+			U32 adjPolyIndex;
+			if (!AAKPlayer::findAdjacentPoly(polyList, c.vertex1, c.vertex2, c.polyIndex, &adjPolyIndex))
+				continue;
+
+			c.adjPolyNormal = polyList->mPolyList[adjPolyIndex].plane;
+		}
+
+		if (addLedgeEdge(getBoxAt(c.vertex1, c.vertex2), forward, c.vertex1, c.vertex2, c.polyNormal, c.adjPolyNormal,
+			ledgeNormal, ledgePoint, totalWeight, canMoveLeft, canMoveRight) && foundT < 0.0f)
+		{
+			foundT = c.t;
+		}
+	}
+}
+
+//terrain and baked shapes are made of several convexes in the working
+//list, so the probes remember which objects they have already handled
+struct ProbeObjectSet
+{
+	enum { MaxObjects = 8 };
+
+	SceneObject* objects[MaxObjects];
+	bool handled[MaxObjects];	//false if the object fell back to polygons
+	U32 count;
+
+	ProbeObjectSet() : count(0) {}
+
+	S32 find(SceneObject* obj) const
+	{
+		for (U32 i = 0; i < count; i++)
+			if (objects[i] == obj)
+				return i;
+		return -1;
+	}
+
+	S32 add(SceneObject* obj, bool wasHandled)
+	{
+		objects[count] = obj;
+		handled[count] = wasHandled;
+		return count++;
+	}
+
+	//returns true if this convex is already covered by its object
+	bool isHandled(S32 index) const { return index >= 0 && handled[index]; }
+	bool isFull() const { return count >= MaxObjects; }
+};
+
+//-------------------------------------------------------------------
+// Terrain probes
+//
+// TerrainBlock is a regular heightfield, so rather than collecting its
+// triangles into a polylist (each terrain square is a separate convex)
+// and searching them for shared edges, the probes read the grid heights
+// around the probe box and find steep cells and cliff-top edges from
+// neighbouring heights.
+//-------------------------------------------------------------------
+struct TerrainProbeGrid
+{
+	enum { MaxPoints = 24 };	//max grid points per side, larger probes fall back to polygons
+
+	Point2F origin;				//world position of grid point (0,0)
+	F32 squareSize;
+	S32 sizeX, sizeY;			//grid points sampled along x & y
+	F32 height[MaxPoints][MaxPoints];	//world space height of each grid point
+	bool valid[MaxPoints][MaxPoints];	//false for empty or off-terrain points
+
+	bool sample(TerrainBlock* terrain, const Box3F& box, S32 border);
+	bool getCell(S32 x, S32 y, Point3F* normal, F32* area, Box3F* bounds) const;
+
+	Point3F getPoint(S32 x, S32 y) const
+	{
+		return Point3F(origin.x + x * squareSize, origin.y + y * squareSize, height[x][y]);
+	}
+};
+
+//sample the grid points covering the box, plus border squares on each side
+bool TerrainProbeGrid::sample(TerrainBlock* terrain, const Box3F& box, S32 border)
+{
+	const Point3F& terrainPos = terrain->getPosition();
+	squareSize = terrain->getSquareSize();
+
+	S32 x0 = (S32)mFloor((box.minExtents.x - terrainPos.x) / squareSize) - border;
+	S32 y0 = (S32)mFloor((box.minExtents.y - terrainPos.y) / squareSize) - border;
+	S32 x1 = (S32)mFloor((box.maxExtents.x - terrainPos.x) / squareSize) + 1 + border;
+	S32 y1 = (S32)mFloor((box.maxExtents.y - terrainPos.y) / squareSize) + 1 + border;
+
+	sizeX = x1 - x0 + 1;
+	sizeY = y1 - y0 + 1;
+	if (sizeX > MaxPoints || sizeY > MaxPoints)
+		return false;
+
+	origin.set(terrainPos.x + x0 * squareSize, terrainPos.y + y0 * squareSize);
+
+	for (S32 x = 0; x < sizeX; x++)
+	{
+		for (S32 y = 0; y < sizeY; y++)
+		{
+			//getHeight works in terrain space
+			Point2F gridPos((x0 + x) * squareSize, (y0 + y) * squareSize);
+			F32 h = 0.0f;
+			valid[x][y] = terrain->getHeight(gridPos, &h);
+			height[x][y] = h + terrainPos.z;
+		}
+	}
+
+	return true;
+}
+
+//get the normal, surface area and bounds of the cell at (x,y)
+bool TerrainProbeGrid::getCell(S32 x, S32 y, Point3F* normal, F32* area, Box3F* bounds) const
+{
+	if (x < 0 || y < 0 || x + 1 >= sizeX || y + 1 >= sizeY)
+		return false;
+
+	if (!valid[x][y] || !valid[x + 1][y] || !valid[x][y + 1] || !valid[x + 1][y + 1])
+		return false;
+
+	//the cross product of the diagonals is the averaged normal of the
+	//cell's two triangles, scaled by twice the cell's area
+	Point3F diag1 = getPoint(x + 1, y + 1) - getPoint(x, y);
+	Point3F diag2 = getPoint(x, y + 1) - getPoint(x + 1, y);
+	mCross(diag1, diag2, normal);
+	*area = normal->len() * 0.5f;
+	normal->normalizeSafe();
+
+	bounds->minExtents = getPoint(x, y);
+	bounds->maxExtents = getPoint(x, y);
+	bounds->extend(getPoint(x + 1, y));
+	bounds->extend(getPoint(x, y + 1));
+	bounds->extend(getPoint(x + 1, y + 1));
+
+	return true;
+}
+
+//-------------------------------------------------------------------
+// findTerrainWallPlanes
+//
+// Accumulates the nearly vertical terrain cells facing the player inside
+// wBox. Returns false if the box is too large to sample, in which case
+// the terrain's polygons should be used. addTerrainWallPlanes does the
+// same for a grid that has already been sampled.
+//-------------------------------------------------------------------
+static void addTerrainWallPlanes(const TerrainProbeGrid& grid, const Box3F& wBox, const Point3F& forward, PlaneF* plane, F32* totalWeight)
+{
+	for (S32 x = 0; x < grid.sizeX - 1; x++)
+	{
+		for (S32 y = 0; y < grid.sizeY - 1; y++)
+		{
+			Point3F normal; F32 area; Box3F bounds;
+			if (!grid.getCell(x, y, &normal, &area, &bounds))
+				continue;
 
-   Con::addVariable("$AAKPlayer::maxImpulseVelocity", TypeF32, &sMaxImpulseVelocity, 
-      "@brief The maximum velocity allowed due to a single impulse.\n\n"
-	   "@ingroup GameObjects\n");
+			Point3F center = (grid.getPoint(x, y) + grid.getPoint(x + 1, y) +
+				grid.getPoint(x, y + 1) + grid.getPoint(x + 1, y + 1)) * 0.25f;
 
-   // Move triggers
-   Con::addVariable("$AAKPlayer::jumpTrigger", TypeS32, &sJumpTrigger, 
-      "@brief The move trigger index used for player jumping.\n\n"
-	   "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::crouchTrigger", TypeS32, &sCrouchTrigger, 
-      "@brief The move trigger index used for player crouching.\n\n"
-	   "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::proneTrigger", TypeS32, &sProneTrigger, 
-      "@brief The move trigger index used for player prone pose.\n\n"
-	   "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::sprintTrigger", TypeS32, &sSprintTrigger, 
-      "@brief The move trigger index used for player sprinting.\n\n"
-	   "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::imageTrigger0", TypeS32, &sImageTrigger0, 
-      "@brief The move trigger index used to trigger mounted image 0.\n\n"
-	   "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::imageTrigger1", TypeS32, &sImageTrigger1, 
-      "@brief The move trigger index used to trigger mounted image 1 or alternate fire "
-      "on mounted image 0.\n\n"
-	   "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::jumpJetTrigger", TypeS32, &sJumpJetTrigger, 
-      "@brief The move trigger index used for player jump jetting.\n\n"
-	   "@ingroup GameObjects\n");
-   Con::addVariable("$AAKPlayer::vehicleDismountTrigger", TypeS32, &sVehicleDismountTrigger, 
-      "@brief The move trigger index used to dismount player.\n\n"
-	   "@ingroup GameObjects\n");
+			//only count the part of the cell inside the box, the same
+			//area the clipped polylist would measure
+			addWallPatch(PlaneF(center, normal), area * getBoxOverlapFraction(bounds, wBox), forward, plane, totalWeight);
+		}
+	}
+}
 
-   //Ubiq: TODO: add documentation strings
-   addField("climbTriggerCount", TypeS32, Offset(mClimbTriggerCount, AAKPlayer), "");
-   addField("dieOnNextCollision", TypeBool, Offset(mDieOnNextCollision, AAKPlayer), "");
-   afx_consoleInit();
+static bool findTerrainWallPlanes(TerrainBlock* terrain, const Box3F& wBox, const Point3F& forward, PlaneF* plane, F32* totalWeight)
+{
+	TerrainProbeGrid grid;
+	if (!grid.sample(terrain, wBox, 0))
+		return false;
+
+	addTerrainWallPlanes(grid, wBox, forward, plane, totalWeight);
+	return true;
 }
 
-void AAKPlayer::initPersistFields()
+//-------------------------------------------------------------------
+// findTerrainLedges
+//
+// Collects cliff-top edges in the sweep: an upward-facing cell next to
+// a cell whose normal differs enough to make a "significant" edge.
+// Neighbours come straight from the grid instead of findAdjacentPoly.
+// Returns false if the swept box is too large to sample.
+// addTerrainLedges works on a grid that has already been sampled.
+//-------------------------------------------------------------------
+static void addTerrainLedges(const TerrainProbeGrid& grid, LedgeSweep* sweep)
 {
-   addField("inWater", TypeBool, Offset(mInWater, AAKPlayer),
-      "@brief script exposure of inWater state.");
-   addField("isFalling", TypeBool, Offset(mFalling, AAKPlayer),
-      "@brief script exposure of falling state.");
-   addField("isRunSurface", TypeBool, Offset(mRunSurface, AAKPlayer),
-      "@brief script exposure of runSurface state.");
+	//the four edges of a cell: the offset to the neighbouring cell, and
+	//the edge verticies wound so the edge normal points at that neighbour
+	static const struct { S32 dx, dy, v1x, v1y, v2x, v2y; } sCellEdges[4] =
+	{
+		{ -1,  0,   0, 0,   0, 1 },
+		{  1,  0,   1, 1,   1, 0 },
+		{  0, -1,   1, 0,   0, 0 },
+		{  0,  1,   0, 1,   1, 1 },
+	};
 
-   Parent::initPersistFields();
+	for (S32 x = 0; x < grid.sizeX - 1; x++)
+	{
+		for (S32 y = 0; y < grid.sizeY - 1; y++)
+		{
+			Point3F polyNormal; F32 area; Box3F bounds;
+			if (!grid.getCell(x, y, &polyNormal, &area, &bounds))
+				continue;
+
+			//upward-facing surface?
+			if (polyNormal.z <= 0.9f)
+				continue;
+
+			for (U32 e = 0; e < 4; e++)
+			{
+				Point3F adjPolyNormal;
+				if (!grid.getCell(x + sCellEdges[e].dx, y + sCellEdges[e].dy, &adjPolyNormal, &area, &bounds))
+					continue;
+
+				Point3F vertex1 = grid.getPoint(x + sCellEdges[e].v1x, y + sCellEdges[e].v1y);
+				Point3F vertex2 = grid.getPoint(x + sCellEdges[e].v2x, y + sCellEdges[e].v2y);
+
+				sweep->add(vertex1, vertex2, polyNormal, &adjPolyNormal, -1);
+			}
+		}
+	}
 }
 
-//-----------------------------------------------------------------------------
+static bool findTerrainLedges(TerrainBlock* terrain, LedgeSweep* sweep)
+{
+	//one extra square around the box so neighbouring cells can be tested
+	TerrainProbeGrid grid;
+	if (!grid.sample(terrain, sweep->sweptBox, 1))
+		return false;
 
-void AAKPlayer::playFootstepSound( bool triggeredLeft, Material* contactMaterial, SceneObject* contactObject )
+	addTerrainLedges(grid, sweep);
+	return true;
+}
+
+//-------------------------------------------------------------------
+// Baked shape probes
+//
+// TSStatics with a baked sidecar (see AAKNavData) are tested against
+// their precomputed patches and ledge edges. nav is NULL if the object
+// has no usable data, the probes then use its polygons.
+//-------------------------------------------------------------------
+static bool findNavWallPlanes(const AAKNavData* nav, const Box3F& wBox, const Point3F& forward, PlaneF* plane, F32* totalWeight)
 {
-   if (footfallSoundOverride > 0)
-      return;
-   MatrixF footMat = getTransform();
-   if( mWaterCoverage > 0.0 && mWaterCoverage < 1.0 )
-   {
-      if ( mWaterCoverage < mDataBlock->footSplashHeight )
-         SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootShallowSplash), &getTransform());
-      else
-         SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootWading), &getTransform());
-   }
+	if (!nav)
+		return false;
 
-   if (mWaterCoverage >= 1.0)
-   {
-	   if ( triggeredLeft )
-	   {
-         SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootUnderWater), &getTransform());
-         SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootBubbles), &getTransform());
-	   }
-   }
+	for (U32 i = 0; i < nav->mPatches.size(); i++)
+	{
+		const AAKNavData::Patch& patch = nav->mPatches[i];
+		if (wBox.isOverlapped(patch.bounds))
+			addWallPatch(patch.plane, patch.area * getBoxOverlapFraction(patch.bounds, wBox), forward, plane, totalWeight);
+	}
 
-   else if( contactMaterial && contactMaterial->isCustomFootstepSoundValid())
-   {
-      // Footstep sound defined on material.
-      //Ubiq: set volume and pitch based on player velocity (landing is always max volume)
-      F32 speedFactor = mLandState.active ? 1.0f : mVelocity.len()/mDataBlock->maxForwardSpeed;
-      speedFactor = mClampF(speedFactor, 0.3f, 1.0f);
-      
-      F32 volume = speedFactor;
-      F32 pitch = (0.85f * (1.0f - speedFactor)) + (1.15f * speedFactor); //map (0 - 1) to (0.85 - 1.15)
-      
-      SFXSource* source = SFX->createSource(contactMaterial->getCustomFootstepSoundProfile(), &footMat);
-      source->setVolume(volume);
-      source->setPitch(pitch);
-      source->play();
-      SFX->deleteWhenStopped(source);
-   }
-   else
-   {
-      S32 sound = -1;
-      if( contactMaterial && contactMaterial->mFootstepSoundId != -1 )
-         sound = contactMaterial->mFootstepSoundId;
-      else if( contactObject && contactObject->getTypeMask() & VehicleObjectType )
-         sound = 2;
+	return true;
+}
 
-      SFXSource* source = NULL;
-      switch (sound)
-      {
-      case 0: // Soft
-         source = SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootSoft), &getTransform());
-         break;
-      case 1: // Hard
-         source = SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootHard), &getTransform());
-         break;
-      case 2: // Metal
-         source = SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootMetal), &getTransform());
-         break;
-      case 3: // Snow
-         source = SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::FootSnow), &getTransform());
-         break;
-      }
+static bool findNavLedges(const AAKNavData* nav, LedgeSweep* sweep)
+{
+	if (!nav)
+		return false;
 
-      if (source)
-      {
-         F32 pitch = mRandF(0.5f, 1.5f);
-         source->setPitch(pitch);
-      }
-   }
+	for (U32 i = 0; i < nav->mLedges.size(); i++)
+	{
+		const AAKNavData::Ledge& ledge = nav->mLedges[i];
+
+		//upward-facing surface?
+		if (ledge.polyNormal.z <= 0.9f)
+			continue;
+
+		sweep->add(ledge.start, ledge.end, ledge.polyNormal, &ledge.adjNormal, -1);
+	}
+
+	return true;
 }
 
-void AAKPlayer::playImpactSound()
+//-------------------------------------------------------------------
+// AAKSpeculativeProbe
+//
+// Next tick's climb or ledge probe, run on a worker thread at the end of
+// this one ($AAKPlayer::asyncProbes). The probes run in updateMove before
+// the player moves, so next tick's probe input is the one the player has
+// now unless it turns, warps or is snapped to a surface first. The result
+// is only used if next tick's ProbeInput matches, otherwise the probe
+// runs as usual.
+//
+// The worker doesn't touch the container or the player, everything it
+// reads is gathered on the sim thread when the probe is issued: the
+// world space nav data of baked shapes and heights sampled from terrain.
+// Probes that would need an object's polygons aren't issued. Anything
+// that frees or rebuilds nav data waits for the workers first, see
+// AAKPlayer::waitForSpeculativeProbes.
+//-------------------------------------------------------------------
+class AAKSpeculativeProbe : public ThreadPool::WorkItem
 {
-   if( mWaterCoverage == 0.0f )
-   {
-      Point3F pos;
-      RayInfo rInfo;
-      MatrixF mat = getTransform();
-      mat.mulP(Point3F(mDataBlock->decalOffset,0.0f,0.0f), &pos);
+	typedef ThreadPool::WorkItem Parent;
 
-      if( gClientContainer.castRay( Point3F( pos.x, pos.y, pos.z + 0.01f ),
-                                    Point3F( pos.x, pos.y, pos.z - 2.0f ),
-                                    STATIC_COLLISION_TYPEMASK | VehicleObjectType,
-                                    &rInfo ) )
-      {
-         Material* material = ( rInfo.material ? dynamic_cast< Material* >( rInfo.material->getMaterial() ) : 0 );
+public:
+	enum { MaxSources = ProbeObjectSet::MaxObjects };
+	enum { MaxGrids = 2 };
 
-         if( material && material->isCustomImpactSoundValid())
-            SFX->playOnce( material->getCustomImpactSoundProfile(), &getTransform() );
-         else
-         {
-            S32 sound = -1;
-            if( material && material->mImpactSoundId )
-               sound = material->mImpactSoundId;
-            else if( rInfo.object->getTypeMask() & VehicleObjectType )
-               sound = 2; // Play metal;
+	AAKProbeCache::ProbeType mType;
+	AAKPlayer::ProbeInput mInput;
+	AAKProbeCache::Result mResult;
 
-            switch( sound )
-            {
-            case 0:
-               //Soft
-               SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::ImpactSoft), &getTransform());
-               break;
-            case 1:
-               //Hard
-               SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::ImpactHard), &getTransform());
-               break;
-            case 2:
-               //Metal
-               SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::ImpactMetal), &getTransform());
-               break;
-            case 3:
-               //Snow
-               SFX->playOnce(mDataBlock->getPlayerSoundProfile(AAKPlayerData::ImpactSnow), &getTransform());
-               break;
-               /*
-            default:
-               //Hard
-               alxPlay(mDataBlock->sound[AAKPlayerData::ImpactHard], &getTransform());
-               break;
-               */
-            }
-         }
-      }
-   }
+	struct Source
+	{
+		const AAKNavData* nav;	//baked shape, or
+		S32 grid;				//index into mGrids
+	};
+	Source mSources[MaxSources];
+	U32 mSourceCount;
+
+	TerrainProbeGrid mGrids[MaxGrids];
+	U32 mGridCount;
+
+	//the objects the sources came from, checked before the result is used
+	SimObjectId mObjectIds[MaxSources];
+	U32 mObjectStamps[MaxSources];
+	U32 mObjectCount;
+
+	volatile U32 mDone;				//set by the worker once mResult is ready
+	static volatile U32 smPending;	//queued or running probes
+
+	AAKSpeculativeProbe(AAKProbeCache::ProbeType type, const AAKPlayer::ProbeInput& input)
+		: mType(type), mInput(input), mSourceCount(0), mGridCount(0), mObjectCount(0), mDone(0) {}
+
+	void addObject(SceneObject* obj);
+	S32 findObject(SimObjectId id) const;
+	bool addNav(const AAKNavData* nav);
+	bool addTerrain(TerrainBlock* terrain, const Box3F& box, S32 border);
+	void queue();
+	bool isDone() { return dAtomicRead(mDone) != 0; }
+
+protected:
+	virtual void execute();
+	virtual void onCancelled();
+};
 
-   mImpactSound = 0;
+volatile U32 AAKSpeculativeProbe::smPending = 0;
+
+void AAKSpeculativeProbe::addObject(SceneObject* obj)
+{
+	if (mObjectCount == MaxSources)
+		return;
+
+	mObjectIds[mObjectCount] = obj->getId();
+	mObjectStamps[mObjectCount] = AAKProbeCache::getStamp(obj);
+	mObjectCount++;
 }
 
-//--------------------------------------------------------------------------
+S32 AAKSpeculativeProbe::findObject(SimObjectId id) const
+{
+	for (U32 i = 0; i < mObjectCount; i++)
+	{
+		if (mObjectIds[i] == id)
+			return i;
+	}
+	return -1;
+}
 
-void AAKPlayer::updateFroth( F32 dt )
+//shapes without usable nav data would need their polygons
+bool AAKSpeculativeProbe::addNav(const AAKNavData* nav)
 {
-   // update bubbles
-   Point3F moveDir = getVelocity();
-   mBubbleEmitterTime += dt;
+	if (!nav || mSourceCount == MaxSources)
+		return false;
 
-   if (mBubbleEmitterTime < mDataBlock->bubbleEmitTime) {
-      if (mSplashEmitter[AAKPlayerData::BUBBLE_EMITTER]) {
-         Point3F emissionPoint = getRenderPosition();
-         U32 emitNum = AAKPlayerData::BUBBLE_EMITTER;
-         mSplashEmitter[emitNum]->emitParticles(mLastPos, emissionPoint,
-            Point3F( 0.0, 0.0, 1.0 ), moveDir, (U32)(dt * 1000.0));
-      }
-   }
+	mSources[mSourceCount].nav = nav;
+	mSources[mSourceCount].grid = -1;
+	mSourceCount++;
+	return true;
+}
 
-   Point3F contactPoint;
-   if (!collidingWithWater(contactPoint)) {
-      mLastWaterPos = mLastPos;
-      return;
-   }
+bool AAKSpeculativeProbe::addTerrain(TerrainBlock* terrain, const Box3F& box, S32 border)
+{
+	if (mGridCount == MaxGrids || mSourceCount == MaxSources || !mGrids[mGridCount].sample(terrain, box, border))
+		return false;
 
-   F32 speed = moveDir.len();
-   if ( speed < mDataBlock->splashVelEpsilon ) 
-      speed = 0.0;
+	mSources[mSourceCount].nav = NULL;
+	mSources[mSourceCount].grid = mGridCount++;
+	mSourceCount++;
+	return true;
+}
+
+void AAKSpeculativeProbe::queue()
+{
+	dFetchAndAdd(smPending, 1);
+	ThreadPool::GLOBAL().queueWorkItem(this);
+}
+
+//the same accumulation as the probes, over the gathered sources
+void AAKSpeculativeProbe::execute()
+{
+	F32 totalWeight = 0.0f;
+
+	if (mType == AAKProbeCache::LedgeProbe)
+	{
+		LedgeSweep sweep(mInput.box, mInput.drop, mInput.forward);
+		for (U32 i = 0; i < mSourceCount; i++)
+		{
+			if (mSources[i].nav)
+				findNavLedges(mSources[i].nav, &sweep);
+			else
+				addTerrainLedges(mGrids[mSources[i].grid], &sweep);
+		}
 
-   U32 emitRate = (U32) (speed * mDataBlock->splashFreqMod * dt);
+		//every candidate already knows its neighbour, the list stays empty
+		AAKScratchPolyList<ConcretePolyList> polyList;
+		sweep.resolve(polyList.ptr(), &mResult.normal, &mResult.point, &totalWeight, &mResult.canMoveLeft, &mResult.canMoveRight);
 
-   // If we're in the water, swimming, but not
-   // moving, then lets emit some particles because
-   // we're treading water.  
-   //Ubiq: actually it looks kinda silly - removing
-   /*if ( mSwimming && speed == 0.0 )
-   {
-      emitRate = (U32) (2.0f * mDataBlock->splashFreqMod * dt);
-   }*/
+		if (totalWeight > 0)
+		{
+			mResult.found = true;
+			mResult.point /= totalWeight;
+			mResult.normal /= totalWeight;
+		}
+	}
+	else
+	{
+		for (U32 i = 0; i < mSourceCount; i++)
+		{
+			if (mSources[i].nav)
+				findNavWallPlanes(mSources[i].nav, mInput.box, mInput.forward, &mResult.plane, &totalWeight);
+			else
+				addTerrainWallPlanes(mGrids[mSources[i].grid], mInput.box, mInput.forward, &mResult.plane, &totalWeight);
+		}
 
-   U32 i;
-   for ( i=0; i<AAKPlayerData::BUBBLE_EMITTER; i++ ) {
-      if (mSplashEmitter[i] )
-         mSplashEmitter[i]->emitParticles( mLastWaterPos,
-            contactPoint, Point3F( 0.0, 0.0, 1.0 ),
-            moveDir, emitRate );
-   }
-   mLastWaterPos = contactPoint;
+		if (totalWeight > 0)
+		{
+			mResult.found = true;
+			mResult.plane /= totalWeight;
+			mResult.plane.d /= totalWeight;
+		}
+	}
+
+	dCompareAndSwap(mDone, 0, 1);
+	dFetchAndAdd(smPending, (U32)-1);
+}
+
+void AAKSpeculativeProbe::onCancelled()
+{
+	Parent::onCancelled();
+	dFetchAndAdd(smPending, (U32)-1);
 }
 
-//----------------------------------------------------------------------------
-// Ubiq custom
-//----------------------------------------------------------------------------
 //-------------------------------------------------------------------
-// AAKPlayer::getNodePosition
+// AAKPlayer::getProbeInput
 //
-// Returns the current world coordinates of the named node
+// Works out the probe box, facing and (for ledges) sweep distance a
+// probe of this type would use from the current transform. While the
+// probe cache is enabled the position and facing are snapped first, see
+// AAKProbeCache.
 //-------------------------------------------------------------------
-Point3F AAKPlayer::getNodePosition(const char *nodeName)
+void AAKPlayer::getProbeInput(AAKProbeCache::ProbeType type, ProbeInput* input)
 {
-   if (!mDataBlock || mDataBlock->shapeAssetRef.isNull())
-      return Point3F::Zero;
+	Point3F pos;
+	getTransform().getColumn(3, &pos);
+	getTransform().getColumn(1, &input->forward);
 
-   Resource<TSShape> shape = mDataBlock->shapeAssetRef.assetPtr->getShapeResource();
+	input->useCache = AAKProbeCache::isEnabled();
+	if (input->useCache)
+		AAKProbeCache::snapProbe(&pos, &input->forward, &input->cacheKey);
 
-	const MatrixF& mat = this->getTransform();
-	Point3F nodePoint;
-	MatrixF nodeMat;
-	S32 ni = shape->findNode(nodeName);
-	AssertFatal(ni >= 0, "ShapeBase::getNodePosition() - couldn't find node!");
-	nodeMat = mShapeInstance->mNodeTransforms[ni];
-	nodePoint = nodeMat.getPosition();
-	mat.mulP(nodePoint);
-	return nodePoint;
+	Box3F& wBox = input->box;
+	wBox = mObjBox;
+	Point3F offset(input->forward);
+	input->drop = 0.0f;
+
+	switch (type)
+	{
+	case AAKProbeCache::ClimbProbe:
+		offset.normalize(0.2f);
+		wBox.minExtents.z = mDataBlock->climbHeightMin;
+		wBox.maxExtents.z = mDataBlock->climbHeightMax;
+		break;
+
+	case AAKProbeCache::WallProbe:
+		offset.normalize(0.2f);
+		wBox.minExtents.z = mDataBlock->wallHugHeightMin;
+		wBox.maxExtents.z = mDataBlock->wallHugHeightMax;
+		break;
+
+	default:
+		offset.normalize(wBox.len_y());
+		wBox.minExtents.z = mDataBlock->grabHeightMin;
+		wBox.maxExtents.z = mDataBlock->grabHeightMax;
+		break;
+	}
+
+	wBox.minExtents += offset + pos;
+	wBox.maxExtents += offset + pos;
+
+	//the grab zone sweeps down over the tick and a box height further
+	if (type == AAKProbeCache::LedgeProbe)
+	{
+		input->drop = wBox.len_z() - mVelocity.z * TickSec;
+		if (input->useCache)
+			input->drop = AAKProbeCache::snapDistance(input->drop);
+	}
+
+	if (input->useCache)
+		input->cacheKey.set(type, isServerObject(), wBox, input->drop);
 }
 
 //-------------------------------------------------------------------
-// AAKPlayer::setObjectBox
+// AAKPlayer::issueSpeculativeProbes
 //
-// Sets the player object box / convex box from the one provided
+// Called at the end of the tick, starts next tick's climb and ledge
+// probes on a worker if the player will probably run them
 //-------------------------------------------------------------------
-void AAKPlayer::setObjectBox(Point3F size)
+void AAKPlayer::issueSpeculativeProbes()
 {
-   mObjBox = createObjectBox(size);
+	//workers can't draw the probe helpers
+	if (!sAsyncProbes || sRenderHelpers || isRemoteGhost())
+	{
+		releaseSpeculativeProbes();
+		return;
+	}
 
-   // Setup the box for our convex object...
-   mObjBox.getCenter(&mConvex.mCenter);
-   mConvex.mSize.x = mObjBox.len_x() / 2.0f;
-   mConvex.mSize.y = mObjBox.len_y() / 2.0f;
-   mConvex.mSize.z = mObjBox.len_z() / 2.0f;
+	static const AAKProbeCache::ProbeType sTypes[] = { AAKProbeCache::ClimbProbe, AAKProbeCache::LedgeProbe };
 
-   // Initialize our scaled attributes as well
-   onScaleChanged();
+	for (U32 i = 0; i < 2; i++)
+	{
+		AAKProbeCache::ProbeType type = sTypes[i];
+		AAKProbeScratch::Speculation& stats = AAKProbeScratch::get().mSpeculation[type];
+
+		//nothing asked for last tick's result
+		if (mSpeculativeProbes[type])
+		{
+			stats.unused++;
+			mSpeculativeProbes[type]->release();
+			mSpeculativeProbes[type] = NULL;
+		}
+
+		bool wanted = (type == AAKProbeCache::ClimbProbe)
+			? mClimbState.active || canStartClimb()
+			: mLedgeState.active || canStartLedgeGrab();
+		if (!wanted)
+			continue;
+
+		mSpeculativeProbes[type] = createSpeculativeProbe(type);
+		if (mSpeculativeProbes[type])
+		{
+			stats.issued++;
+			mSpeculativeProbes[type]->queue();
+		}
+		else
+			stats.skipped++;
+	}
 }
 
-//-------------------------------------------------------------------
-// AAKPlayer::createObjectBox
-//
-// Given a point (containing length, width & height) makes an object box
-//-------------------------------------------------------------------
-Box3F AAKPlayer::createObjectBox(Point3F size)
+//the objects a speculative probe of this type reads, NULL if obj isn't one
+static SceneObject* getSpeculativeSource(SceneObject* obj, AAKProbeCache::ProbeType type, TSStatic** st, TerrainBlock** terrain)
 {
-   Box3F returnBox;
-   returnBox.maxExtents.x = size.x * 0.5f;
-   returnBox.maxExtents.y = size.y * 0.5f;
-   returnBox.maxExtents.z = size.z;
-   returnBox.minExtents.x = -returnBox.maxExtents.x;
-   returnBox.minExtents.y = -returnBox.maxExtents.y;
-   returnBox.minExtents.z = 0.0f;
-   return returnBox;
+	if ((obj->getTypeMask() & StaticObjectType) == 0)
+		return NULL;
+
+	*st = dynamic_cast<TSStatic*>(obj);
+	*terrain = dynamic_cast<TerrainBlock*>(obj);
+	bool isShape = *st && (type == AAKProbeCache::LedgeProbe ? (*st)->allowPlayerLedgeGrab() : (*st)->allowPlayerClimb());
+	bool isTerrain = *terrain && (*terrain)->allowPlayerClimb();
+	return (isShape || isTerrain) ? obj : NULL;
 }
 
 //-------------------------------------------------------------------
-// AAKPlayer::getSurfaceType
+// AAKPlayer::createSpeculativeProbe
 //
-// Returns the type mask of the object the player is standing on
+// Gathers what a probe from the current transform would read from the
+// working list, the same objects the probe itself would handle. Returns
+// NULL if any of them would need its polygons.
 //-------------------------------------------------------------------
-U32 AAKPlayer::getSurfaceType()
+AAKSpeculativeProbe* AAKPlayer::createSpeculativeProbe(AAKProbeCache::ProbeType type)
 {
-   Point3F pos = getPosition();
-   RayInfo rInfo;
-   disableCollision();
-   if (getContainer()->castRay(Point3F(pos.x, pos.y, pos.z + 0.2f), Point3F(pos.x, pos.y, pos.z - 0.2f), 0xffffffff, &rInfo))
-   {
-      enableCollision();
-      return rInfo.object->getTypeMask();;
-   }
-   else
-   {
-      enableCollision();
-      return DefaultObjectType;
-   }
+	ProbeInput input;
+	getProbeInput(type, &input);
+
+	AAKSpeculativeProbe* probe = new AAKSpeculativeProbe(type, input);
+	probe->addRef();
+
+	//ledges sample terrain over the whole sweep, plus the neighbouring cells
+	Box3F sampleBox = input.box;
+	S32 border = 0;
+	if (type == AAKProbeCache::LedgeProbe)
+	{
+		sampleBox.minExtents.z -= getMax(input.drop, 0.0f);
+		border = 1;
+	}
+
+	ProbeObjectSet probedSet;
+	bool gathered = true;
+
+	CollisionWorkingList& rList = mConvex.getWorkingList();
+	for (CollisionWorkingList* pList = rList.wLink.mNext; gathered && pList != &rList; pList = pList->wLink.mNext)
+	{
+		TSStatic* st;
+		TerrainBlock* terrain;
+		SceneObject* obj = getSpeculativeSource(pList->mConvex->getObject(), type, &st, &terrain);
+		if (!obj || probedSet.find(obj) >= 0)
+			continue;
+
+		//the probe falls back to polygons once the set is full
+		if (probedSet.isFull())
+		{
+			gathered = false;
+			break;
+		}
+
+		gathered = terrain ? probe->addTerrain(terrain, sampleBox, border) : probe->addNav(AAKNavData::getPlaced(st));
+		probe->addObject(obj);
+		probedSet.add(obj, true);
+	}
+
+	if (!gathered)
+	{
+		probe->release();
+		return NULL;
+	}
+
+	return probe;
 }
 
 //-------------------------------------------------------------------
-// AAKPlayer::worldBoxIsClear
+// AAKPlayer::takeSpeculativeResult
 //
-// Returns true if there are no obstructions inside the given world space box
+// Returns true and fills in result if last tick's speculative probe of
+// this type has finished and was made for the same input
 //-------------------------------------------------------------------
-bool AAKPlayer::worldBoxIsClear(Box3F objSpaceBox, Point3F worldOffset)
+bool AAKPlayer::takeSpeculativeResult(AAKProbeCache::ProbeType type, const ProbeInput& input, AAKProbeCache::Result* result)
 {
-   //this overload takes a box in object space and a world space offset
-   //convert objSpaceBox to a world space box by adding the offset
-   objSpaceBox.minExtents += worldOffset;
-   objSpaceBox.maxExtents += worldOffset;
+	AAKSpeculativeProbe* probe = mSpeculativeProbes[type];
+	if (!probe)
+		return false;
+	mSpeculativeProbes[type] = NULL;
 
-   return worldBoxIsClear(objSpaceBox);
+	AAKProbeScratch::Speculation& stats = AAKProbeScratch::get().mSpeculation[type];
+	bool hit = false;
+
+	if (!probe->isDone())
+		stats.late++;
+	else if (!probe->mInput.matches(input) || !checkSpeculativeSources(probe))
+		stats.misses++;
+	else
+	{
+		*result = probe->mResult;
+		stats.hits++;
+		hit = true;
+	}
+
+	probe->release();
+	return hit;
 }
 
 //-------------------------------------------------------------------
-// AAKPlayer::worldBoxIsClear
+// AAKPlayer::checkSpeculativeSources
 //
-// Returns true if there are no obstructions inside the given world space box
+// The working list must hold the same objects, unmoved, as when the
+// probe was issued. Anything added, removed, moved or scaled since
+// drops the result (see also AAKProbeCache::isValid)
 //-------------------------------------------------------------------
-bool AAKPlayer::worldBoxIsClear(Box3F worldSpaceBox)
+bool AAKPlayer::checkSpeculativeSources(const AAKSpeculativeProbe* probe)
 {
-   EarlyOutPolyList polyList;
-   polyList.mNormal.set(0.0f, 0.0f, 0.0f);
-   polyList.mPlaneList.clear();
-   polyList.mPlaneList.setSize(6);
-   polyList.mPlaneList[0].set(worldSpaceBox.minExtents, VectorF(-1.0f, 0.0f, 0.0f));
-   polyList.mPlaneList[1].set(worldSpaceBox.maxExtents, VectorF(0.0f, 1.0f, 0.0f));
-   polyList.mPlaneList[2].set(worldSpaceBox.maxExtents, VectorF(1.0f, 0.0f, 0.0f));
-   polyList.mPlaneList[3].set(worldSpaceBox.minExtents, VectorF(0.0f, -1.0f, 0.0f));
-   polyList.mPlaneList[4].set(worldSpaceBox.minExtents, VectorF(0.0f, 0.0f, -1.0f));
-   polyList.mPlaneList[5].set(worldSpaceBox.maxExtents, VectorF(0.0f, 0.0f, 1.0f));
+	ProbeObjectSet seen;
 
-   //is there geometry in the way?
-   disableCollision();
-   bool isClear = !getContainer()->buildPolyList(PLC_Collision, worldSpaceBox, sCollisionMoveMask, &polyList);
-   enableCollision();
+	CollisionWorkingList& rList = mConvex.getWorkingList();
+	for (CollisionWorkingList* pList = rList.wLink.mNext; pList != &rList; pList = pList->wLink.mNext)
+	{
+		TSStatic* st;
+		TerrainBlock* terrain;
+		SceneObject* obj = getSpeculativeSource(pList->mConvex->getObject(), probe->mType, &st, &terrain);
+		if (!obj || seen.find(obj) >= 0)
+			continue;
 
-#ifdef ENABLE_DEBUGDRAW
-   if (sRenderHelpers)
-   {
-      LinearColorF color;
-      if (isClear)
-         color = LinearColorF(0, 1, 0);
-      else
-         color = LinearColorF(1, 0, 0);
+		S32 index = probe->findObject(obj->getId());
+		if (index < 0 || seen.isFull() || AAKProbeCache::getStamp(obj) != probe->mObjectStamps[index])
+			return false;
 
-      DebugDrawer::get()->drawBox(worldSpaceBox.minExtents, worldSpaceBox.maxExtents, color);
-      DebugDrawer::get()->setLastTTL(TickMs);
-   }
-#endif
+		seen.add(obj, true);
+	}
 
-   return isClear;
+	return seen.count == probe->mObjectCount;
+}
+
+void AAKPlayer::releaseSpeculativeProbes()
+{
+	for (U32 i = 0; i < AAKProbeCache::NumProbeTypes; i++)
+	{
+		if (mSpeculativeProbes[i])
+		{
+			mSpeculativeProbes[i]->release();
+			mSpeculativeProbes[i] = NULL;
+		}
+	}
+}
+
+void AAKPlayer::waitForSpeculativeProbes()
+{
+	while (dAtomicRead(AAKSpeculativeProbe::smPending) != 0)
+		Platform::sleep(1);
 }
 
 //-------------------------------------------------------------------
-// AAKPlayer::updateSounds
+// Camera stage
 //
-// Update all our player sound effects
+// Camera goals & followers tracking us are ticked by us once we've
+// moved (the same way a controller ticks its control object), so the
+// camera sees this tick's position rather than last tick's. Goals go
+// first, followers blend them afterwards
 //-------------------------------------------------------------------
-void AAKPlayer::updateSounds(F32 dt)
+void AAKPlayer::addCameraDependent(ShapeBase* obj, bool follower)
 {
-   //turn on/off slide sounds
-   if (mSlideSound)
-   {
-      if ((mSlideState.active || mStoppingTimer > 16)
-         && (mRunSurface || mSlideSurface)
-         && mVelocity.len() > 0.01f)
-      {
-         if (!mSlideSound->isPlaying())
-            mSlideSound->play();
+	Vector<SimObjectPtr<ShapeBase> >& list = follower ? mCameraFollowers : mCameraGoals;
+	for (S32 i = 0; i < list.size(); i++)
+	{
+		if (list[i] == obj)
+			return;
+	}
 
-         //set volume and pitch based on speed
-         F32 speedFactor = mVelocity.len() / 16.0f;
-         speedFactor = mClampF(speedFactor, 0, 1);
+	list.push_back(obj);
+	obj->setProcessTick(false);
+}
 
-         F32 volume = speedFactor;
-         F32 pitch = (0.75f * (1.0f - speedFactor)) + (1.25f * speedFactor); //map (0 - 1) to (0.75 - 1.25)
+void AAKPlayer::removeCameraDependent(ShapeBase* obj)
+{
+	for (S32 i = mCameraGoals.size() - 1; i >= 0; i--)
+	{
+		if (mCameraGoals[i] == obj)
+			mCameraGoals.erase(i);
+	}
+	for (S32 i = mCameraFollowers.size() - 1; i >= 0; i--)
+	{
+		if (mCameraFollowers[i] == obj)
+			mCameraFollowers.erase(i);
+	}
 
-         mSlideSound->setVolume(volume);
-         mSlideSound->setPitch(pitch);
-         mSlideSound->setTransform(getRenderTransform());
-         mSlideSound->setVelocity(mVelocity);
-      }
-      else if (mSlideSound->isPlaying())
-         mSlideSound->pause();
-   }
+	//a control object is still ticked by its controller
+	obj->setProcessTick(obj->getControllingObject() == NULL);
+}
 
-   //Ubiq: moved here from updateWaterSounds()
-   if (mWaterCoverage < 1.0f || mDamageState != Enabled)
-   {
-      // Stop everything
-      if (mMoveBubbleSound)
-         mMoveBubbleSound->stop();
-      if (mWaterBreathSound)
-         mWaterBreathSound->stop();
-      return;
-   }
+void AAKPlayer::releaseCameraDependents()
+{
+	for (S32 i = 0; i < mCameraGoals.size(); i++)
+	{
+		if (mCameraGoals[i])
+			mCameraGoals[i]->setProcessTick(mCameraGoals[i]->getControllingObject() == NULL);
+	}
+	for (S32 i = 0; i < mCameraFollowers.size(); i++)
+	{
+		if (mCameraFollowers[i])
+			mCameraFollowers[i]->setProcessTick(true);
+	}
 
-   if (mMoveBubbleSound)
-   {
-      // We're under water and still alive, so let's play something
-      if (mVelocity.len() > 1.0f)
-      {
-         if (!mMoveBubbleSound->isPlaying())
-            mMoveBubbleSound->play();
+	mCameraGoals.clear();
+	mCameraFollowers.clear();
+}
+
+void AAKPlayer::catchUpCameraGoal(ShapeBase* goal)
+{
+	//a goal that wakes once this tick's stage has run (from a follower's
+	//processTick, say) would be blended with its dormant transform until
+	//next tick, so evaluate it now
+	ProcessList* list = getProcessList();
+	if (list && list->getTotalTicks() == mCameraStageTick && isCameraGoal(goal))
+		goal->processTick(NULL);
+}
+
+bool AAKPlayer::isCameraGoal(const ShapeBase* obj) const
+{
+	for (S32 i = 0; i < mCameraGoals.size(); i++)
+	{
+		if (mCameraGoals[i] == obj)
+			return true;
+	}
+	return false;
+}
 
-         mMoveBubbleSound->setTransform(getTransform());
-      }
-      else
-         mMoveBubbleSound->stop();
-   }
+void AAKPlayer::updateCameraStage(const Move* controlMove)
+{
+	PROFILE_SCOPE(AAKPlayer_UpdateCameraStage);
 
-   if (mWaterBreathSound)
-   {
-      if (!mWaterBreathSound->isPlaying())
-         mWaterBreathSound->play();
+	//our control goal takes every move we do, replayed ones included
+	if (mControlObject && isCameraGoal(mControlObject))
+		mControlObject->processTick(controlMove);
 
-      mWaterBreathSound->setTransform(getTransform());
-   }
+	//everything else is evaluated once per tick, not again when the
+	//client replays its moves on us
+	U32 tick = getProcessList()->getTotalTicks();
+	if (tick == mCameraStageTick)
+		return;
+	mCameraStageTick = tick;
+
+	for (S32 i = 0; i < mCameraGoals.size(); i++)
+	{
+		ShapeBase* goal = mCameraGoals[i];
+		if (!goal)
+			mCameraGoals.erase(i--);
+		else if (goal != mControlObject)
+			goal->processTick(NULL);
+	}
+
+	for (S32 i = 0; i < mCameraFollowers.size(); i++)
+	{
+		ShapeBase* follower = mCameraFollowers[i];
+		if (!follower)
+			mCameraFollowers.erase(i--);
+		else
+			follower->processTick(NULL);
+	}
 }
 
 //-------------------------------------------------------------------
@@ -4479,20 +6639,22 @@ void AAKPlayer::findClimbContact(bool* climb, PlaneF* climbPlane)
 {
 	*climb = false;
 
-	Point3F pos;
-	getTransform().getColumn(3, &pos);
-
-	Point3F forward;
-	getTransform().getColumn(1, &forward);
+	ProbeInput input;
+	getProbeInput(AAKProbeCache::ClimbProbe, &input);
+	const Point3F& forward = input.forward;
+	const Box3F& wBox = input.box;
 
-	Box3F wBox = mObjBox;
-	Point3F offset(forward);
-	offset.normalize(0.2f);
-	wBox.minExtents.z = mDataBlock->climbHeightMin;
-	wBox.maxExtents.z = mDataBlock->climbHeightMax;
-	wBox.minExtents += offset + pos;
-	wBox.maxExtents += offset + pos;
+	//computed at the end of last tick, or shared by another player?
+	AAKProbeCache::Result cached;
+	if (takeSpeculativeResult(AAKProbeCache::ClimbProbe, input, &cached)
+		|| (input.useCache && AAKProbeCache::find(input.cacheKey, &cached)))
+	{
+		*climb = cached.found;
+		*climbPlane = cached.plane;
+		return;
+	}
 
+	AAKProbeCache::Sources cacheSources;
 
 #ifdef ENABLE_DEBUGDRAW
    if (sRenderHelpers)
@@ -4502,8 +6664,8 @@ void AAKPlayer::findClimbContact(bool* climb, PlaneF* climbPlane)
    }
 #endif
 
-	static ClippedPolyList polyList;
-	polyList.clear();
+	AAKScratchPolyList<ClippedPolyList> scratchList;
+	ClippedPolyList& polyList = *scratchList;
 	polyList.doConstruct();
 	polyList.mNormal.set(0.0f, 0.0f, 0.0f);
 
@@ -4516,6 +6678,9 @@ void AAKPlayer::findClimbContact(bool* climb, PlaneF* climbPlane)
 	polyList.mPlaneList[5].setXY(wBox.maxExtents, 1.0f);
 	Box3F plistBox = wBox;
 
+	*climbPlane = PlaneF(0,0,0,0); F32 totalWeight = 0.0f;
+	ProbeObjectSet probedSet;
+
 	// Build list from convex states here...
 	CollisionWorkingList& rList = mConvex.getWorkingList();
 	CollisionWorkingList* pList = rList.wLink.mNext;
@@ -4527,13 +6692,29 @@ void AAKPlayer::findClimbContact(bool* climb, PlaneF* climbPlane)
 		{
 			bool skip = true;
 
+			if (input.useCache && plistBox.isOverlapped(pConvex->getBoundingBox()))
+				cacheSources.add(pConvex->getObject());
+
 			TSStatic *st = dynamic_cast<TSStatic *> (pConvex->getObject());
 			if (st && st->allowPlayerClimb())
-				skip = false;
+			{
+				//baked shapes use their nav data, see AAKNavData
+				S32 index = probedSet.find(st);
+				if (index < 0 && !probedSet.isFull())
+					index = probedSet.add(st, findNavWallPlanes(AAKNavData::getPlaced(st), wBox, forward, climbPlane, &totalWeight));
+				skip = probedSet.isHandled(index);
+			}
 
+			//terrain is sampled directly, its polygons are only used if
+			//the probe box is too large for the heightfield path
 			TerrainBlock *terrain = dynamic_cast<TerrainBlock *> (pConvex->getObject());
 			if (terrain && terrain->allowPlayerClimb())
-				skip = false;
+			{
+				S32 index = probedSet.find(terrain);
+				if (index < 0 && !probedSet.isFull())
+					index = probedSet.add(terrain, findTerrainWallPlanes(terrain, wBox, forward, climbPlane, &totalWeight));
+				skip = probedSet.isHandled(index);
+			}
 
 			if(!skip)
 			{
@@ -4549,7 +6730,6 @@ void AAKPlayer::findClimbContact(bool* climb, PlaneF* climbPlane)
 	{
 		// Average the normals of all vertical-ish polygons together
 		// This allows the player to climb around beveled corners
-		*climbPlane = PlaneF(0,0,0,0); F32 totalWeight = 0.0f;
 		for (U32 p = 0; p < polyList.mPolyList.size(); p++)
 		{
 			//nearly vertical surface?
@@ -4589,20 +6769,40 @@ void AAKPlayer::findClimbContact(bool* climb, PlaneF* climbPlane)
 				}
 			}
 		}
-		if(totalWeight > 0)
-		{
-			*climb = true;
+	}
 
-			//divide to finish the weighted averages
-			*climbPlane /= totalWeight;
-			climbPlane->d /= totalWeight;
-		}
-		else
-		{
-			//we failed to find a suitable climb surface
-			*climb = false;
-		}
+	if(totalWeight > 0)
+	{
+		*climb = true;
+
+		//divide to finish the weighted averages
+		*climbPlane /= totalWeight;
+		climbPlane->d /= totalWeight;
+	}
+	else
+	{
+		//we failed to find a suitable climb surface
+		*climb = false;
 	}
+
+	if (input.useCache)
+	{
+		AAKProbeCache::Result result;
+		result.found = *climb;
+		result.plane = *climbPlane;
+		AAKProbeCache::insert(input.cacheKey, result, cacheSources);
+	}
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::updateClimbZones
+//
+// Counts the ClimbZones we're standing in. Remote ghosts get this in
+// the net state instead.
+//-------------------------------------------------------------------
+void AAKPlayer::updateClimbZones()
+{
+	mClimbZoneCount = ClimbZone::countZones(isServerObject(), getWorldBox());
 }
 
 //-------------------------------------------------------------------
@@ -4615,7 +6815,7 @@ bool AAKPlayer::canStartClimb()
 	return mState == MoveState && mDamageState == Enabled && !isMounted()
 		&& (mPose == StandPose || mPose == SprintPose)
 		&& !mDieOnNextCollision
-		&& mClimbTriggerCount > 0
+		&& inClimbArea()
 		&& mVelocity.z <= 0.1f
 		&& !mClimbState.ignoreClimb;
 }
@@ -4630,7 +6830,7 @@ bool AAKPlayer::canClimb()
 	return mState == MoveState && mDamageState == Enabled && !isMounted()
 		&& (mPose == StandPose || mPose == SprintPose)
 		&& !mDieOnNextCollision
-		&& mClimbTriggerCount > 0
+		&& inClimbArea()
 		&& !mClimbState.ignoreClimb;
 }
 
@@ -4643,20 +6843,22 @@ void AAKPlayer::findWallContact(bool* wall, PlaneF* wallPlane)
 {
 	*wall = false;
 
-	Point3F pos;
-	getTransform().getColumn(3, &pos);
-
-	Point3F forward;
-	getTransform().getColumn(1, &forward);
+	ProbeInput input;
+	getProbeInput(AAKProbeCache::WallProbe, &input);
+	const Point3F& forward = input.forward;
+	const Box3F& wBox = input.box;
 
-	Box3F wBox = mObjBox;
-	Point3F offset(forward);
-	offset.normalize(0.2f);
-	wBox.minExtents.z = mDataBlock->wallHugHeightMin;
-	wBox.maxExtents.z = mDataBlock->wallHugHeightMax;
-	wBox.minExtents += offset + pos;
-	wBox.maxExtents += offset + pos;
+	//computed at the end of last tick, or shared by another player?
+	AAKProbeCache::Result cached;
+	if (takeSpeculativeResult(AAKProbeCache::WallProbe, input, &cached)
+		|| (input.useCache && AAKProbeCache::find(input.cacheKey, &cached)))
+	{
+		*wall = cached.found;
+		*wallPlane = cached.plane;
+		return;
+	}
 
+	AAKProbeCache::Sources cacheSources;
 
 #ifdef ENABLE_DEBUGDRAW
    if (sRenderHelpers)
@@ -4666,8 +6868,8 @@ void AAKPlayer::findWallContact(bool* wall, PlaneF* wallPlane)
    }
 #endif
 
-	static ClippedPolyList polyList;
-	polyList.clear();
+	AAKScratchPolyList<ClippedPolyList> scratchList;
+	ClippedPolyList& polyList = *scratchList;
 	polyList.doConstruct();
 	polyList.mNormal.set(0.0f, 0.0f, 0.0f);
 
@@ -4680,6 +6882,9 @@ void AAKPlayer::findWallContact(bool* wall, PlaneF* wallPlane)
 	polyList.mPlaneList[5].setXY(wBox.maxExtents, 1.0f);
 	Box3F plistBox = wBox;
 
+	*wallPlane = PlaneF(0,0,0,0); F32 totalWeight = 0.0f;
+	ProbeObjectSet probedSet;
+
 	// Build list from convex states here...
 	CollisionWorkingList& rList = mConvex.getWorkingList();
 	CollisionWorkingList* pList = rList.wLink.mNext;
@@ -4691,13 +6896,29 @@ void AAKPlayer::findWallContact(bool* wall, PlaneF* wallPlane)
 		{
 			bool skip = true;
 
+			if (input.useCache && plistBox.isOverlapped(pConvex->getBoundingBox()))
+				cacheSources.add(pConvex->getObject());
+
 			TSStatic *st = dynamic_cast<TSStatic *> (pConvex->getObject());
 			if (st && st->allowPlayerWallHug())
-				skip = false;
+			{
+				//baked shapes use their nav data, see AAKNavData
+				S32 index = probedSet.find(st);
+				if (index < 0 && !probedSet.isFull())
+					index = probedSet.add(st, findNavWallPlanes(AAKNavData::getPlaced(st), wBox, forward, wallPlane, &totalWeight));
+				skip = probedSet.isHandled(index);
+			}
 
+			//terrain is sampled directly, its polygons are only used if
+			//the probe box is too large for the heightfield path
 			TerrainBlock *terrain = dynamic_cast<TerrainBlock *> (pConvex->getObject());
 			if (terrain && terrain->allowPlayerClimb())
-				skip = false;
+			{
+				S32 index = probedSet.find(terrain);
+				if (index < 0 && !probedSet.isFull())
+					index = probedSet.add(terrain, findTerrainWallPlanes(terrain, wBox, forward, wallPlane, &totalWeight));
+				skip = probedSet.isHandled(index);
+			}
 
 			if(!skip)
 			{
@@ -4713,7 +6934,6 @@ void AAKPlayer::findWallContact(bool* wall, PlaneF* wallPlane)
 	{
 		// Average the normals of all vertical polygons together
 		// This allows the player to wall hug around beveled corners
-		*wallPlane = PlaneF(0,0,0,0); F32 totalWeight = 0.0f;
 		for (U32 p = 0; p < polyList.mPolyList.size(); p++)
 		{
 			//nearly vertical surface?
@@ -4753,19 +6973,28 @@ void AAKPlayer::findWallContact(bool* wall, PlaneF* wallPlane)
 				}
 			}
 		}
-		if(totalWeight > 0)
-		{
-			*wall = true;
+	}
 
-			//divide to finish the weighted averages
-			*wallPlane /= totalWeight;
-			wallPlane->d /= totalWeight;
-		}
-		else
-		{
-			//we failed to find a suitable wall hug surface
-			*wall = false;
-		}
+	if(totalWeight > 0)
+	{
+		*wall = true;
+
+		//divide to finish the weighted averages
+		*wallPlane /= totalWeight;
+		wallPlane->d /= totalWeight;
+	}
+	else
+	{
+		//we failed to find a suitable wall hug surface
+		*wall = false;
+	}
+
+	if (input.useCache)
+	{
+		AAKProbeCache::Result result;
+		result.found = *wall;
+		result.plane = *wallPlane;
+		AAKProbeCache::insert(input.cacheKey, result, cacheSources);
 	}
 }
 
@@ -4820,37 +7049,45 @@ void AAKPlayer::findLedgeContact(bool* ledge, VectorF* ledgeNormal, Point3F* led
 
 	F32 totalWeight = 0.0f;
 
-	Point3F pos;
-	getTransform().getColumn(3, &pos);
+	ProbeInput input;
+	getProbeInput(AAKProbeCache::LedgeProbe, &input);
+	const Point3F& forward = input.forward;
+	const Box3F& wBox = input.box;
 
-	Point3F forward;
-	getTransform().getColumn(1, &forward);
+	//computed at the end of last tick, or shared by another player?
+	AAKProbeCache::Result cached;
+	if (takeSpeculativeResult(AAKProbeCache::LedgeProbe, input, &cached)
+		|| (input.useCache && AAKProbeCache::find(input.cacheKey, &cached)))
+	{
+		*ledge = cached.found;
+		*ledgeNormal = cached.normal;
+		*ledgePoint = cached.point;
+		*canMoveLeft = cached.canMoveLeft;
+		*canMoveRight = cached.canMoveRight;
+		return;
+	}
 
-	Box3F wBox = mObjBox;
-	Point3F offset(forward);
-	offset.normalize(wBox.len_y());
-	wBox.minExtents.z = mDataBlock->grabHeightMin;
-	wBox.maxExtents.z = mDataBlock->grabHeightMax;
+	AAKProbeCache::Sources cacheSources;
 
 	//if player is falling quickly he may miss a ledge between ticks
-	//thus we extend the box downward to ensure ledges are always found
-	wBox.minExtents.z += (mVelocity.z * TickSec) - wBox.len_z();
-
-	wBox.minExtents += offset + pos;
-	wBox.maxExtents += offset + pos;
+	//thus we sweep the box down over the tick (and a box height
+	//further) and take the first ledge it reaches
+	LedgeSweep sweep(wBox, input.drop, forward);
+	AAKProbeScratch::get().mLedgeProbes++;
 
 #ifdef ENABLE_DEBUGDRAW
    if (sRenderHelpers)
    {
-      DebugDrawer::get()->drawBox(wBox.minExtents, wBox.maxExtents, LinearColorF::BLUE);
+      DebugDrawer::get()->drawBox(sweep.sweptBox.minExtents, sweep.sweptBox.maxExtents, LinearColorF::BLUE);
       DebugDrawer::get()->setLastTTL(TickMs);
    }
 #endif
 
-	static ConcretePolyList polyList;
-	polyList.clear();
+	AAKScratchPolyList<ConcretePolyList> scratchList;
+	ConcretePolyList& polyList = *scratchList;
 	polyList.doConstruct();
-	Box3F plistBox = wBox;
+	Box3F plistBox = sweep.sweptBox;
+	ProbeObjectSet probedSet;
 
 	// Build list from convex states here...
 	CollisionWorkingList& rList = mConvex.getWorkingList();
@@ -4863,13 +7100,29 @@ void AAKPlayer::findLedgeContact(bool* ledge, VectorF* ledgeNormal, Point3F* led
 		{
 			bool skip = true;
 
+			if (input.useCache && plistBox.isOverlapped(pConvex->getBoundingBox()))
+				cacheSources.add(pConvex->getObject());
+
 			TSStatic *st = dynamic_cast<TSStatic *> (pConvex->getObject());
 			if (st && st->allowPlayerLedgeGrab())
- 				skip = false;
+			{
+				//baked shapes use their nav data, see AAKNavData
+				S32 index = probedSet.find(st);
+				if (index < 0 && !probedSet.isFull())
+					index = probedSet.add(st, findNavLedges(AAKNavData::getPlaced(st), &sweep));
+				skip = probedSet.isHandled(index);
+			}
 
+			//terrain is sampled directly, its polygons are only used if
+			//the probe box is too large for the heightfield path
 			TerrainBlock *terrain = dynamic_cast<TerrainBlock *> (pConvex->getObject());
 			if (terrain && terrain->allowPlayerClimb())
-				skip = false;
+			{
+				S32 index = probedSet.find(terrain);
+				if (index < 0 && !probedSet.isFull())
+					index = probedSet.add(terrain, findTerrainLedges(terrain, &sweep));
+				skip = probedSet.isHandled(index);
+			}
 
 			if(!skip)
 			{
@@ -4881,138 +7134,76 @@ void AAKPlayer::findLedgeContact(bool* ledge, VectorF* ledgeNormal, Point3F* led
 		pList = pList->wLink.mNext;
 	}
 
-	if (!polyList.isEmpty())
+	for (U32 p = 0; p < polyList.mPolyList.size(); p++)
 	{
-		for (U32 p = 0; p < polyList.mPolyList.size(); p++)
+		//upward-facing surface?
+		if(polyList.mPolyList[p].plane.z > 0.9f) 
 		{
-			//upward-facing surface?
-			if(polyList.mPolyList[p].plane.z > 0.9f) 
+			//loop through all the verticies of this polygon
+			for (S32 i=polyList.mPolyList[p].vertexStart; i < polyList.mPolyList[p].vertexStart + polyList.mPolyList[p].vertexCount; i++)
 			{
-				//loop through all the verticies of this polygon
-				for (S32 i=polyList.mPolyList[p].vertexStart; i < polyList.mPolyList[p].vertexStart + polyList.mPolyList[p].vertexCount; i++)
-				{
-					S32 vertex1Index = i;
-					S32 vertex2Index = i + 1;
-
-					//the last vertex is connected to the first
-					if(i == polyList.mPolyList[p].vertexStart + polyList.mPolyList[p].vertexCount - 1) 
-						vertex2Index = polyList.mPolyList[p].vertexStart;
+				S32 vertex1Index = i;
+				S32 vertex2Index = i + 1;
 
-					//get the verticies
-					Point3F vertex1 = polyList.mVertexList[polyList.mIndexList[vertex1Index]];
-					Point3F vertex2 = polyList.mVertexList[polyList.mIndexList[vertex2Index]];
+				//the last vertex is connected to the first
+				if(i == polyList.mPolyList[p].vertexStart + polyList.mPolyList[p].vertexCount - 1) 
+					vertex2Index = polyList.mPolyList[p].vertexStart;
 
-					//calculate the "normal" (only X&Y) of this edge
-					Point3F normal = mCross(Point3F(0,0,1), vertex2 - vertex1);
-					normal.normalizeSafe();
+				//get the verticies
+				Point3F vertex1 = polyList.mVertexList[polyList.mIndexList[vertex1Index]];
+				Point3F vertex2 = polyList.mVertexList[polyList.mIndexList[vertex2Index]];
 
-					//quick test: is player facing this edge?
-					//we'll test the *real* normal more thoroughly later
-					if(mDot(forward, normal) <= 0)
-					{
-						//Now we're going to collide the edge with our box. We'll do
-						//this from both directions and use the average collision point.
-						//This is neccessary when one vertex is higher than the other.
-						F32 t1; Point3F n1;
-						bool collided1 = wBox.collideLine(vertex1, vertex2, &t1, &n1);
-						
-						F32 t2; Point3F n2;
-						bool collided2 = wBox.collideLine(vertex2, vertex1, &t2, &n2);
-
-						//does this edge pass through our box?
-						if(collided1 && collided2)
-						{
-							//Now we need to make sure that:
-							//1) this edge is "significant" (ie. large difference in normals of polygons on either side) and
-							//2) the edge normal actually faces the player (prevents grabbing the floor on the other side of a wall etc.)
-							//    __                         | |
-							//      \   0                  --+ |   0
-							//      |  /|\                     |  /|\
-							//      |  / \                     |  / \
-							//BAD, neither edge of         BAD, edge normal does
-							//bevel is significant         not face the player
-
-							//so let's go through the other polygons to find an adjacent polygon (a polygon that shares this edge)
-
-							U32 adjPolyIndex;
-							if(findAdjacentPoly(&polyList, vertex1, vertex2, p, &adjPolyIndex))
-							{
-								Point3F polyNormal = polyList.mPolyList[p].plane;
-								Point3F adjPolyNormal = polyList.mPolyList[adjPolyIndex].plane;
-
-								//find the *real* edge normal
-								Point3F edgeNormal = (polyNormal + adjPolyNormal) / 2.0f;
-
-								//does the edge normal face the player?
-								F32 edgeNormalDotForward = mDot(edgeNormal, forward);
-								if(edgeNormalDotForward <= -0.2f)
-								{
-									//is this a "significant edge"?
-									F32 polyNormalDotadjPolyNormal = mDot(polyNormal, adjPolyNormal);
-									if(polyNormalDotadjPolyNormal <= 0.1f)
-									{
-										//find the points of collision
-										Point3F collisionPoint1, collisionPoint2;
-										collisionPoint1.interpolate(vertex1, vertex2, t1);
-										collisionPoint2.interpolate(vertex2, vertex1, t2);
-
-										//calculate this edge's weight using length inside box
-										F32 lengthInBox = (collisionPoint1 - collisionPoint2).len();
-  										F32 weight = lengthInBox;
-
-										//we'll take the average of the two collision points
-										Point3F collisionPoint = (collisionPoint1 + collisionPoint2) / 2.0f;
-
-										totalWeight += weight;
-										*ledgeNormal += normal * weight;
-										*ledgePoint += collisionPoint * weight;
-										*canMoveLeft = *canMoveLeft || !wBox.isContained(vertex2);
-										*canMoveRight = *canMoveRight || !wBox.isContained(vertex1);
-
-										#ifdef ENABLE_DEBUGDRAW
-                              if (sRenderHelpers)
-                              {
-                                 //draw the edge
-                                 DebugDrawer::get()->drawLine(vertex1, vertex2, LinearColorF(1.0f, 0.0f, 0.5f));
-                                 DebugDrawer::get()->setLastTTL(TickMs);
-
-                                 //draw the edgeNormal at the midPoint
-                                 Point3F midPoint = (vertex1 + vertex2) / 2.0f;
-                                 DebugDrawer::get()->drawLine(midPoint, midPoint + edgeNormal, LinearColorF(0.0f, 0.5f, 0.5f));
-                                 DebugDrawer::get()->setLastTTL(TickMs);
-                              }
-										#endif
-									}
-								}
-							}
-						}
-					}
-				}
+				//Now we need to make sure that:
+				//1) this edge is "significant" (ie. large difference in normals of polygons on either side) and
+				//2) the edge normal actually faces the player (prevents grabbing the floor on the other side of a wall etc.)
+				//    __                         | |
+				//      \   0                  --+ |   0
+				//      |  /|\                     |  /|\
+				//      |  / \                     |  / \
+				//BAD, neither edge of         BAD, edge normal does
+				//bevel is significant         not face the player
+				//
+				//that needs the adjacent polygon, which is only searched for
+				//the edges the sweep reaches first (see LedgeSweep::resolve)
+				sweep.add(vertex1, vertex2, polyList.mPolyList[p].plane, NULL, p);
 			}
 		}
+	}
 
-		if(totalWeight > 0)
-		{
-			*ledge = true;
+	sweep.resolve(&polyList, ledgeNormal, ledgePoint, &totalWeight, canMoveLeft, canMoveRight);
 
-			//divide to finish the weighted averages
-			*ledgePoint /= totalWeight;
-			*ledgeNormal /= totalWeight;
+	if(totalWeight > 0)
+	{
+		*ledge = true;
 
-			#ifdef ENABLE_DEBUGDRAW
+		//divide to finish the weighted averages
+		*ledgePoint /= totalWeight;
+		*ledgeNormal /= totalWeight;
+
+		#ifdef ENABLE_DEBUGDRAW
          if (sRenderHelpers)
          {
             //draw the ledge point
             DebugDrawer::get()->drawLine(*ledgePoint, *ledgePoint + *ledgeNormal, ColorI::BLACK);
             DebugDrawer::get()->setLastTTL(TickMs);
          }
-			#endif
-		}
-		else
-		{
-			//we failed to find a suitable ledge
-			*ledge = false;
-		}
+		#endif
+	}
+	else
+	{
+		//we failed to find a suitable ledge
+		*ledge = false;
+	}
+
+	if (input.useCache)
+	{
+		AAKProbeCache::Result result;
+		result.found = *ledge;
+		result.normal = *ledgeNormal;
+		result.point = *ledgePoint;
+		result.canMoveLeft = *canMoveLeft;
+		result.canMoveRight = *canMoveRight;
+		AAKProbeCache::insert(input.cacheKey, result, cacheSources);
 	}
 }
 
@@ -5174,24 +7365,32 @@ void AAKPlayer::updateLedgeUpAnimation()
 		//update delta
 		mLedgeState.deltaAnimPosVec = mLedgeState.animPos;
 
-		F32 vel = mDataBlock->grabSpeedUp * TickSec;
+		//play in reverse? Remote ghosts don't have the input, they keep
+		//going whichever way the server last told them
+		S8 upDir = mLedgeState.upDir;
+		if(!isRemoteGhost())
+		{
+			upDir = (mLedgeState.direction != MOVE_DIR_UP && mLedgeState.animPos < 0.2) ? -1 : 1;
 
-		//play in reverse?
-		if(mLedgeState.direction != MOVE_DIR_UP && mLedgeState.animPos < 0.2)
-			vel *= -1;
+			//only starting and reversing go over the wire, clients
+			//integrate the rest themselves
+			if(upDir != mLedgeState.upDir)
+			{
+				mLedgeState.upDir = upDir;
+				setMaskBits(LedgeUpMask);
+			}
+		}
 
 		//update the animation position
-		F32 pos = mLedgeState.animPos + vel;
+		F32 pos = mLedgeState.animPos + mDataBlock->grabSpeedUp * TickSec * upDir;
 		mLedgeState.animPos = mClampF(pos, 0.0f, 1.0f);
 		if (mActionAnimation.thread)
 		{
-			mShapeInstance->clearTransition(mActionAnimation.thread);
+			if (mShapeInstance->inTransition())
+				mShapeInstance->clearTransition(mActionAnimation.thread);
 			mShapeInstance->setPos(mActionAnimation.thread, mLedgeState.animPos);
 		}
 
-		//tell the client it's changed
-		setMaskBits(LedgeUpMask);
-
 		if(isClientObject())
 		{
 			//calc delta for backstepping
@@ -5216,22 +7415,23 @@ Point3F AAKPlayer::snapToPlane(PlaneF plane)
 	boundingBox.maxExtents += pos;
 	
 	//we'll test all 8 verticies of our collision box
-	Vector<Point3F> testPoints;
-	testPoints.push_back(Point3F(boundingBox.maxExtents.x, boundingBox.maxExtents.y, boundingBox.maxExtents.z));
-	testPoints.push_back(Point3F(boundingBox.minExtents.x, boundingBox.maxExtents.y, boundingBox.maxExtents.z));
-	testPoints.push_back(Point3F(boundingBox.maxExtents.x, boundingBox.minExtents.y, boundingBox.maxExtents.z));
-	testPoints.push_back(Point3F(boundingBox.minExtents.x, boundingBox.minExtents.y, boundingBox.maxExtents.z));
-	testPoints.push_back(Point3F(boundingBox.maxExtents.x, boundingBox.maxExtents.y, boundingBox.minExtents.z));
-	testPoints.push_back(Point3F(boundingBox.minExtents.x, boundingBox.maxExtents.y, boundingBox.minExtents.z));
-	testPoints.push_back(Point3F(boundingBox.maxExtents.x, boundingBox.minExtents.y, boundingBox.minExtents.z));
-	testPoints.push_back(Point3F(boundingBox.minExtents.x, boundingBox.minExtents.y, boundingBox.minExtents.z));
+	Point3F testPoints[8] = {
+		Point3F(boundingBox.maxExtents.x, boundingBox.maxExtents.y, boundingBox.maxExtents.z),
+		Point3F(boundingBox.minExtents.x, boundingBox.maxExtents.y, boundingBox.maxExtents.z),
+		Point3F(boundingBox.maxExtents.x, boundingBox.minExtents.y, boundingBox.maxExtents.z),
+		Point3F(boundingBox.minExtents.x, boundingBox.minExtents.y, boundingBox.maxExtents.z),
+		Point3F(boundingBox.maxExtents.x, boundingBox.maxExtents.y, boundingBox.minExtents.z),
+		Point3F(boundingBox.minExtents.x, boundingBox.maxExtents.y, boundingBox.minExtents.z),
+		Point3F(boundingBox.maxExtents.x, boundingBox.minExtents.y, boundingBox.minExtents.z),
+		Point3F(boundingBox.minExtents.x, boundingBox.minExtents.y, boundingBox.minExtents.z)
+	};
 
 	//find the point with the least distance to plane
 	//negative best distance = pull player out of the plane
 	//positive best distance = push player onto plane
 	F32 bestDist = F32_MAX;
 	Point3F bestPoint(0,0,0);
-	for(int i = 0; i < testPoints.size(); i++)
+	for(int i = 0; i < 8; i++)
 	{
 		F32 dist = plane.distToPlane(testPoints[i]);
 		if(dist < bestDist)
@@ -5249,3 +7449,235 @@ Point3F AAKPlayer::snapToPlane(PlaneF plane)
 
 	return pos + offset;
 }
+
+//-------------------------------------------------------------------
+// Rewind
+//
+// Every $AAKPlayer::rewindInterval ticks the server stores a snapshot
+// of the player and its camera goals in a fixed size ring buffer.
+// Rewinding or respawning at a checkpoint restores one of those in
+// place, no objects are deleted or created
+//-------------------------------------------------------------------
+
+// Scratch space for one rewind record (player + camera goals), server only
+static U8 sRewindScratch[AAKUtils::MaxSnapshotSize * 3];
+
+void AAKPlayer::setRewindCameraGoals(ShapeBase* cameraGoal, ShapeBase* follower)
+{
+   mRewindCameraGoal = cameraGoal;
+   mRewindFollower = follower;
+   mRewindBuffer.clear();
+}
+
+U32 AAKPlayer::writeRewindState(U8* buffer, U32 bufferSize)
+{
+   MemStream stream(bufferSize, buffer, false, true);
+
+   if (!writeSnapshot(stream))
+      return 0;
+
+   CameraGoalPlayer* cameraGoal = dynamic_cast<CameraGoalPlayer*>(mRewindCameraGoal.getObject());
+   stream.write(cameraGoal != NULL);
+   if (cameraGoal && !cameraGoal->writeSnapshot(stream))
+      return 0;
+
+   CameraGoalFollower* follower = dynamic_cast<CameraGoalFollower*>(mRewindFollower.getObject());
+   stream.write(follower != NULL);
+   if (follower && !follower->writeSnapshot(stream))
+      return 0;
+
+   return stream.getStatus() == Stream::Ok ? stream.getPosition() : 0;
+}
+
+bool AAKPlayer::readRewindState(const U8* data, U32 size)
+{
+   //keep the current state aside, so a record that only partly reads back
+   //(the player restored but not its camera goals) can be undone
+   U32 backupSize = writeRewindState(sRewindScratch, sizeof(sRewindScratch));
+
+   if (!applyRewindState(data, size))
+   {
+      if (backupSize)
+         applyRewindState(sRewindScratch, backupSize);
+      return false;
+   }
+
+   //bring the player back to life if the restored state is alive
+   if (getDamageState() != Enabled && getDamageLevel() < mDataBlock->disabledLevel)
+      setDamageState(Enabled);
+
+   return true;
+}
+
+bool AAKPlayer::applyRewindState(const U8* data, U32 size)
+{
+   MemStream stream(size, (void*)data, true, false);
+
+   if (!readSnapshot(stream))
+      return false;
+
+   bool hasCameraGoal = false;
+   stream.read(&hasCameraGoal);
+   CameraGoalPlayer* cameraGoal = dynamic_cast<CameraGoalPlayer*>(mRewindCameraGoal.getObject());
+   if (hasCameraGoal && cameraGoal && !cameraGoal->readSnapshot(stream))
+      return false;
+
+   bool hasFollower = false;
+   stream.read(&hasFollower);
+   CameraGoalFollower* follower = dynamic_cast<CameraGoalFollower*>(mRewindFollower.getObject());
+   if (hasFollower && follower && !follower->readSnapshot(stream))
+      return false;
+
+   return true;
+}
+
+void AAKPlayer::updateRewind()
+{
+   //only sets the cap, the storage is allocated by the first snapshot
+   mRewindBuffer.setCapacity(getMax(sRewindMemoryCap, 0));
+   if (!mRewindBuffer.getCapacity() || getDamageState() != Enabled)
+      return;
+
+   if (++mRewindTickCount < (U32)getMax(sRewindInterval, 1))
+      return;
+   mRewindTickCount = 0;
+
+   PROFILE_SCOPE(AAKPlayer_updateRewind);
+
+   U32 size = writeRewindState(sRewindScratch, sizeof(sRewindScratch));
+   if (size)
+      mRewindBuffer.push(sRewindScratch, size, Sim::getCurrentTime());
+}
+
+bool AAKPlayer::rewind(U32 ms)
+{
+   U32 now = Sim::getCurrentTime();
+   S32 index = mRewindBuffer.findRecord(ms < now ? now - ms : 0);
+
+   //not that much history, use the oldest we have
+   if (index < 0 && mRewindBuffer.getRecordCount())
+      index = 0;
+
+   if (index < 0)
+      return false;
+
+   if (!readRewindState(mRewindBuffer.getRecordData(index), mRewindBuffer.getRecordSize(index)))
+      return false;
+
+   //the states after this one never happened
+   mRewindBuffer.truncate(index);
+   mRewindTickCount = 0;
+   return true;
+}
+
+bool AAKPlayer::saveCheckpoint()
+{
+   U32 size = writeRewindState(sRewindScratch, sizeof(sRewindScratch));
+   if (!size)
+      return false;
+
+   mCheckpoint.setSize(size);
+   dMemcpy(mCheckpoint.address(), sRewindScratch, size);
+   return true;
+}
+
+bool AAKPlayer::restoreCheckpoint()
+{
+   if (mCheckpoint.empty() || !readRewindState(mCheckpoint.address(), mCheckpoint.size()))
+      return false;
+
+   mRewindBuffer.clear();
+   mRewindTickCount = 0;
+   return true;
+}
+
+U32 AAKPlayer::getRewindBytesUsed() const
+{
+   return mRewindBuffer.getBytesUsed() + mCheckpoint.size();
+}
+
+DefineEngineMethod( AAKPlayer, setRewindCameraGoals, void, (ShapeBase* cameraGoal, ShapeBase* follower),
+   (nullAsType<ShapeBase*>(), nullAsType<ShapeBase*>()),
+   "@brief Sets the CameraGoalPlayer and CameraGoalFollower restored along with this player by rewind().\n\n")
+{
+   object->setRewindCameraGoals(cameraGoal, follower);
+}
+
+DefineEngineMethod( AAKPlayer, rewind, bool, (S32 ms), ,
+   "@brief Restores the player (and its camera goals) to how they were ms milliseconds ago.\n\n"
+   "@return True if successful, false if there is no rewind history\n")
+{
+   return object->rewind(getMax(ms, 0));
+}
+
+DefineEngineMethod( AAKPlayer, saveCheckpoint, bool, (), ,
+   "@brief Stores the current player and camera goal state for restoreCheckpoint().\n\n")
+{
+   return object->saveCheckpoint();
+}
+
+DefineEngineMethod( AAKPlayer, restoreCheckpoint, bool, (), ,
+   "@brief Restores the state stored by saveCheckpoint().\n\n"
+   "@return True if successful, false if there is no checkpoint\n")
+{
+   return object->restoreCheckpoint();
+}
+
+DefineEngineMethod( AAKPlayer, getRewindBytesUsed, S32, (), ,
+   "@brief Returns the memory (bytes) used by this player's rewind buffer and checkpoint.\n\n")
+{
+   return object->getRewindBytesUsed();
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::useAnimationLOD
+//
+// Returns true if this player can get by with a throttled skeleton.
+// Only ghosts that weren't rendered last frame and that we aren't
+// controlling qualify; the server and the control object always
+// animate fully.
+//-------------------------------------------------------------------
+bool AAKPlayer::useAnimationLOD()
+{
+   if (sAnimLODTicks <= 0 || !isGhost())
+      return false;
+
+   return !didRenderLastRender() && !isControlObject();
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::updateAnimationLOD
+//
+// Rebuilds the node transforms for this tick. Unseen ghosts only do
+// it every sAnimLODTicks ticks (the threads keep advancing), anything
+// that reads a node in between goes through getNodePosition, which
+// refreshes on demand. Rendering animates the shape itself, so the
+// full pose comes back the first frame the player is seen again.
+//-------------------------------------------------------------------
+void AAKPlayer::updateAnimationLOD()
+{
+   if (!mShapeInstance)
+      return;
+
+   if (useAnimationLOD() && ++mAnimLOD.ticksSkipped < sAnimLODTicks)
+   {
+      mAnimLOD.stale = true;
+      return;
+   }
+
+   refreshAnimation();
+}
+
+//-------------------------------------------------------------------
+// AAKPlayer::refreshAnimation
+//
+// Brings the node transforms up to date with the animation threads
+//-------------------------------------------------------------------
+void AAKPlayer::refreshAnimation()
+{
+   if (mShapeInstance)
+      mShapeInstance->animate();
+
+   mAnimLOD.stale = false;
+   mAnimLOD.ticksSkipped = 0;
+}
@@ -40,6 +40,21 @@
 #include "collision/concretePolyList.h"
 #endif
 
+#ifndef _AAKREWINDBUFFER_H_
+#include "./AAKRewindBuffer.h"
+#endif
+
+#ifndef _TDICTIONARY_H_
+#include "core/util/tDictionary.h"
+#endif
+
+#ifndef _AAKPROBECACHE_H_
+#include "./AAKProbeCache.h"
+#endif
+
+class Stream;
+class AAKSpeculativeProbe;
+
 
 //----------------------------------------------------------------------------
 
@@ -165,9 +180,51 @@ struct AAKPlayerData: public PlayerData {
 
    bool preload(bool server, String& errorStr) override;
   
-   bool isLedgeAction(U32 action);
-   bool isClimbAction(U32 action);
-   bool isLandAction(U32 action);
+   bool isLedgeAction(U32 action) const { return hasActionFlag(action, ActionLedge); }
+   bool isClimbAction(U32 action) const { return hasActionFlag(action, ActionClimb); }
+   bool isLandAction(U32 action) const { return hasActionFlag(action, ActionLand); }
+   bool isDeathAction(U32 action) const { return hasActionFlag(action, ActionDeath); }
+
+   //Ubiq: action cache
+   //everything the per-tick animation code needs to know about an action,
+   //resolved once in preload. Two entries fit in a cache line, so picking
+   //and time-scaling an action never has to touch the engine's ActionAnimation
+   //records (or do any string work).
+   enum ActionFlags {
+      ActionValid         = BIT(0),   ///< sequence exists in the shape
+      ActionVelocityScale = BIT(1),   ///< time scale follows ground velocity
+      ActionDeath         = BIT(2),
+      ActionJump          = BIT(3),
+      ActionLand          = BIT(4),
+      ActionLedge         = BIT(5),
+      ActionClimb         = BIT(6),
+   };
+
+   struct ActionCacheEntry {
+      VectorF dir;            ///< ground transform direction (object space)
+      F32 speed;              ///< ground speed of the sequence
+      S32 sequence;           ///< sequence index, -1 if missing
+      U32 flags;              ///< ActionFlags
+      F32 transitionTime;     ///< blend time into this action, 0 = sAnimationTransitionTime
+      U32 pad;
+   };
+
+   /// One entry per action actually resolved (actionCount entries, not NumActionAnims)
+   Vector<ActionCacheEntry> mActionCache;
+
+   /// Case-insensitive sequence name -> action index, built once in preload
+   HashTable<StringTableEntry, U32> mActionNames;
+
+   const ActionCacheEntry* getActionEntry(U32 action) const
+   {
+      return action < mActionCache.size() ? &mActionCache[action] : NULL;
+   }
+   bool hasActionFlag(U32 action, U32 flag) const
+   {
+      return action < mActionCache.size() && (mActionCache[action].flags & flag) != 0;
+   }
+   S32 findAction(const char* name) const;
+   void buildActionCache();
 
    static void initPersistFields();
    virtual void packData(BitStream* stream);
@@ -237,13 +294,16 @@ struct AAKPlayerData: public PlayerData {
 class AAKPlayer: public Player
 {
    typedef Player Parent;
+   friend class AAKSpeculativeProbe;
 
 protected:
 
    /// Bit masks for different types of events
    enum MaskBits {
       LedgeUpMask = Parent::NextFreeMask << 0,
-      NextFreeMask = Parent::NextFreeMask << 1   };
+      NetStateMask = Parent::NextFreeMask << 1,
+      SurfaceAnchorMask = Parent::NextFreeMask << 2,
+      NextFreeMask = Parent::NextFreeMask << 3   };
 
    SFXSource* mSlideSound;        ///< Ubiq: Sound for sliding down or scraping across surfaces
 
@@ -277,6 +337,20 @@ protected:
       VectorF* contactNormal,
       Vector<SceneObject*>* outOverlapObjects);
 
+   /// Triggers, items and corpses we overlapped last tick, sorted by id, so
+   /// a trigger that already holds us isn't offered us again every tick
+   struct OverlapEntry
+   {
+      SimObjectId id;
+      bool pending;			//offer again next tick (trigger refused us, item not picked up yet...)
+   };
+   Vector<OverlapEntry> mOverlaps;
+   Vector<OverlapEntry> mOverlapsPrev;
+   Vector<SceneObject*> mOverlapObjects;	//reused every tick by findContact
+
+   void updateOverlaps(U32 filterMask);
+   bool deliverOverlapEnter(SceneObject* obj);
+
 public:
    DECLARE_CONOBJECT(AAKPlayer);
    DECLARE_CATEGORY("Actor \t Controllable");
@@ -308,6 +382,7 @@ public:
 
    void updateActionThread() override;
    void pickActionAnimation() override;
+   bool inDeathAction() const;
 
    void setPosition(const Point3F& pos, const Point3F& rot);
    void setRenderPosition(const Point3F& pos, const Point3F& rot, F32 dt = -1);
@@ -317,6 +392,84 @@ public:
    void writePacketData(GameConnection* connection, BitStream* stream) override;
    void readPacketData(GameConnection* connection, BitStream* stream) override;
 
+   struct MoveStates;
+   void writeMoveStates(Stream* stream);
+   void readMoveStates(Stream* stream, MoveStates* states);
+
+   /// Compact movement state sent to every ghost, so remote ghosts don't
+   /// have to probe for climbs, walls and ledges themselves
+   enum NetStateFlags {
+      NetSlide       = BIT(0),
+      NetJump        = BIT(1),
+      NetClimb       = BIT(2),
+      NetWallHug     = BIT(3),
+      NetLedge       = BIT(4),
+      NetClimbingUp  = BIT(5),
+      NetLand        = BIT(6),
+      NetFalling     = BIT(7),
+      NetContact     = BIT(8),
+      NetClimbZone   = BIT(9),
+      NetStateBits   = 10
+   };
+
+   struct NetState
+   {
+      U32 flags;
+      U8 jumpType;
+      U8 climbDir, wallDir, ledgeDir;
+      VectorF normal;			//surface normal of whichever surface state is active
+      Point3F ledgePoint;
+   };
+   NetState mNetState;			//last state sent (server) / received (client)
+
+   void getNetState(NetState* state);
+   bool netStateChanged(const NetState& state) const;
+   void writeNetState(BitStream* stream);
+   void readNetState(BitStream* stream);
+   void applyNetState();
+   void updateNetState();
+
+   bool isRemoteGhost();
+   void updateRemoteGhost();
+
+   /// Surface-relative moves: while hanging, climbing or wall hugging the
+   /// player can only move along a line or plane, so once the anchor has
+   /// been sent, position updates are 1D/2D coordinates on it
+   enum SurfaceKind {
+      SurfaceNone,
+      SurfaceLine,			//ledge / wall hug, u only
+      SurfacePlane,			//climb, u and v
+      SurfaceKindBits = 2,
+      SurfaceAnchorIdBits = 3
+   };
+
+   struct SurfaceNet
+   {
+      U8 kind;
+      U8 anchorId;			//bumped every new anchor, moves for other anchors are ignored
+      Point3F anchor;
+      VectorF normal;
+      VectorF u, v;			//horizontal / vertical axes on the surface
+   };
+   SurfaceNet mSurfaceNet;
+
+   U32 getSurfaceKind(VectorF* normal);
+   static bool getSurfaceAxes(const VectorF& normal, VectorF* u, VectorF* v);
+   bool getSurfaceCoords(const Point3F& pos, S32* s, S32* t) const;
+   Point3F getSurfacePoint(S32 s, S32 t) const;
+   void updateSurfaceAnchor();
+   void writeSurfaceAnchor(BitStream* stream);
+   void readSurfaceAnchor(BitStream* stream);
+   void writeSurfaceMove(BitStream* stream, S32 s, S32 t);
+   void readSurfaceMove(BitStream* stream);
+   void applySurfaceMove(const Point3F& pos, const VectorF& vel, const Point3F& rot);
+   bool constrainToSurface(Point3F* pos, VectorF* vel);
+
+   /// Save game snapshot of the full player state (see AAKUtils::writeSnapshotHeader)
+   enum { SnapshotVersion = 1 };
+   bool writeSnapshot(Stream& stream);
+   bool readSnapshot(Stream& stream);
+
    U32 packUpdate(NetConnection* con, U32 mask, BitStream* stream) override;
    void unpackUpdate(NetConnection* con, BitStream* stream) override;
 
@@ -335,6 +488,7 @@ public:
    void setObjectBox(Point3F size);
    Box3F createObjectBox(Point3F size);
    bool worldBoxIsClear(Box3F worldSpaceBox);
+   bool worldBoxIsClear(const Box3F& worldSpaceBox, U32 typeMask);
    bool worldBoxIsClear(Box3F objSpaceBox, Point3F worldPosition);
    Point3F snapToPlane(PlaneF plane);	//collides player with given plane and returns the new position
    U32 getSurfaceType();
@@ -397,11 +551,14 @@ public:
       MoveDir direction = MOVE_DIR_NONE;
       bool ignoreClimb = false;
    } mClimbState;
-   S32 mClimbTriggerCount;
+   S32 mClimbTriggerCount;	//ClimbTriggers we're in, kept up to date from script
+   S32 mClimbZoneCount;		//ClimbZones we're in, see updateClimbZones
 
    void findClimbContact(bool* climb, PlaneF* climbPlane);
    bool canStartClimb();
    bool canClimb();
+   bool inClimbArea() const { return mClimbTriggerCount > 0 || mClimbZoneCount > 0; }
+   void updateClimbZones();
 
 
    //-------------------------------------------------------------------
@@ -434,10 +591,11 @@ public:
       F32 animPos = 0.0f;			//what pos are we at in the climb up animation? (0 - 1)
       F32 deltaAnimPos = 1.0f;		//for interpolation, the last pos in the climb up animation (0 - 1)
       F32 deltaAnimPosVec = 1.0f;	//for interpolation, how fast are we playing climb up animation?
+      S8 upDir = 0;				//which way the climb up animation is playing (1 up, -1 back down, 0 not yet)
    }
    mLedgeState;
    void findLedgeContact(bool* ledge, VectorF* ledgeNormal, Point3F* ledgePoint, bool* canMoveLeft, bool* canMoveRight);
-   bool findAdjacentPoly(ConcretePolyList* polyList, Point3F vertex1, Point3F vertex2, U32 polyIndex, U32* adjPolyIndex);
+   static bool findAdjacentPoly(ConcretePolyList* polyList, Point3F vertex1, Point3F vertex2, U32 polyIndex, U32* adjPolyIndex);
    bool canStartLedgeGrab();
    bool canLedgeGrab();
    Point3F getLedgeUpPosition();
@@ -445,6 +603,60 @@ public:
    void updateLedgeUpAnimation();
 
 
+   //-------------------------------------------------------------------
+   // Probe inputs
+   //-------------------------------------------------------------------
+   struct ProbeInput
+   {
+      Point3F forward;
+      Box3F box;			//probe box (ledge: the grab zone at the start of the sweep)
+      F32 drop;				//ledge only, how far the grab zone sweeps down
+      bool useCache;		//snapped for AAKProbeCache?
+      AAKProbeCache::Key cacheKey;
+
+      bool matches(const ProbeInput& other) const
+      {
+         return forward == other.forward && box.minExtents == other.box.minExtents
+            && box.maxExtents == other.box.maxExtents && drop == other.drop;
+      }
+   };
+   void getProbeInput(AAKProbeCache::ProbeType type, ProbeInput* input);
+
+
+   //-------------------------------------------------------------------
+   // Speculative probes (see AAKSpeculativeProbe)
+   //-------------------------------------------------------------------
+   AAKSpeculativeProbe* mSpeculativeProbes[AAKProbeCache::NumProbeTypes];	//issued at the end of last tick, NULL if none
+
+   void issueSpeculativeProbes();
+   AAKSpeculativeProbe* createSpeculativeProbe(AAKProbeCache::ProbeType type);
+   bool takeSpeculativeResult(AAKProbeCache::ProbeType type, const ProbeInput& input, AAKProbeCache::Result* result);
+   bool checkSpeculativeSources(const AAKSpeculativeProbe* probe);
+   void releaseSpeculativeProbes();
+
+   /// Blocks until no speculative probe is running, for anything about to
+   /// change the data they read (see AAKNavData)
+   static void waitForSpeculativeProbes();
+
+
+   //-------------------------------------------------------------------
+   // Camera stage
+   //-------------------------------------------------------------------
+   Vector<SimObjectPtr<ShapeBase> > mCameraGoals;		//camera goals tracking us, ticked after we move
+   Vector<SimObjectPtr<ShapeBase> > mCameraFollowers;	//followers tracking us, ticked after the goals
+   U32 mCameraStageTick;		//process list tick the stage last ran on
+
+   bool isCameraGoal(const ShapeBase* obj) const;
+   void updateCameraStage(const Move* controlMove);
+   void releaseCameraDependents();
+
+   /// Camera goals & followers call these from setPlayerObject, a registered
+   /// object no longer ticks on its own, updateCameraStage ticks it for us
+   void addCameraDependent(ShapeBase* obj, bool follower);
+   void removeCameraDependent(ShapeBase* obj);
+   void catchUpCameraGoal(ShapeBase* goal);
+
+
    //-------------------------------------------------------------------
    // Land state
    //-------------------------------------------------------------------
@@ -460,6 +672,72 @@ public:
    // Stop state
    //-------------------------------------------------------------------
    S32 mStoppingTimer;		//how long we've been slowing down for (ms)
+
+
+   //-------------------------------------------------------------------
+   // Move states (see writeMoveStates / readMoveStates)
+   //-------------------------------------------------------------------
+   struct MoveStates
+   {
+      SlideState slide;
+      JumpState jump;
+      ClimbState climb;
+      S32 climbTriggerCount;
+      WallHugState wallHug;
+      LedgeState ledge;
+      LandState land;
+      S32 stoppingTimer;
+   };
+
+   void getMoveStates(MoveStates* states);
+   void setMoveStates(const MoveStates& states);
+
+
+   //-------------------------------------------------------------------
+   // Moving platforms (server only)
+   //-------------------------------------------------------------------
+   struct PlatformState
+   {
+	   S32 lostTicks;		//ticks since we last stood on the platform we're attached to
+   }
+   mPlatformState;
+
+   SceneObject* getContactPlatform();
+
+
+   //-------------------------------------------------------------------
+   // Rewind (server only)
+   //-------------------------------------------------------------------
+   AAKRewindBuffer mRewindBuffer;				//player + camera goal snapshots every few ticks
+   Vector<U8> mCheckpoint;						//snapshot kept aside by saveCheckpoint()
+   SimObjectPtr<ShapeBase> mRewindCameraGoal;	//CameraGoalPlayer restored with us
+   SimObjectPtr<ShapeBase> mRewindFollower;	//CameraGoalFollower restored with us
+   U32 mRewindTickCount;
+
+   void setRewindCameraGoals(ShapeBase* cameraGoal, ShapeBase* follower);
+   void updateRewind();
+   U32 writeRewindState(U8* buffer, U32 bufferSize);
+   bool readRewindState(const U8* data, U32 size);
+   bool applyRewindState(const U8* data, U32 size);
+   bool rewind(U32 ms);
+   bool saveCheckpoint();
+   bool restoreCheckpoint();
+   U32 getRewindBytesUsed() const;
+
+
+   //-------------------------------------------------------------------
+   // Animation LOD (client ghosts only)
+   //-------------------------------------------------------------------
+   struct AnimLODState
+   {
+      bool stale;			//are the node transforms behind the animation threads?
+      S32 ticksSkipped;		//ticks since the node transforms were last rebuilt
+   }
+   mAnimLOD;
+
+   bool useAnimationLOD();
+   void updateAnimationLOD();
+   void refreshAnimation();
 };
 
 #endif
@@ -14,6 +14,9 @@ CameraGoalExplicit::CameraGoalExplicit()
    mNetFlags.clear(Ghostable);
    mTypeMask |= CameraObjectType;
 
+   //dormant until a follower uses us (see CameraGoalActivation)
+   setProcessTick(false);
+
    mPosition.set(0.0f, 0.0f, 0.0f);
    mRot.set(0.0f, 0.0f, 0.0f);
 
@@ -28,11 +31,25 @@ CameraGoalExplicit::~CameraGoalExplicit()
 
 F32 CameraGoalExplicit::getUpdatePriority(CameraScopeQuery* camInfo, U32 updateMask, S32 updateSkips)
 {
-   //we need a higher priority because
-   //cameraGoalFollower depends on us
+   //ghost us ahead of ordinary objects, cameraGoalFollower can't send
+   //us as its goal until we're ghosted (tick order is handled by the
+   //player's camera stage, not by this)
    return 5.0f;
 }
 
+void CameraGoalExplicit::onGoalActivate()
+{
+   updateGoalTicking(this, NULL);
+
+   //warm start, our transform is just the target position & vector
+   processTick(NULL);
+}
+
+void CameraGoalExplicit::onGoalDeactivate()
+{
+   updateGoalTicking(this, NULL);
+}
+
 void CameraGoalExplicit::processTick(const Move*)
 {
    mPosition = mTargetPosition;
@@ -1,8 +1,9 @@
 #pragma once
 #include "AAKplayer.h"
 #include "T3D/shapeBase.h"
+#include "cameraGoalActivation.h"
 
-class CameraGoalExplicit : public ShapeBase
+class CameraGoalExplicit : public ShapeBase, public CameraGoalActivation
 {
 private:
    typedef ShapeBase Parent;
@@ -31,6 +32,10 @@ private:
    Point3F mTargetPosition;
    VectorF mTargetVector;
 
+protected:
+   void onGoalActivate() override;
+   void onGoalDeactivate() override;
+
 public:
    DECLARE_CONOBJECT(CameraGoalExplicit);
 
@@ -9,6 +9,9 @@
 #include "gfx/gfxTransformSaver.h"
 #include "renderInstance/renderPassManager.h"
 #include "gfx/gfxDrawUtil.h"
+#include "platform/profiler.h"
+
+#include <algorithm>
 
 IMPLEMENT_CO_NETOBJECT_V1(CameraBlocker);
 
@@ -18,6 +21,12 @@ ConsoleDocClass(CameraBlocker,
 extern bool gEditingMission;
 bool CameraBlocker::smRenderBlockers = false;
 
+CameraBlocker::BlockerSet CameraBlocker::smServerBlockers;
+CameraBlocker::BlockerSet CameraBlocker::smClientBlockers;
+
+// Max blockers per BVH leaf
+static const U32 sBlockersPerLeaf = 4;
+
 //-----------------------------------------------------------------------------
 // Object setup and teardown
 //-----------------------------------------------------------------------------
@@ -27,8 +36,9 @@ CameraBlocker::CameraBlocker()
    // be sent across the network to clients
    mNetFlags.set(Ghostable | ScopeAlways);
 
-   // Set it as a "static" object
-   mTypeMask |= StaticObjectType;
+   // Not static geometry, camera rays find blockers through the blocker
+   // BVH (see castBlockerRay) so the container can skip them
+   mTypeMask |= MarkerObjectType;
 
    mCameraIgnores = false;
 }
@@ -68,11 +78,15 @@ bool CameraBlocker::onAdd()
    // Add this object to the scene
    addToScene();
 
+   getBlockerSet().add(this);
+
    return true;
 }
 
 void CameraBlocker::onRemove()
 {
+   getBlockerSet().remove(this);
+
    // Remove this object from the scene
    removeFromScene();
 
@@ -87,6 +101,10 @@ void CameraBlocker::setTransform(const MatrixF& mat)
    // Dirty our network mask so that the new transform gets
    // transmitted to the client object
    setMaskBits(TransformMask);
+
+   // Our world box moved, rebuild the BVH before the next query
+   if (isProperlyAdded())
+      getBlockerSet().dirty = true;
 }
 
 U32 CameraBlocker::packUpdate(NetConnection* conn, U32 mask, BitStream* stream)
@@ -205,3 +223,150 @@ bool CameraBlocker::castRayRendered(const Point3F& start, const Point3F& end, Ra
 
    return false;
 }
+
+//-----------------------------------------------------------------------------
+// Blocker BVH
+//-----------------------------------------------------------------------------
+void CameraBlocker::BlockerSet::add(CameraBlocker* blocker)
+{
+   blockers.push_back(blocker);
+   dirty = true;
+}
+
+void CameraBlocker::BlockerSet::remove(CameraBlocker* blocker)
+{
+   for (U32 i = 0; i < blockers.size(); i++)
+   {
+      if (blockers[i] == blocker)
+      {
+         blockers.erase_fast(i);
+         dirty = true;
+         return;
+      }
+   }
+}
+
+S32 CameraBlocker::BlockerSet::buildNode(U32 first, U32 count)
+{
+   S32 index = nodes.size();
+   nodes.increment();
+
+   // Bounds of everything under this node (Box3F::intersect grows the box)
+   Box3F box = blockers[order[first]]->getWorldBox();
+   for (U32 i = first + 1; i < first + count; i++)
+      box.intersect(blockers[order[i]]->getWorldBox());
+
+   nodes[index].box = box;
+   nodes[index].first = first;
+   nodes[index].count = count;
+   nodes[index].left = -1;
+   nodes[index].right = -1;
+
+   if (count <= sBlockersPerLeaf)
+      return index;
+
+   // Split at the median along the longest axis
+   Point3F extents = box.getExtents();
+   U32 axis = 0;
+   if (extents.y > extents[axis]) axis = 1;
+   if (extents.z > extents[axis]) axis = 2;
+
+   U32 half = count / 2;
+   U32* begin = order.address() + first;
+   std::nth_element(begin, begin + half, begin + count,
+      [this, axis](U32 a, U32 b)
+      {
+         return blockers[a]->getWorldBox().getCenter()[axis] < blockers[b]->getWorldBox().getCenter()[axis];
+      });
+
+   // nodes may reallocate while building children, don't hold a reference
+   S32 left = buildNode(first, half);
+   S32 right = buildNode(first + half, count - half);
+   nodes[index].left = left;
+   nodes[index].right = right;
+
+   return index;
+}
+
+void CameraBlocker::BlockerSet::rebuild()
+{
+   PROFILE_SCOPE(CameraBlocker_rebuildBVH);
+
+   dirty = false;
+   nodes.clear();
+
+   order.setSize(blockers.size());
+   for (U32 i = 0; i < blockers.size(); i++)
+      order[i] = i;
+
+   if (blockers.size())
+   {
+      nodes.reserve(blockers.size() * 2 / sBlockersPerLeaf + 1);
+      buildNode(0, blockers.size());
+   }
+}
+
+bool CameraBlocker::BlockerSet::castRay(const Point3F& start, const Point3F& end, RayInfo* info)
+{
+   if (dirty)
+      rebuild();
+
+   if (nodes.empty())
+      return false;
+
+   F32 bestT = F32_MAX;
+
+   // Small explicit stack, depth is log2(blockers / sBlockersPerLeaf)
+   S32 stack[64];
+   U32 stackSize = 0;
+   stack[stackSize++] = 0;
+
+   while (stackSize)
+   {
+      const BVHNode& node = nodes[stack[--stackSize]];
+
+      if (!node.box.collideLine(start, end))
+         continue;
+
+      if (node.left >= 0)
+      {
+         stack[stackSize++] = node.left;
+         stack[stackSize++] = node.right;
+         continue;
+      }
+
+      for (U32 i = node.first; i < node.first + node.count; i++)
+      {
+         CameraBlocker* blocker = blockers[order[i]];
+
+         // Same object space transform the container uses
+         Point3F xStart, xEnd;
+         blocker->getWorldTransform().mulP(start, &xStart);
+         blocker->getWorldTransform().mulP(end, &xEnd);
+         xStart.convolveInverse(blocker->getScale());
+         xEnd.convolveInverse(blocker->getScale());
+
+         RayInfo ri;
+         if (blocker->castRay(xStart, xEnd, &ri) && ri.t < bestT)
+         {
+            bestT = ri.t;
+            *info = ri;
+         }
+      }
+   }
+
+   if (bestT == F32_MAX)
+      return false;
+
+   // Hit point back in world space
+   info->point.interpolate(start, end, info->t);
+   return true;
+}
+
+bool CameraBlocker::castBlockerRay(bool server, const Point3F& start, const Point3F& end, RayInfo* info)
+{
+   PROFILE_SCOPE(CameraBlocker_castBlockerRay);
+
+   BlockerSet& set = server ? smServerBlockers : smClientBlockers;
+   return set.castRay(start, end, info);
+}
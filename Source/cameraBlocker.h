@@ -44,6 +44,42 @@ class CameraBlocker : public SceneObject
 
    static bool smRenderBlockers;
 
+   //--------------------------------------------------------------------------
+   // Blocker BVH
+   // Camera rays only care about blockers, so rather than registering them as
+   // static geometry (where every camera ray would walk the container bins
+   // to find them) each side keeps its own BVH of blocker world boxes. It's
+   // rebuilt lazily after a blocker is added, removed or moved.
+   //--------------------------------------------------------------------------
+   struct BVHNode
+   {
+      Box3F box;
+      S32 left;      // child node index, -1 for leaves
+      S32 right;     // child node index, -1 for leaves
+      U32 first;     // leaves: first entry in order
+      U32 count;     // leaves: number of entries in order
+   };
+
+   struct BlockerSet
+   {
+      Vector<CameraBlocker*> blockers;
+      Vector<U32> order;           // blocker indices, grouped by leaf
+      Vector<BVHNode> nodes;
+      bool dirty;
+
+      BlockerSet() : dirty(false) {}
+      void add(CameraBlocker* blocker);
+      void remove(CameraBlocker* blocker);
+      void rebuild();
+      S32 buildNode(U32 first, U32 count);
+      bool castRay(const Point3F& start, const Point3F& end, RayInfo* info);
+   };
+
+   static BlockerSet smServerBlockers;
+   static BlockerSet smClientBlockers;
+
+   BlockerSet& getBlockerSet() { return isServerObject() ? smServerBlockers : smClientBlockers; }
+
 public:
    CameraBlocker();
    virtual ~CameraBlocker();
@@ -81,6 +117,9 @@ public:
    bool castRay(const Point3F& start, const Point3F& end, RayInfo* info);
    bool castRayRendered(const Point3F& start, const Point3F& end, RayInfo* info);
 
+   // Cast a world space ray against the blockers only (server or client side)
+   static bool castBlockerRay(bool server, const Point3F& start, const Point3F& end, RayInfo* info);
+
    // This is the function that allows this object to submit itself for rendering
    void prepRenderImage(SceneRenderState* state);
 
@@ -0,0 +1,70 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "cameraGoalActivation.h"
+#include "AAKplayer.h"
+
+//----------------------------------------------------------------------------
+
+CameraGoalActivation::CameraGoalActivation()
+{
+	mGoalRefs = 0;
+}
+
+void CameraGoalActivation::updateGoalTicking(ShapeBase* goal, AAKPlayer* player)
+{
+	if (isGoalActive() && player)
+	{
+		player->addCameraDependent(goal, false);
+		return;
+	}
+
+	if (player)
+		player->removeCameraDependent(goal);
+
+	//a control object is ticked by its controller, not the process list
+	goal->setProcessTick(isGoalActive() && !goal->getControllingObject());
+}
+
+void CameraGoalActivation::acquire(ShapeBase* obj)
+{
+	CameraGoalActivation* goal = dynamic_cast<CameraGoalActivation*>(obj);
+	if (goal && goal->mGoalRefs++ == 0)
+		goal->onGoalActivate();
+}
+
+void CameraGoalActivation::release(ShapeBase* obj)
+{
+	CameraGoalActivation* goal = dynamic_cast<CameraGoalActivation*>(obj);
+	if (!goal || goal->mGoalRefs <= 0)
+		return;
+
+	if (--goal->mGoalRefs == 0)
+		goal->onGoalDeactivate();
+}
+
+bool CameraGoalActivation::isDormant(ShapeBase* obj)
+{
+	CameraGoalActivation* goal = dynamic_cast<CameraGoalActivation*>(obj);
+	return goal && !goal->isGoalActive();
+}
@@ -0,0 +1,69 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _CAMERAGOALACTIVATION_H_
+#define _CAMERAGOALACTIVATION_H_
+
+#ifndef _SHAPEBASE_H_
+#include "T3D/shapeBase.h"
+#endif
+
+class AAKPlayer;
+
+//----------------------------------------------------------------------------
+// CameraGoalActivation
+//
+// Reference counted activation shared by the camera goals. Every
+// CameraGoalFollower holds one reference on each goal in its blend stack, a
+// goal nobody references is dormant: it's taken off the tick (so it stops
+// moving and setting dirty bits) until a follower picks it up again, at which
+// point it warm starts from the current player state. Level designers can
+// place as many path / explicit cameras as they like without paying for the
+// idle ones.
+//----------------------------------------------------------------------------
+class CameraGoalActivation
+{
+	S32 mGoalRefs;		//followers using us
+
+protected:
+	CameraGoalActivation();
+	virtual ~CameraGoalActivation() {}
+
+	//first follower picked us up / last follower let go
+	virtual void onGoalActivate() = 0;
+	virtual void onGoalDeactivate() = 0;
+
+	//puts the goal where it's ticked while active (its player's camera stage,
+	//or the process list if it doesn't track a player), or nowhere if dormant
+	void updateGoalTicking(ShapeBase* goal, AAKPlayer* player);
+
+public:
+	bool isGoalActive() const { return mGoalRefs > 0; }
+
+	//these do nothing for shapes that aren't camera goals, any ShapeBase can
+	//be followed
+	static void acquire(ShapeBase* obj);
+	static void release(ShapeBase* obj);
+	static bool isDormant(ShapeBase* obj);
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include "math/mMath.h"
 #include "math/mathUtils.h"
 #include "core/stream/bitStream.h"
+#include "core/stream/memStream.h"
 #include "cameraGoalFollower.h"
 #include "T3D/gameBase/gameConnection.h"
 #include "math/mathIO.h"
@@ -32,15 +33,32 @@
 #include "console/consoleTypes.h"
 #include "T3D/fx/cameraFXMgr.h"
 #include "AAKUtils.h"
+#include "cameraGoalActivation.h"
 
 //----------------------------------------------------------------------------
 
 IMPLEMENT_CO_DATABLOCK_V1(CameraGoalFollowerData);
 
+typedef CameraGoalFollowerData::FilterType cameraGoalFollowerFilterEnum;
+DefineEnumType(cameraGoalFollowerFilterEnum);
+
+ImplementEnumType(cameraGoalFollowerFilterEnum, "Smoothing filter used by CameraGoalFollower.\n"
+   "@ingroup CameraGoalFollowerData\n\n")
+   { CameraGoalFollowerData::BoxFilter,         "Box",         "Average of the last X ticks." },
+   { CameraGoalFollowerData::ExponentialFilter, "Exponential", "Exponential moving average." },
+   { CameraGoalFollowerData::SpringFilter,      "Spring",      "Critically damped spring." },
+   { CameraGoalFollowerData::OneEuroFilter,     "OneEuro",     "Speed adaptive low-pass (One-Euro) filter." },
+   EndImplementEnumType;
+
 CameraGoalFollowerData::CameraGoalFollowerData()
 {
+	filterType = BoxFilter;
 	rotationHistorySize = 16;
 	positionHistorySize = 16;
+
+	oneEuroMinCutoff = 1.0f;
+	oneEuroBeta = 0.5f;
+	oneEuroDerivativeCutoff = 1.0f;
 }
 
 CameraGoalFollowerData::~CameraGoalFollowerData()
@@ -52,24 +70,207 @@ void CameraGoalFollowerData::initPersistFields()
 {
 	Parent::initPersistFields();
 
+	addField("filterType", TYPEID<cameraGoalFollowerFilterEnum>(), Offset(filterType, CameraGoalFollowerData),
+		"Smoothing filter applied to the goal position and rotation.");
 	addField("rotationHistorySize", TypeS32, Offset(rotationHistorySize, CameraGoalFollowerData));
 	addField("positionHistorySize", TypeS32, Offset(positionHistorySize, CameraGoalFollowerData));
+	addField("oneEuroMinCutoff", TypeF32, Offset(oneEuroMinCutoff, CameraGoalFollowerData));
+	addField("oneEuroBeta", TypeF32, Offset(oneEuroBeta, CameraGoalFollowerData));
+	addField("oneEuroDerivativeCutoff", TypeF32, Offset(oneEuroDerivativeCutoff, CameraGoalFollowerData));
 }
 
 void CameraGoalFollowerData::packData(BitStream* stream)
 {
 	Parent::packData(stream);
 
+	stream->writeInt(filterType, 2);
 	stream->write(rotationHistorySize);
 	stream->write(positionHistorySize);
+	stream->write(oneEuroMinCutoff);
+	stream->write(oneEuroBeta);
+	stream->write(oneEuroDerivativeCutoff);
 }
 
 void CameraGoalFollowerData::unpackData(BitStream* stream)
 {
 	Parent::unpackData(stream);
 
+	filterType = (FilterType)stream->readInt(2);
 	stream->read(&rotationHistorySize);
 	stream->read(&positionHistorySize);
+	stream->read(&oneEuroMinCutoff);
+	stream->read(&oneEuroBeta);
+	stream->read(&oneEuroDerivativeCutoff);
+}
+
+
+//----------------------------------------------------------------------------
+// SmoothChannel
+//----------------------------------------------------------------------------
+
+CameraGoalFollower::SmoothChannel::SmoothChannel()
+{
+	head = 0;
+	count = 0;
+	sum.zero();
+	value.zero();
+	velocity.zero();
+	primed = false;
+}
+
+void CameraGoalFollower::SmoothChannel::setCapacity(S32 size)
+{
+	//only (re)allocated when the datablock changes, never per tick
+	ring.setSize(getMax(size, 1));
+	reset();
+}
+
+void CameraGoalFollower::SmoothChannel::reset()
+{
+	head = 0;
+	count = 0;
+	sum.zero();
+	velocity.zero();
+	primed = false;
+}
+
+//one pole low-pass smoothing factor for a cutoff frequency (Hz)
+static inline F32 lowPassAlpha(F32 cutoff, F32 dt)
+{
+	F32 tau = 1.0f / (M_2PI_F * getMax(cutoff, 0.0001f));
+	return 1.0f / (1.0f + tau / dt);
+}
+
+Point3F CameraGoalFollower::SmoothChannel::filter(const Point3F& in, S32 historySize, const CameraGoalFollowerData* data)
+{
+	//first sample after a reset, snap to it
+	if(!primed)
+	{
+		primed = true;
+		value = in;
+		velocity.zero();
+		head = 0;
+		count = 0;
+		sum.zero();
+	}
+
+	//a history of 1 means no smoothing at all
+	historySize = getMax(historySize, 1);
+
+	switch(data->filterType)
+	{
+	case CameraGoalFollowerData::ExponentialFilter:
+		{
+			//an EMA with alpha = 2 / (N + 1) has the same average lag as an N tick box
+			F32 alpha = 2.0f / (F32)(historySize + 1);
+			value += (in - value) * alpha;
+		}
+		break;
+
+	case CameraGoalFollowerData::SpringFilter:
+		{
+			//critically damped spring (Game Programming Gems 4),
+			//smooth time matches the (N - 1) / 2 tick lag of an N tick box
+			F32 smoothTime = (F32)(historySize - 1) * 0.5f * TickSec;
+			if(smoothTime <= 0.0f)
+			{
+				value = in;
+				velocity.zero();
+				break;
+			}
+
+			F32 omega = 2.0f / smoothTime;
+			F32 x = omega * TickSec;
+			F32 decay = 1.0f / (1.0f + x + 0.48f * x * x + 0.235f * x * x * x);
+
+			Point3F change = value - in;
+			Point3F temp = (velocity + change * omega) * TickSec;
+			velocity = (velocity - temp * omega) * decay;
+			value = in + (change + temp) * decay;
+		}
+		break;
+
+	case CameraGoalFollowerData::OneEuroFilter:
+		{
+			//estimate speed, then lower the smoothing as speed rises
+			Point3F dx = (in - value) / TickSec;
+			velocity += (dx - velocity) * lowPassAlpha(data->oneEuroDerivativeCutoff, TickSec);
+
+			F32 cutoff = data->oneEuroMinCutoff + data->oneEuroBeta * velocity.len();
+			value += (in - value) * lowPassAlpha(cutoff, TickSec);
+		}
+		break;
+
+	default:
+		{
+			//box filter, the ring is normally sized to historySize already
+			//but guard against a smaller ring (datablock not yet applied)
+			U32 capacity = getMin((U32)historySize, (U32)ring.size());
+			if(capacity == 0)
+			{
+				value = in;
+				break;
+			}
+
+			//drop the oldest sample once the ring is full
+			while(count >= capacity)
+			{
+				U32 tail = (head + ring.size() - count) % ring.size();
+				sum -= Point3D(ring[tail].x, ring[tail].y, ring[tail].z);
+				count--;
+			}
+
+			ring[head] = in;
+			sum += Point3D(in.x, in.y, in.z);
+			head = (head + 1) % ring.size();
+			count++;
+
+			value.set(sum.x / count, sum.y / count, sum.z / count);
+		}
+		break;
+	}
+
+	return value;
+}
+
+void CameraGoalFollower::SmoothChannel::write(Stream& stream) const
+{
+	stream.write(primed);
+	mathWrite(stream, value);
+	mathWrite(stream, velocity);
+
+	//box samples, oldest first
+	stream.write(count);
+	for(U32 i = 0; i < count; i++)
+		mathWrite(stream, ring[(head + ring.size() - count + i) % ring.size()]);
+}
+
+void CameraGoalFollower::SmoothChannel::read(Stream& stream)
+{
+	reset();
+
+	stream.read(&primed);
+	mathRead(stream, &value);
+	mathRead(stream, &velocity);
+
+	//the ring keeps its current capacity, only the newest samples that
+	//fit are kept if the history size has shrunk since the save
+	U32 savedCount = 0;
+	stream.read(&savedCount);
+	for(U32 i = 0; i < savedCount; i++)
+	{
+		Point3F sample;
+		if(!mathRead(stream, &sample))
+			break;
+
+		if(ring.empty() || savedCount - i > ring.size())
+			continue;
+
+		ring[head] = sample;
+		sum += Point3D(sample.x, sample.y, sample.z);
+		head = (head + 1) % ring.size();
+		count++;
+	}
 }
 
 
@@ -95,10 +296,7 @@ CameraGoalFollower::CameraGoalFollower()
 
 	mPlayerObject = NULL;
 
-	mGoalObject = NULL;
-	mGoalObjectPrev = NULL;
-	mInterpolationT = 0.0f;
-	mInterpolationTime = 0.0f;
+	mBlendCount = 0;
 }
 
 CameraGoalFollower::~CameraGoalFollower()
@@ -137,6 +335,14 @@ void CameraGoalFollower::onEditorDisable()
 void CameraGoalFollower::onRemove()
 {
 	removeFromScene();
+
+	//let our goals go dormant
+	mBlendCount = 0;
+	updateActiveGoals();
+
+	if (mPlayerObject)
+		mPlayerObject->removeCameraDependent(this);
+
 	Parent::onRemove();
 }
 
@@ -146,6 +352,10 @@ bool CameraGoalFollower::onNewDataBlock( GameBaseData *dptr, bool reload )
 	if (!mDataBlock || !Parent::onNewDataBlock(dptr,reload))
 		return false;
 
+	//size the smoothing buffers once, processTick never allocates
+	mPosFilter.setCapacity(mDataBlock->positionHistorySize);
+	mRotFilter.setCapacity(mDataBlock->rotationHistorySize);
+
 	scriptOnNewDataBlock();
 	return true;
 }
@@ -157,7 +367,7 @@ void CameraGoalFollower::getCameraTransform(F32* pos, MatrixF* mat)
 
 F32 CameraGoalFollower::getCameraFov()
 {
-   ShapeBase * obj = dynamic_cast<ShapeBase*>(static_cast<SimObject*>(mGoalObject));
+   ShapeBase * obj = getGoalObject();
    if(obj && static_cast<ShapeBaseData*>(obj->getDataBlock())->observeThroughObject)
       return(obj->getCameraFov());
    else
@@ -173,120 +383,40 @@ void CameraGoalFollower::processTick(const Move* move)
 	delta.posVec = mPosition;
 
 	//check if we have a goal object
-	ShapeBase* goalObj = dynamic_cast<ShapeBase*>(static_cast<SimObject*>(mGoalObject));
-	if (goalObj)
+	if (mBlendCount > 0)
 	{
-		F32 pos; MatrixF goalTrans;
-		goalObj->getCameraTransform(&pos, &goalTrans);
+		//get the camera transform of every goal in the stack (once per goal)
+		evaluateBlendGoals();
 
-		Point3F goalPos;
-		goalTrans.getColumn(3, &goalPos);
-
-		VectorF goalForward;
-		goalTrans.getColumn(1, &goalForward);
-
-		//if we have a goalObjPrev and an interpolation time, perform the interpolation
-		ShapeBase* goalObjPrev = dynamic_cast<ShapeBase*>(static_cast<SimObject*>(mGoalObjectPrev));
-		if(goalObjPrev && mInterpolationTime > 0)
+		//advance each blend
+		for (U32 i = 0; i < mBlendCount; i++)
 		{
-			F32 posPrev; MatrixF goalTransPrev;
-			goalObjPrev->getCameraTransform(&posPrev, &goalTransPrev);
-
-			Point3F goalPosPrev;
-			goalTransPrev.getColumn(3, &goalPosPrev);
-
-			VectorF goalForwardPrev;
-			goalTransPrev.getColumn(1, &goalForwardPrev);
-
-			//interpolate between goalObjPrev and goalObj
-			mInterpolationT += (F32)TickMs / (F32)mInterpolationTime;
-			mInterpolationT = mClampF(mInterpolationT, 0, 1);
-			goalPos.interpolate(goalPosPrev, goalPos, mInterpolationT);
-
-			//override rotation during interpolation
-			if(!mPlayerObject)
-			{
-				//no player object, just interpolate between goalForwardPrev & goalForward
-				//this may result in the player going offscreen temporarily
-				goalForward.interpolate(goalForwardPrev, goalForward, mInterpolationT);
-			}
+			GoalBlend& entry = mBlendStack[i];
+			if (entry.time > 0)
+				entry.t = mClampF(entry.t + (F32)TickMs / (F32)entry.time, 0.0f, 1.0f);
 			else
-			{
-				//it's assumed that both goals provide a nice view of the player
-				//but sometimes linear interpolation between them like above
-				//causes the player to go off-screen. So (rotationally) we're
-				//going to interpolate to a view of the player, and then to the goal
-
-				Point3F playerPos = mPlayerObject->getNodePosition("Cam");
-				VectorF vec = playerPos - mPosition; vec.normalizeSafe();
-				MatrixF lookAt = MathUtils::createOrientFromDir(vec);
-
-				QuatF q1(goalTransPrev);
-				QuatF q2(lookAt);
-				QuatF q3(goalTrans);
-				QuatF final;
-
-				//first half of the transition
-				if(mInterpolationT < 0.5f)
-				{
-					//interpolate between prev goal and lookAt
-					F32 t = mInterpolationT * 2.0f;
-					final.interpolate(q1, q2, t);
-				}
-
-				//second half of the transition
-				else
-				{
-					//interpolate between lookat and new goal
-					F32 t =  (mInterpolationT - 0.5f) * 2.0f;
-					final.interpolate(q2, q3, t);
-				}
-
-				MatrixF tmp;
-				final.setMatrix(&tmp);
-				tmp.getColumn(1, &goalForward);
-			}
-
-			//have we finished this interpolation?
-			if(mInterpolationT == 1)
-				mGoalObjectPrev = NULL;
+				entry.t = 1.0f;
 		}
 
+		//goals hidden beneath a fully blended goal have no weight, drop them
+		retireBlendGoals();
+		updateActiveGoals();
+
+		Point3F goalPos;
+		VectorF goalForward;
+		blendGoals(goalPos, goalForward);
+
 		//-----------------------------------------------------------
 		// Position
 		//-----------------------------------------------------------
-		//add current goalPos to the history
-		mGoalPosHistory.push_back(goalPos);
-
-		//maintain history size
-		if(mGoalPosHistory.size() > mDataBlock->positionHistorySize)
-			mGoalPosHistory.pop_front();
-
-		//determine current position by averaging goal history
-		mPosition.zero();
-		for( U32 i = 0; i < mGoalPosHistory.size(); i++ )
-		{
-			mPosition += mGoalPosHistory[i];
-		}
-		mPosition /= mGoalPosHistory.size();
+		//smooth the goal position
+		mPosition = mPosFilter.filter(goalPos, mDataBlock->positionHistorySize, mDataBlock);
 
 		//-----------------------------------------------------------
 		// Rotation
 		//-----------------------------------------------------------
-		//add current goalForward to the history
-		mGoalRotHistory.push_back(goalForward);
-
-		//maintain history size
-		if(mGoalRotHistory.size() > mDataBlock->rotationHistorySize)
-			mGoalRotHistory.pop_front();
-
-		//determine current rotation by averaging goal history
-		goalForward.zero();
-		for( U32 i = 0; i < mGoalRotHistory.size(); i++ )
-		{
-			goalForward += mGoalRotHistory[i];
-		}
-		goalForward /= mGoalRotHistory.size();
+		//smooth the goal forward vector
+		goalForward = mRotFilter.filter(goalForward, mDataBlock->rotationHistorySize, mDataBlock);
 
 		//look in goalForward direction
 		F32 yaw, pitch;
@@ -330,11 +460,220 @@ void CameraGoalFollower::onDeleteNotify(SimObject *obj)
 	if (obj == (SimObject*)mPlayerObject)
 		mPlayerObject = NULL;
 
-	if (obj == (SimObject*)mGoalObject)
-		mGoalObject = NULL;
+	//goals are held by SimObjectPtr, a deleted goal simply freezes at its
+	//last transform until it blends out
+}
+
+//----------------------------------------------------------------------------
+// goal blend stack
+//----------------------------------------------------------------------------
+
+F32 CameraGoalFollower::getBlendWeight(const GoalBlend& entry)
+{
+	F32 t = entry.t;
+
+	switch (entry.ease)
+	{
+	case EaseInOut:
+		return t * t * (3.0f - 2.0f * t);
+	case EaseOut:
+		return 1.0f - (1.0f - t) * (1.0f - t);
+	default:
+		return t;
+	}
+}
+
+void CameraGoalFollower::evaluateBlendGoals()
+{
+	for (U32 i = 0; i < mBlendCount; i++)
+	{
+		ShapeBase* goalObj = mBlendStack[i].goal;
+
+		//frozen entry, keep the last transform
+		if (!goalObj)
+			continue;
+
+		//the same goal may appear more than once (A -> B -> A), only ask it once
+		bool found = false;
+		for (U32 j = 0; j < i; j++)
+		{
+			if ((ShapeBase*)mBlendStack[j].goal == goalObj)
+			{
+				mBlendStack[i].trans = mBlendStack[j].trans;
+				found = true;
+				break;
+			}
+		}
+
+		if (!found)
+		{
+			F32 pos;
+			goalObj->getCameraTransform(&pos, &mBlendStack[i].trans);
+		}
+	}
+}
+
+void CameraGoalFollower::retireBlendGoals()
+{
+	//find the newest goal that has fully blended in
+	S32 base = -1;
+	for (S32 i = mBlendCount - 1; i > 0; i--)
+	{
+		if (mBlendStack[i].t >= 1.0f)
+		{
+			base = i;
+			break;
+		}
+	}
+
+	if (base <= 0)
+		return;
+
+	//everything below it is invisible
+	for (U32 i = base; i < mBlendCount; i++)
+		mBlendStack[i - base] = mBlendStack[i];
+
+	for (U32 i = mBlendCount - base; i < mBlendCount; i++)
+		mBlendStack[i].goal = NULL;
 
-	if (obj == (SimObject*)mGoalObjectPrev)
-		mGoalObjectPrev = NULL;
+	mBlendCount -= base;
+}
+
+void CameraGoalFollower::mergeOldestBlendGoals()
+{
+	if (mBlendCount < 2)
+		return;
+
+	//collapse the two oldest entries into one frozen entry holding their
+	//current blend, so the camera doesn't jump when the stack is full
+	GoalBlend& a = mBlendStack[0];
+	GoalBlend& b = mBlendStack[1];
+	F32 w = getBlendWeight(b);
+
+	Point3F posA, posB;
+	a.trans.getColumn(3, &posA);
+	b.trans.getColumn(3, &posB);
+	posA.interpolate(posA, posB, w);
+
+	QuatF qA(a.trans), qB(b.trans), q;
+	q.interpolate(qA, qB, w);
+
+	MatrixF merged;
+	q.setMatrix(&merged);
+	merged.setColumn(3, posA);
+
+	a.goal = NULL;
+	a.trans = merged;
+	a.t = 1.0f;
+	a.time = 0;
+	a.ease = EaseLinear;
+
+	for (U32 i = 2; i < mBlendCount; i++)
+		mBlendStack[i - 1] = mBlendStack[i];
+
+	mBlendStack[mBlendCount - 1].goal = NULL;
+	mBlendCount--;
+}
+
+void CameraGoalFollower::updateActiveGoals()
+{
+	//release goals that have left the stack, a deleted goal just drops out
+	for (S32 i = mActiveGoals.size() - 1; i >= 0; i--)
+	{
+		ShapeBase* goal = mActiveGoals[i];
+
+		bool held = false;
+		for (U32 j = 0; j < mBlendCount && !held; j++)
+			held = goal && (ShapeBase*)mBlendStack[j].goal == goal;
+
+		if (!held)
+		{
+			if (goal)
+				CameraGoalActivation::release(goal);
+			mActiveGoals.erase(i);
+		}
+	}
+
+	//acquire goals that have entered it, once each
+	for (U32 i = 0; i < mBlendCount; i++)
+	{
+		ShapeBase* goal = mBlendStack[i].goal;
+		if (!goal)
+			continue;
+
+		bool held = false;
+		for (S32 j = 0; j < mActiveGoals.size() && !held; j++)
+			held = (ShapeBase*)mActiveGoals[j] == goal;
+
+		if (!held)
+		{
+			mActiveGoals.push_back(goal);
+			CameraGoalActivation::acquire(goal);
+		}
+	}
+}
+
+void CameraGoalFollower::blendGoals(Point3F& pos, VectorF& forward)
+{
+	mBlendStack[0].trans.getColumn(3, &pos);
+	mBlendStack[0].trans.getColumn(1, &forward);
+
+	if (mBlendCount == 1)
+		return;
+
+	//it's assumed that every goal provides a nice view of the player
+	//but sometimes linear interpolation between them causes the player
+	//to go off-screen. So (rotationally) each blend goes to a view of
+	//the player first, and then to the goal
+	QuatF rot(mBlendStack[0].trans);
+	QuatF lookAtRot;
+	if (mPlayerObject)
+	{
+		Point3F playerPos = mPlayerObject->getNodePosition("Cam");
+		VectorF vec = playerPos - mPosition; vec.normalizeSafe();
+		lookAtRot.set(MathUtils::createOrientFromDir(vec));
+	}
+
+	for (U32 i = 1; i < mBlendCount; i++)
+	{
+		const GoalBlend& entry = mBlendStack[i];
+		F32 w = getBlendWeight(entry);
+
+		Point3F goalPos;
+		entry.trans.getColumn(3, &goalPos);
+		pos.interpolate(pos, goalPos, w);
+
+		if (!mPlayerObject)
+		{
+			//no player object, just interpolate the forward vectors
+			//this may result in the player going offscreen temporarily
+			VectorF goalForward;
+			entry.trans.getColumn(1, &goalForward);
+			forward.interpolate(forward, goalForward, w);
+		}
+		else
+		{
+			QuatF goalRot(entry.trans);
+			QuatF final;
+
+			//first half of the transition, blend toward the lookAt
+			if (w < 0.5f)
+				final.interpolate(rot, lookAtRot, w * 2.0f);
+
+			//second half of the transition, blend from the lookAt to the goal
+			else
+				final.interpolate(lookAtRot, goalRot, (w - 0.5f) * 2.0f);
+
+			rot = final;
+		}
+	}
+
+	if (mPlayerObject)
+	{
+		MatrixF tmp;
+		rot.setMatrix(&tmp);
+		tmp.getColumn(1, &forward);
+	}
 }
 
 void CameraGoalFollower::interpolateTick(F32 dt)
@@ -386,14 +725,15 @@ U32 CameraGoalFollower::packUpdate(NetConnection *conn, U32 mask, BitStream *str
       mathWrite(*stream, mRot);
    }
 
-	if(!mGoalObject || !mPlayerObject)
+	ShapeBase* goalObj = getGoalObject();
+	if(!goalObj || !mPlayerObject)
 	{
 		stream->writeFlag(false);
 		stream->writeFlag(false);
 		return retMask;
 	}
 
-	S32 goalObjectId = conn->getGhostIndex(mGoalObject);
+	S32 goalObjectId = conn->getGhostIndex(goalObj);
 	S32 playerObjectId = conn->getGhostIndex(mPlayerObject);
 	
 	if(goalObjectId < 0 || playerObjectId < 0)
@@ -407,7 +747,9 @@ U32 CameraGoalFollower::packUpdate(NetConnection *conn, U32 mask, BitStream *str
 
 	if(stream->writeFlag(mask & UpdateMask))
 	{
-		stream->write(mInterpolationTime);
+		const GoalBlend& entry = mBlendStack[mBlendCount - 1];
+		stream->write(entry.time);
+		stream->writeInt(entry.ease, 2);
 		stream->writeRangedU32(U32(goalObjectId), 0, NetConnection::MaxGhostCount);
 		stream->writeRangedU32(U32(playerObjectId), 0, NetConnection::MaxGhostCount);
 	}
@@ -415,8 +757,8 @@ U32 CameraGoalFollower::packUpdate(NetConnection *conn, U32 mask, BitStream *str
 	if(stream->writeFlag(mask & ClearMask))
 	{		
 		//clear history
-		mGoalPosHistory.clear();
-		mGoalRotHistory.clear();
+		mPosFilter.reset();
+		mRotFilter.reset();
 	}
 
 	return retMask;
@@ -437,13 +779,14 @@ void CameraGoalFollower::unpackUpdate(NetConnection *conn, BitStream *stream)
 	{
 		S32 ms;
 		stream->read(&ms);
+		BlendEase ease = (BlendEase)stream->readInt(2);
 
 		//goal object
 		S32 goalObjectId = stream->readRangedU32(0, NetConnection::MaxGhostCount);
 		if(goalObjectId >= 0)
 		{
 			ShapeBase* goalObject = static_cast<ShapeBase*>(conn->resolveGhost(goalObjectId));
-			setGoalObject(goalObject, ms);
+			setGoalObject(goalObject, ms, ease);
 		}
 
 		//player object
@@ -459,8 +802,8 @@ void CameraGoalFollower::unpackUpdate(NetConnection *conn, BitStream *stream)
 	if( stream->readFlag() )
 	{
 		//clear history
-		mGoalPosHistory.clear();
-		mGoalRotHistory.clear();
+		mPosFilter.reset();
+		mRotFilter.reset();
 	}
 }
 
@@ -524,45 +867,56 @@ void CameraGoalFollower::setRenderTransform(const MatrixF& mat)
 
 //.............................................................
 
-bool CameraGoalFollower::setGoalObject(ShapeBase *obj, S32 ms)
+bool CameraGoalFollower::setGoalObject(ShapeBase *obj, S32 ms, BlendEase ease)
 {
 	if(!obj)
 		return false;
 
-	// reset current object if not null
-	if(bool(mGoalObject))
-		clearNotify(mGoalObject);
+	//already the current goal, let any running blend continue
+	if(obj == getGoalObject())
+		return true;
 
-	if(bool(mGoalObjectPrev))
-		clearNotify(mGoalObjectPrev);
+	//make room, the two oldest goals are merged into one frozen entry
+	if(mBlendCount == MaxBlendGoals)
+		mergeOldestBlendGoals();
 
-	//if going to a different goal, let's interpolate
-	if(obj != mGoalObject)
-		mGoalObjectPrev = mGoalObject;
+	//the new goal blends in over whatever the camera is doing now. Until
+	//it has been evaluated it holds our own transform, so a goal that is
+	//deleted before the next tick doesn't pull the camera to the origin
+	GoalBlend& entry = mBlendStack[mBlendCount++];
+	entry.goal = obj;
+	entry.trans = getTransform();
+	entry.time = ms;
+	entry.ease = ease;
+	entry.t = (mBlendCount == 1 || ms <= 0) ? 1.0f : 0.0f;
 
-	mGoalObject = obj;
-	mInterpolationTime = ms;
-	mInterpolationT = 0;
+	//wake the new goal (and let a merged one sleep)
+	updateActiveGoals();
 
-	if(bool(mGoalObject))
-		deleteNotify(mGoalObject);
+	if(isServerObject())
+		setMaskBits(UpdateMask);
 
-	if(bool(mGoalObjectPrev))
-		deleteNotify(mGoalObjectPrev);
+	return true;
+}
 
-   if(isServerObject())
-	   setMaskBits(UpdateMask);
+static CameraGoalFollower::BlendEase getBlendEaseFromString(const char* ease)
+{
+	if(!dStricmp(ease, "inOut"))
+		return CameraGoalFollower::EaseInOut;
+	if(!dStricmp(ease, "out"))
+		return CameraGoalFollower::EaseOut;
 
-	return true;
+	return CameraGoalFollower::EaseLinear;
 }
 
-DefineEngineMethod( CameraGoalFollower, setGoalObject, bool, (ShapeBase* goalObj, S32 ms),
-                                 (nullAsType<ShapeBase*>(), 2000), "(ShapeBase object, S32 trackTime)")
+DefineEngineMethod( CameraGoalFollower, setGoalObject, bool, (ShapeBase* goalObj, S32 ms, const char* ease),
+                                 (nullAsType<ShapeBase*>(), 2000, "linear"), "(ShapeBase object, S32 trackTime, string ease)\n"
+                                 "ease is one of linear, inOut or out")
 {
 	if(goalObj == nullptr)
 		return false;
 
-   object->setGoalObject(goalObj, ms);
+   object->setGoalObject(goalObj, ms, getBlendEaseFromString(ease));
 
 	return true;
 }
@@ -585,6 +939,7 @@ bool CameraGoalFollower::setPlayerObject(AAKPlayer *obj)
 	// reset current object if not null
 	if(bool(mPlayerObject))
 	{
+		mPlayerObject->removeCameraDependent(this);
 		clearProcessAfter();
 		clearNotify(mPlayerObject);
 	}
@@ -595,6 +950,7 @@ bool CameraGoalFollower::setPlayerObject(AAKPlayer *obj)
 	{
 		processAfter(mPlayerObject);
 		deleteNotify(mPlayerObject);
+		mPlayerObject->addCameraDependent(this, true);
 	}
 
 	setMaskBits(UpdateMask);
@@ -617,3 +973,80 @@ DefineEngineMethod(CameraGoalFollower, forceSetPosition, void, (Point3F pos, Poi
 {
    object->forceSetPosition(pos, rot);
 }
+
+//.............................................................
+
+static const U32 sCameraGoalFollowerSnapshotTag = 0x46474341;	//"ACGF"
+
+bool CameraGoalFollower::writeSnapshot(Stream& stream)
+{
+	AAKUtils::writeSnapshotHeader(stream, sCameraGoalFollowerSnapshotTag, SnapshotVersion);
+
+	mathWrite(stream, mPosition);
+	mathWrite(stream, mRot);
+
+	//smoothing history, goal objects aren't saved (script sets them again)
+	mPosFilter.write(stream);
+	mRotFilter.write(stream);
+
+	return stream.getStatus() == Stream::Ok;
+}
+
+bool CameraGoalFollower::readSnapshot(Stream& stream)
+{
+	U16 version;
+	if(!AAKUtils::readSnapshotHeader(stream, sCameraGoalFollowerSnapshotTag, SnapshotVersion, &version, "CameraGoalFollower"))
+		return false;
+
+	Point3F pos, rot;
+	mathRead(stream, &pos);
+	mathRead(stream, &rot);
+
+	//read the history into copies, a truncated snapshot leaves ours untouched
+	SmoothChannel posFilter = mPosFilter;
+	SmoothChannel rotFilter = mRotFilter;
+	posFilter.read(stream);
+	rotFilter.read(stream);
+
+	if(stream.getStatus() != Stream::Ok)
+	{
+		Con::errorf("CameraGoalFollower::readSnapshot - snapshot is truncated");
+		return false;
+	}
+
+	mPosFilter = posFilter;
+	mRotFilter = rotFilter;
+
+	forceSetPosition(pos, rot);
+	setMaskBits(ForceSetMask);
+	return true;
+}
+
+DefineEngineMethod(CameraGoalFollower, getSnapshot, const char*, (), , "()\n"
+   "Returns the camera state (including smoothing history) as a string for save games")
+{
+   U8 buffer[AAKUtils::MaxSnapshotSize];
+   MemStream stream(sizeof(buffer), buffer, false, true);
+   if(!object->writeSnapshot(stream))
+   {
+      Con::errorf("CameraGoalFollower::getSnapshot - snapshot too large");
+      return "";
+   }
+
+   return AAKUtils::snapshotToString(buffer, stream.getPosition());
+}
+
+DefineEngineMethod(CameraGoalFollower, setSnapshot, bool, (const char* snapshot), , "(string snapshot)\n"
+   "Restores the camera state from a string returned by getSnapshot()")
+{
+   U8 buffer[AAKUtils::MaxSnapshotSize];
+   U32 size = AAKUtils::snapshotFromString(snapshot, buffer, sizeof(buffer));
+   if(!size)
+   {
+      Con::errorf("CameraGoalFollower::setSnapshot - invalid snapshot string");
+      return false;
+   }
+
+   MemStream stream(size, buffer, true, false);
+   return object->readSnapshot(stream);
+}
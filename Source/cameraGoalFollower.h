@@ -40,8 +40,23 @@ private:
 	typedef ShapeBaseData Parent;
 
 public:
-	S32 rotationHistorySize;
-	S32 positionHistorySize;
+	//smoothing filter applied to the goal position/rotation
+	enum FilterType {
+		BoxFilter = 0,			//average of the last X ticks (original behaviour)
+		ExponentialFilter,		//exponential moving average, same lag as a box of X ticks
+		SpringFilter,			//critically damped spring, same lag as a box of X ticks
+		OneEuroFilter,			//adaptive low-pass, less lag during fast motion
+		NumFilterTypes
+	};
+
+	FilterType filterType;
+	S32 rotationHistorySize;	//box size in ticks (also sets the lag of exponential/spring)
+	S32 positionHistorySize;	//box size in ticks (also sets the lag of exponential/spring)
+
+	//One-Euro filter parameters
+	F32 oneEuroMinCutoff;		//cutoff frequency when still (Hz), lower = smoother
+	F32 oneEuroBeta;			//speed coefficient, higher = less lag when moving fast
+	F32 oneEuroDerivativeCutoff;	//cutoff frequency of the speed estimate (Hz)
 
 	DECLARE_CONOBJECT(CameraGoalFollowerData);
 	CameraGoalFollowerData();
@@ -55,16 +70,32 @@ public:
 // CameraGoalFollower
 //
 // This is the camera object (the entity through which the player usually views
-// the world). It's designed to provide linear interpolation between different
-// "goal" objects. A goal object can be any ShapeBase object. The
-// CameraGoalFollower will "follow" the goal, matching it's camera transform. If
+// the world). It's designed to provide interpolation between different
+// "goal" objects, several of which may be blending at once. A goal object can
+// be any ShapeBase object. The CameraGoalFollower will "follow" the goal,
+// matching it's camera transform. If
 // desired, it can also provide smoothing (easing) on it's position, rotation or
-// both. It does this by averaging the last X ticks. CameraGoalFollower is aware
-// of the player and sometimes (like during interpolation) overrides it's own
-// rotation (normally set by the goal object) to look at player.
+// both. By default it does this by averaging the last X ticks, but an
+// exponential, critically damped spring or One-Euro filter can be selected on
+// the datablock instead. CameraGoalFollower is aware of the player and
+// sometimes (like during interpolation) overrides it's own rotation (normally
+// set by the goal object) to look at player.
 //----------------------------------------------------------------------------
 class CameraGoalFollower: public ShapeBase
 {
+public:
+	//easing applied while a goal blends in
+	enum BlendEase {
+		EaseLinear = 0,
+		EaseInOut,
+		EaseOut,
+		NumBlendEases
+	};
+
+	enum {
+		MaxBlendGoals = 4		//goals blending at once, extra switches merge the oldest
+	};
+
 private:
 	typedef ShapeBase Parent;
 
@@ -88,19 +119,56 @@ private:
 	Point3F mRot;
 	Point3F mPosition;
 
-	Vector<Point3F> mGoalPosHistory;
-	Vector<Point3F> mGoalRotHistory;
+	//one smoothed channel (position or forward vector). The box filter keeps
+	//a fixed-capacity ring buffer with a running sum so each tick is O(1)
+	//and nothing is allocated once the datablock has been applied.
+	struct SmoothChannel {
+		Vector<Point3F> ring;	//box filter samples, sized to the history size
+		U32 head;				//next slot to write
+		U32 count;				//number of valid samples in the ring
+		Point3D sum;			//running sum of the valid samples
+
+		Point3F value;			//last filtered value
+		Point3F velocity;		//spring velocity / One-Euro derivative estimate
+		bool primed;			//has the channel seen a sample since the last reset?
+
+		SmoothChannel();
+		void setCapacity(S32 size);
+		void reset();
+		Point3F filter(const Point3F& in, S32 historySize, const CameraGoalFollowerData* data);
+		void write(Stream& stream) const;
+		void read(Stream& stream);
+	};
+	SmoothChannel mPosFilter;
+	SmoothChannel mRotFilter;
 
 	void setPosition(const Point3F& pos,const Point3F& viewRot);
 	void setRenderPosition(const Point3F& pos,const Point3F& viewRot);
 
 	AAKPlayer* mPlayerObject;	//the player object to track
 
-	SimObjectPtr<ShapeBase> mGoalObject;			//achieve this objects position and rotation
-	SimObjectPtr<ShapeBase> mGoalObjectPrev;		//previous goal object we are interpolating from
-	F32 mInterpolationT;						//current interpolation value (0-1)
-	S32 mInterpolationTime;						//total time of the interpolation (ms)
+	//a goal in the blend stack. Each entry blends in over the entries below
+	//it, so switching goals mid-transition continues smoothly from wherever
+	//the camera currently is instead of discarding the old blend.
+	struct GoalBlend {
+		SimObjectPtr<ShapeBase> goal;	//goal to follow, NULL if deleted or merged (frozen)
+		MatrixF trans;					//goal camera transform, kept if the goal goes away
+		F32 t;							//blend-in progress (0-1)
+		S32 time;						//total blend-in time (ms)
+		BlendEase ease;					//easing applied to t
+	};
+	GoalBlend mBlendStack[MaxBlendGoals];	//[0] is the oldest, [mBlendCount - 1] is the current goal
+	U32 mBlendCount;
+
+	//distinct goals in the blend stack we keep awake (see CameraGoalActivation)
+	Vector<SimObjectPtr<ShapeBase> > mActiveGoals;
 
+	static F32 getBlendWeight(const GoalBlend& entry);
+	void evaluateBlendGoals();
+	void retireBlendGoals();
+	void mergeOldestBlendGoals();
+	void blendGoals(Point3F& pos, VectorF& forward);
+	void updateActiveGoals();
 
 
 	void setPosition(const Point3F& pos,const Point3F& viewRot, MatrixF *mat);
@@ -131,13 +199,19 @@ public:
 
 	void onDeleteNotify(SimObject *obj);
 
-	bool setGoalObject(ShapeBase *obj, S32 ms = 2000);
-	ShapeBase * getGoalObject()      { return(mGoalObject); }
+	bool setGoalObject(ShapeBase *obj, S32 ms = 2000, BlendEase ease = EaseLinear);
+	ShapeBase * getGoalObject()      { return(mBlendCount ? (ShapeBase*)mBlendStack[mBlendCount - 1].goal : NULL); }
+	U32 getBlendCount()              { return(mBlendCount); }
 
 	bool setPlayerObject(AAKPlayer *obj);
 	AAKPlayer * getPlayerObject()      { return(mPlayerObject); }
 
    void forceSetPosition(const Point3F& pos, const Point3F& rot);
+
+	//save game snapshot (see AAKUtils::writeSnapshotHeader)
+	enum { SnapshotVersion = 1 };
+	bool writeSnapshot(Stream& stream);
+	bool readSnapshot(Stream& stream);
 };
 
 #endif
@@ -40,6 +40,9 @@ CameraGoalPath::CameraGoalPath()
 	mNetFlags.clear(Ghostable);
 	mTypeMask |= CameraObjectType;
 
+	//dormant until a follower uses us (see CameraGoalActivation)
+	setProcessTick(false);
+
 	mPosition.set(0.0f, 0.0f, 0.0f);
 	mRot.identity();
 
@@ -49,6 +52,7 @@ CameraGoalPath::CameraGoalPath()
 	mT = 0;
     mPlayerPathIndex = SimPath::Path::NoPathIndex;
 	mCameraPathIndex = SimPath::Path::NoPathIndex;
+	mCameraPathTable = NULL;
 	mPlayerObject = NULL;
 	mLookAtPlayer = false;
    mMaxRange = -1.0f;
@@ -61,6 +65,7 @@ CameraGoalPath::CameraGoalPath()
 
 CameraGoalPath::~CameraGoalPath()
 {
+	CameraPathTable::release(mCameraPathTable);
 }
 
 void CameraGoalPath::consoleInit()
@@ -73,8 +78,9 @@ void CameraGoalPath::consoleInit()
 
 F32 CameraGoalPath::getUpdatePriority(CameraScopeQuery *camInfo, U32 updateMask, S32 updateSkips)
 {
-	//we need a higher priority because
-	//cameraGoalFollower depends on us
+	//ghost us ahead of ordinary objects, cameraGoalFollower can't send
+	//us as its goal until we're ghosted (tick order is handled by the
+	//player's camera stage, not by this)
 	return 5.0f;
 }
 
@@ -88,7 +94,19 @@ void CameraGoalPath::processTick(const Move*)
 	mDelta.timeVec = mT;
 
 	Point3F playerPos = mPlayerObject->getNodePosition("Cam");
-	mT = mPathManager->getClosestTimeToPoint(mPlayerPathIndex, playerPos);
+
+	//the table search is local to the last result so it doesn't
+	//scale with the length of the path like getClosestTimeToPoint
+	if(mPlayerPathTable.update(mPathManager, mPlayerPathIndex))
+		mT = mPlayerPathTable.findClosestTime(playerPos);
+	else
+		mT = mPathManager->getClosestTimeToPoint(mPlayerPathIndex, playerPos);
+
+	//check the client's camera path for edits once per tick rather than
+	//every frame in interpolateMat
+	if(mCameraPathTable)
+		mCameraPathTable->update(gClientPathManager, mCameraPathIndex);
+
 	mPathManager->getPathPosition(mCameraPathIndex, mT, mPosition, mRot);
 
 #ifdef ENABLE_DEBUGDRAW
@@ -205,11 +223,28 @@ void CameraGoalPath::setRenderPosition(const Point3F& pos, const QuatF& rot)
 void CameraGoalPath::interpolateMat(F64 t, MatrixF* mat)
 {
 	Point3F pos; QuatF rot;
-	gClientPathManager->getPathPosition(mCameraPathIndex, t, pos, rot);
+
+	//use the shared sample table if it's ready, it's a lookup and a
+	//lerp instead of a spline evaluation every frame (processTick keeps
+	//it up to date, nothing here scales with the path length)
+	bool useTable = mCameraPathTable && mCameraPathTable->isBuilt();
+
 	if(mLookAtPlayer)
+	{
+		if(useTable)
+			mCameraPathTable->getPosition(t, pos);
+		else
+			gClientPathManager->getPathPosition(mCameraPathIndex, t, pos, rot);
 		mRot.setMatrix(mat);
+	}
 	else
+	{
+		if(useTable)
+			mCameraPathTable->getPosition(t, pos, rot);
+		else
+			gClientPathManager->getPathPosition(mCameraPathIndex, t, pos, rot);
 		rot.setMatrix(mat);
+	}
 	mat->setPosition(pos);
 }
 
@@ -288,6 +323,10 @@ void CameraGoalPath::unpackUpdate(NetConnection *con, BitStream *stream)
 	if (stream->readFlag())
 	{
 		stream->read(&mCameraPathIndex);
+
+		//share the sampled camera path with any other goal using it
+		CameraPathTable::release(mCameraPathTable);
+		mCameraPathTable = CameraPathTable::acquire(gClientPathManager, mCameraPathIndex);
 	}
 
 	//PlayerMask
@@ -311,6 +350,7 @@ bool CameraGoalPath::setPlayerPathObject(SimPath::Path *obj)
 		return false;
 
 	mPlayerPathIndex = obj->getPathIndex();
+	mPlayerPathTable.build(mPathManager, mPlayerPathIndex);
 	setMaskBits(PlayerPathMask);
 	return true;
 }
@@ -360,6 +400,7 @@ bool CameraGoalPath::setPlayerObject(AAKPlayer*obj)
 	// reset current object if not null
 	if(bool(mPlayerObject))
 	{
+		mPlayerObject->removeCameraDependent(this);
 		clearProcessAfter();
 		clearNotify(mPlayerObject);
 	}
@@ -372,9 +413,33 @@ bool CameraGoalPath::setPlayerObject(AAKPlayer*obj)
 		processAfter(mPlayerObject);
 		deleteNotify(mPlayerObject);
 	}
+
+	//the player's camera stage ticks us while we're active
+	updateGoalTicking(this, mPlayerObject);
 	return true;
 }
 
+void CameraGoalPath::onGoalActivate()
+{
+	//nothing to warm, mPlayerPathTable falls back to its chunk index
+	//when the player has moved a long way since the last query. The
+	//path may have been edited while we slept though
+	mPlayerPathTable.recheckWaypoints();
+	if(mCameraPathTable)
+		mCameraPathTable->recheckWaypoints();
+	updateGoalTicking(this, mPlayerObject);
+
+	//woken after the camera stage ran, don't leave the follower blending
+	//our dormant transform for a tick
+	if (mPlayerObject)
+		mPlayerObject->catchUpCameraGoal(this);
+}
+
+void CameraGoalPath::onGoalDeactivate()
+{
+	updateGoalTicking(this, mPlayerObject);
+}
+
 DefineEngineMethod( CameraGoalPath, setPlayerObject, bool, (AAKPlayer* playerObj), (nullAsType<AAKPlayer*>()), "(AAKPlayer object)")
 {
 	if(playerObj == nullptr)
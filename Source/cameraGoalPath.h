@@ -39,6 +39,14 @@
 #include "scene/pathManager.h"
 #endif
 
+#ifndef _CAMERAPATHTABLE_H_
+#include "./cameraPathTable.h"
+#endif
+
+#ifndef _CAMERAGOALACTIVATION_H_
+#include "./cameraGoalActivation.h"
+#endif
+
 //----------------------------------------------------------------------------
 // CameraGoalPath
 //
@@ -49,7 +57,7 @@
 // equal value of t. For rotation, the camera can automatically look at the
 // player, or use the rotation specified in the nodes of the camera path.
 //----------------------------------------------------------------------------
-class CameraGoalPath: public ShapeBase
+class CameraGoalPath: public ShapeBase, public CameraGoalActivation
 {
 private:
 	typedef ShapeBase Parent;
@@ -81,12 +89,18 @@ private:
 	F64 mT;					//current t value for this camera
 	U32 mPlayerPathIndex;	//the path used to read player position
 	U32 mCameraPathIndex;	//the path used to move this camera
+	CameraPathTable mPlayerPathTable;	//sampled player path for closest point queries
+	CameraPathTable* mCameraPathTable;	//shared sampled camera path (client only)
     AAKPlayer* mPlayerObject;	//the player object to track
 	bool mLookAtPlayer;
     F32 mMaxRange;
 	void interpolateMat(F64 t, MatrixF* mat);
 	//void setT(F32 t);
 
+protected:
+	void onGoalActivate();
+	void onGoalDeactivate();
+
 
 
 public:
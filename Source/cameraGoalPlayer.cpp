@@ -25,6 +25,7 @@
 #include "math/mMath.h"
 #include "math/mathUtils.h"
 #include "core/stream/bitStream.h"
+#include "core/stream/memStream.h"
 #include "cameraGoalPlayer.h"
 #include "T3D/gameBase/gameConnection.h"
 #include "math/mathIO.h"
@@ -33,6 +34,7 @@
 #include "T3D/player.h"
 #include "gfx/sim/debugDraw.h"
 #include "AAKUtils.h"
+#include "cameraBlocker.h"
 //----------------------------------------------------------------------------
 static bool sRenderCameraGoalRays = false;
 
@@ -121,6 +123,9 @@ CameraGoalPlayer::CameraGoalPlayer()
 	mNetFlags.clear(Ghostable);
 	mTypeMask |= CameraObjectType;
 
+	//dormant until a follower uses us (see CameraGoalActivation)
+	setProcessTick(false);
+
 	mDataBlock = 0;
 
 	delta.pos = Point3F(0.0f, 0.0f, 0.0f);
@@ -197,6 +202,10 @@ bool CameraGoalPlayer::onAdd()
 void CameraGoalPlayer::onRemove()
 {
 	removeFromScene();
+
+	if (mPlayerObject)
+		mPlayerObject->removeCameraDependent(this);
+
 	Parent::onRemove();
 }
 
@@ -256,7 +265,7 @@ void CameraGoalPlayer::getCameraTransform(F32* pos, MatrixF* mat)
 	RayInfo rInfo;  F32 tBest = F32_MAX;
 	for(U32 i = 0; i < 4; i++)
 	{
-		if(getContainer()->castRay(pts[i], pts[i] + forward, StaticObjectType, &rInfo) && rInfo.t > 0)
+		if(castCameraRay(pts[i], pts[i] + forward, &rInfo) && rInfo.t > 0)
 		{
 			//are we *not* ignoring this object?
 			if(!rInfo.object->cameraIgnores())
@@ -311,8 +320,8 @@ void CameraGoalPlayer::processTick(const Move* move)
    //check if we have a player object
    if (mPlayerObject)
    {
-      //grab current player position
-      mPlayerPos = mPlayerObject->getNodePosition("Cam") + mPlayerObject->getVelocity() * TickSec * 2.0f;
+      //grab current player position (the player ticks us after it's moved, see AAKPlayer::updateCameraStage)
+      mPlayerPos = mPlayerObject->getNodePosition("Cam");
 
       //grab current player forward vector
       mPlayerObject->getRenderTransform().getColumn(1, &mPlayerForward);
@@ -546,7 +555,7 @@ void CameraGoalPlayer::processTick(const Move* move)
 
                //determine if camera itself is inside geometry
                RayInfo rInfo;
-               bool camInside = getContainer()->castRay(finalPos, mPlayerPos, StaticObjectType, &rInfo) && rInfo.t == 0;
+               bool camInside = castCameraRay(finalPos, mPlayerPos, &rInfo) && rInfo.t == 0;
 
                //if camera is inside geometry, prefer to solve with pitch (I'm not
                //sure why this heuristic is "right" - but pitch seems to resolve
@@ -691,11 +700,11 @@ void CameraGoalPlayer::autoPitch()
 
 		//first cast from player to start (to ensure the "pit" is actually accessible)
 		RayInfo rInfo;
-		if(!getContainer()->castRay(mPlayerPos, mPlayerPos + vec, StaticObjectType, &rInfo))
+		if(!castCameraRay(mPlayerPos, mPlayerPos + vec, &rInfo))
 		{
 			//okay didn't hit anything, pit is accessible
 			//now cast down from start to end to find the ground
-			if(getContainer()->castRay(start, end, StaticObjectType, &rInfo))
+			if(castCameraRay(start, end, &rInfo))
 			{
             /* //debug lines
 				#ifdef ENABLE_DEBUGDRAW
@@ -826,6 +835,32 @@ void CameraGoalPlayer::updateOffset()
 	mOffCenterXCurrent += diff;
 }
 
+//-------------------------------------------------------------------
+// CameraGoalPlayer::castCameraRay
+//
+// Casts against static geometry and CameraBlockers. Blockers aren't in the
+// container as static objects, they're found through their own BVH, and only
+// up to the static hit (if any) since anything further away can't win.
+//-------------------------------------------------------------------
+bool CameraGoalPlayer::castCameraRay(const Point3F& start, const Point3F& end, RayInfo* info)
+{
+	bool hitStatic = getContainer()->castRay(start, end, StaticObjectType, info);
+
+	Point3F blockerEnd = hitStatic ? info->point : end;
+	RayInfo blockerInfo;
+	if(CameraBlocker::castBlockerRay(isServerObject(), start, blockerEnd, &blockerInfo))
+	{
+		//t is relative to the shortened ray
+		if(hitStatic)
+			blockerInfo.t *= info->t;
+
+		*info = blockerInfo;
+		return true;
+	}
+
+	return hitStatic;
+}
+
 //-------------------------------------------------------------------
 // CameraGoalPlayer::viewClear
 //
@@ -879,7 +914,7 @@ bool CameraGoalPlayer::viewClear(Point3F from)
       }
 		#endif
 
-		if(getContainer()->castRay(pts[i] + vec, pts[i], StaticObjectType, &rInfo))
+		if(castCameraRay(pts[i] + vec, pts[i], &rInfo))
 		{
 			//are we *not* ignoring this object?
 			if(!rInfo.object->cameraIgnores())
@@ -1157,7 +1192,7 @@ F32 CameraGoalPlayer::findAutoYaw()
 		end += dir;
 
 		RayInfo rinfo;
-		if(getContainer()->castRay(start, end, StaticObjectType, &rinfo))
+		if(castCameraRay(start, end, &rinfo))
 		{
 #ifdef ENABLE_DEBUGDRAW
          if (sRenderCameraGoalRays)
@@ -1424,6 +1459,7 @@ bool CameraGoalPlayer::setPlayerObject(AAKPlayer*obj)
 	// reset current object if not null
 	if(bool(mPlayerObject))
 	{
+		mPlayerObject->removeCameraDependent(this);
 		clearProcessAfter();
 		clearNotify(mPlayerObject);
 	}
@@ -1436,9 +1472,30 @@ bool CameraGoalPlayer::setPlayerObject(AAKPlayer*obj)
 		processAfter(mPlayerObject);
 		deleteNotify(mPlayerObject);
 	}
+
+	//the player's camera stage ticks us while we're active
+	updateGoalTicking(this, mPlayerObject);
 	return true;
 }
 
+void CameraGoalPlayer::onGoalActivate()
+{
+	//warm start: snap behind the player where it is now, rather than
+	//resuming from wherever we were when we went dormant
+	mFirstTickWithPlayer = true;
+	updateGoalTicking(this, mPlayerObject);
+
+	//woken after the camera stage ran, don't leave the follower blending
+	//our dormant transform for a tick
+	if (mPlayerObject)
+		mPlayerObject->catchUpCameraGoal(this);
+}
+
+void CameraGoalPlayer::onGoalDeactivate()
+{
+	updateGoalTicking(this, mPlayerObject);
+}
+
 DefineEngineMethod( CameraGoalPlayer, setPlayerObject, bool, (AAKPlayer* playerObj), (nullAsType<AAKPlayer*>()), "(AAKPlayer object)")
 {
 
@@ -1619,3 +1676,161 @@ DefineEngineMethod(CameraGoalPlayer, clearLookAt, void, (),, "()")
 {
    object->clearLookAt();
 }
+
+//===============================================================================
+
+static const U32 sCameraGoalPlayerSnapshotTag = 0x50474341;	//"ACGP"
+
+//-------------------------------------------------------------------
+// CameraGoalPlayer::writeSnapshot
+//
+// Writes the orbit state for save games. A lookAt object isn't saved
+// (object ids don't survive a reload), only a lookAt position is
+//-------------------------------------------------------------------
+bool CameraGoalPlayer::writeSnapshot(Stream& stream)
+{
+	AAKUtils::writeSnapshotHeader(stream, sCameraGoalPlayerSnapshotTag, SnapshotVersion);
+
+	mathWrite(stream, mPosition);
+	mathWrite(stream, mRot);
+
+	stream.write(mYaw);
+	stream.write(mForcedYawOn);
+	stream.write(mForcedYaw);
+	stream.write(mForcedYawSpeed);
+
+	stream.write(mPitch);
+	stream.write(mForcedPitchOn);
+	stream.write(mForcedPitch);
+	stream.write(mForcedPitchSpeed);
+
+	stream.write(mRadius);
+	stream.write(mRadiusSpeed);
+	stream.write(mForcedRadiusOn);
+	stream.write(mForcedRadius);
+	stream.write(mForcedRadiusSpeed);
+
+	stream.write(mOffCenterXTarget);
+	stream.write(mOffCenterXCurrent);
+	stream.write(mAutoYaw);
+
+	stream.write(mHasLookAt && mLookAtObject == nullptr);
+	mathWrite(stream, mLookAtPosition);
+
+	return stream.getStatus() == Stream::Ok;
+}
+
+bool CameraGoalPlayer::readSnapshot(Stream& stream)
+{
+	U16 version;
+	if (!AAKUtils::readSnapshotHeader(stream, sCameraGoalPlayerSnapshotTag, SnapshotVersion, &version, "CameraGoalPlayer"))
+		return false;
+
+	//read into locals, a truncated snapshot leaves the camera untouched
+	Point3F position, rot;
+	mathRead(stream, &position);
+	mathRead(stream, &rot);
+
+	F32 yaw, forcedYaw, forcedYawSpeed;
+	bool forcedYawOn;
+	stream.read(&yaw);
+	stream.read(&forcedYawOn);
+	stream.read(&forcedYaw);
+	stream.read(&forcedYawSpeed);
+
+	F32 pitch, forcedPitch, forcedPitchSpeed;
+	bool forcedPitchOn;
+	stream.read(&pitch);
+	stream.read(&forcedPitchOn);
+	stream.read(&forcedPitch);
+	stream.read(&forcedPitchSpeed);
+
+	F32 radius, radiusSpeed, forcedRadius, forcedRadiusSpeed;
+	bool forcedRadiusOn;
+	stream.read(&radius);
+	stream.read(&radiusSpeed);
+	stream.read(&forcedRadiusOn);
+	stream.read(&forcedRadius);
+	stream.read(&forcedRadiusSpeed);
+
+	F32 offCenterXTarget, offCenterXCurrent;
+	bool autoYaw;
+	stream.read(&offCenterXTarget);
+	stream.read(&offCenterXCurrent);
+	stream.read(&autoYaw);
+
+	bool hasLookAtPosition;
+	Point3F lookAtPosition;
+	stream.read(&hasLookAtPosition);
+	mathRead(stream, &lookAtPosition);
+
+	if (stream.getStatus() != Stream::Ok)
+	{
+		Con::errorf("CameraGoalPlayer::readSnapshot - snapshot is truncated");
+		return false;
+	}
+
+	mPosition = position;
+	mRot = rot;
+
+	mYaw = yaw;
+	mForcedYawOn = forcedYawOn;
+	mForcedYaw = forcedYaw;
+	mForcedYawSpeed = forcedYawSpeed;
+
+	mPitch = pitch;
+	mForcedPitchOn = forcedPitchOn;
+	mForcedPitch = forcedPitch;
+	mForcedPitchSpeed = forcedPitchSpeed;
+
+	mRadius = radius;
+	mRadiusSpeed = radiusSpeed;
+	mForcedRadiusOn = forcedRadiusOn;
+	mForcedRadius = forcedRadius;
+	mForcedRadiusSpeed = forcedRadiusSpeed;
+
+	mOffCenterXTarget = offCenterXTarget;
+	mOffCenterXCurrent = offCenterXCurrent;
+	mAutoYaw = autoYaw;
+
+	if (hasLookAtPosition)
+		setLookAtPosition(lookAtPosition);
+	else
+		clearLookAt();
+
+	//we're restoring a view, don't snap behind the player
+	mFirstTickWithPlayer = false;
+
+	setPosition(mPosition, mRot);
+	setMaskBits(ModeMask);
+	return true;
+}
+
+DefineEngineMethod(CameraGoalPlayer, getSnapshot, const char*, (),, "()\n"
+   "Returns the camera goal state as a string for save games")
+{
+   U8 buffer[AAKUtils::MaxSnapshotSize];
+   MemStream stream(sizeof(buffer), buffer, false, true);
+   if (!object->writeSnapshot(stream))
+   {
+      Con::errorf("CameraGoalPlayer::getSnapshot - snapshot too large");
+      return "";
+   }
+
+   return AAKUtils::snapshotToString(buffer, stream.getPosition());
+}
+
+DefineEngineMethod(CameraGoalPlayer, setSnapshot, bool, (const char* snapshot),, "(string snapshot)\n"
+   "Restores the camera goal state from a string returned by getSnapshot()")
+{
+   U8 buffer[AAKUtils::MaxSnapshotSize];
+   U32 size = AAKUtils::snapshotFromString(snapshot, buffer, sizeof(buffer));
+   if (!size)
+   {
+      Con::errorf("CameraGoalPlayer::setSnapshot - invalid snapshot string");
+      return false;
+   }
+
+   MemStream stream(size, buffer, true, false);
+   return object->readSnapshot(stream);
+}
@@ -31,6 +31,10 @@
 #include "./AAKplayer.h"
 #endif
 
+#ifndef _CAMERAGOALACTIVATION_H_
+#include "./cameraGoalActivation.h"
+#endif
+
 //----------------------------------------------------------------------------
 // CameraGoalPlayerData
 //----------------------------------------------------------------------------
@@ -74,7 +78,7 @@ public:
 // oddly shaped walls / towers. If desired, CameraGoalPlayer can also produce
 // a nice "rule of thirds" effect by keeping the player off-center.
 //----------------------------------------------------------------------------
-class CameraGoalPlayer: public ShapeBase
+class CameraGoalPlayer: public ShapeBase, public CameraGoalActivation
 {
 	typedef ShapeBase Parent;
 
@@ -142,6 +146,7 @@ class CameraGoalPlayer: public ShapeBase
 	void setRenderTransform(const MatrixF& mat);
 
 
+	bool castCameraRay(const Point3F& start, const Point3F& end, RayInfo* info);
 	bool viewClear(Point3F from);
 	bool findClearYaw(F32* yaw);
 	bool findClearPitch(F32* pitch);
@@ -157,7 +162,11 @@ class CameraGoalPlayer: public ShapeBase
 	void zoomToRadius(F32 radius, F32 speed = F32_MAX);
 
 	F32 findAutoYaw();
-	
+
+protected:
+	void onGoalActivate();
+	void onGoalDeactivate();
+
 public:
 	DECLARE_CONOBJECT(CameraGoalPlayer);
 
@@ -195,6 +204,11 @@ public:
    bool setLookAtObject(SceneObject* targetObj);
    void setLookAtPosition(const Point3F& targetPos);
    void clearLookAt();
+
+   //save game snapshot (see AAKUtils::writeSnapshotHeader)
+   enum { SnapshotVersion = 1 };
+   bool writeSnapshot(Stream& stream);
+   bool readSnapshot(Stream& stream);
 };
 
 #endif
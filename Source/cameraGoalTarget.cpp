@@ -16,6 +16,9 @@ CameraGoalTarget::CameraGoalTarget()
    mNetFlags.clear(Ghostable);
    mTypeMask |= CameraObjectType;
 
+   //dormant until a follower uses us (see CameraGoalActivation)
+   setProcessTick(false);
+
    mPosition.set(0.0f, 0.0f, 0.0f);
    mRot.set(0.0f, 0.0f, 0.0f);
 
@@ -42,8 +45,9 @@ CameraGoalTarget::~CameraGoalTarget()
 
 F32 CameraGoalTarget::getUpdatePriority(CameraScopeQuery* camInfo, U32 updateMask, S32 updateSkips)
 {
-   //we need a higher priority because
-   //cameraGoalFollower depends on us
+   //ghost us ahead of ordinary objects, cameraGoalFollower can't send
+   //us as its goal until we're ghosted (tick order is handled by the
+   //player's camera stage, not by this)
    return 5.0f;
 }
 
@@ -289,6 +293,7 @@ bool CameraGoalTarget::setPlayerObject(AAKPlayer* obj)
    // reset current object if not null
    if (bool(mPlayerObject))
    {
+      mPlayerObject->removeCameraDependent(this);
       clearProcessAfter();
       clearNotify(mPlayerObject);
    }
@@ -301,9 +306,25 @@ bool CameraGoalTarget::setPlayerObject(AAKPlayer* obj)
       processAfter(mPlayerObject);
       deleteNotify(mPlayerObject);
    }
+
+   //the player's camera stage ticks us while we're active
+   updateGoalTicking(this, mPlayerObject);
    return true;
 }
 
+void CameraGoalTarget::onGoalActivate()
+{
+   updateGoalTicking(this, mPlayerObject);
+
+   //warm start, we only depend on where the player & target are now
+   processTick(NULL);
+}
+
+void CameraGoalTarget::onGoalDeactivate()
+{
+   updateGoalTicking(this, mPlayerObject);
+}
+
 DefineEngineMethod(CameraGoalTarget, setPlayerObject, bool, (AAKPlayer* playerObj), (nullAsType<AAKPlayer*>()), "(AAKPlayer object)")
 {
    if (playerObj == nullptr)
@@ -12,13 +12,17 @@
 #include "scene/simPath.h"
 #endif
 
+#ifndef _CAMERAGOALACTIVATION_H_
+#include "./cameraGoalActivation.h"
+#endif
+
 //----------------------------------------------------------------------------
 // CameraGoalTarget
 //
 // This camera goal provides a view pointed towards a specific target, while 
 // keeping both it and the player in view
 //----------------------------------------------------------------------------
-class CameraGoalTarget : public ShapeBase
+class CameraGoalTarget : public ShapeBase, public CameraGoalActivation
 {
 private:
    typedef ShapeBase Parent;
@@ -65,6 +69,10 @@ private:
    F32 mDistanceOffset;
    F32 mTargetOffsetDistance;
 
+protected:
+   void onGoalActivate() override;
+   void onGoalDeactivate() override;
+
 public:
    DECLARE_CONOBJECT(CameraGoalTarget);
 
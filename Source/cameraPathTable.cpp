@@ -0,0 +1,419 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "cameraPathTable.h"
+#include "scene/simPath.h"
+#include "platform/profiler.h"
+
+extern bool gEditingMission;
+
+Vector<CameraPathTable::SharedTable> CameraPathTable::smSharedTables;
+
+CameraPathTable::CameraPathTable()
+{
+	mPathManager = NULL;
+	mPathIndex = SimPath::Path::NoPathIndex;
+	mTotalTime = 0;
+	mNumWaypoints = 0;
+	mWaypointHash = 0;
+	mRecheckWaypoints = false;
+	mStep = 0;
+
+	mLastSegment = -1;
+	mLastPoint.zero();
+	mJumpDistance = 0.0f;
+}
+
+void CameraPathTable::clear()
+{
+	mPathManager = NULL;
+	mPathIndex = SimPath::Path::NoPathIndex;
+	mTotalTime = 0;
+	mNumWaypoints = 0;
+	mWaypointHash = 0;
+
+	mSamples.clear();
+	mChunks.clear();
+	mStep = 0;
+
+	mLastSegment = -1;
+	mJumpDistance = 0.0f;
+}
+
+//-------------------------------------------------------------------
+// CameraPathTable::build
+//
+// sample the path and build the chunk bounds
+//-------------------------------------------------------------------
+void CameraPathTable::build(PathManager* pathManager, U32 pathIndex)
+{
+	PROFILE_SCOPE(CameraPathTable_build);
+
+	clear();
+
+	if(!pathManager || !pathManager->isValidPath(pathIndex))
+		return;
+
+	mPathManager = pathManager;
+	mPathIndex = pathIndex;
+	mTotalTime = pathManager->getPathTotalTime(pathIndex);
+	mNumWaypoints = pathManager->getPathNumWaypoints(pathIndex);
+	mWaypointHash = hashWaypoints(pathManager, pathIndex, mNumWaypoints);
+
+	if(mNumWaypoints < 2 || mTotalTime == 0)
+		return;
+
+	//sample at a fixed time step, dense enough for SamplesPerSegment
+	//samples between each pair of waypoints on average
+	U32 numSamples = (mNumWaypoints - 1) * SamplesPerSegment + 1;
+	mStep = (F64)mTotalTime / (F64)(numSamples - 1);
+
+	mSamples.setSize(numSamples);
+	for(U32 i = 0; i < numSamples; i++)
+	{
+		Sample& sample = mSamples[i];
+		sample.time = (i == numSamples - 1) ? (F64)mTotalTime : mStep * i;
+		pathManager->getPathPosition(pathIndex, sample.time, sample.pos, sample.rot);
+		sample.length = (i == 0) ? 0.0f : mSamples[i - 1].length + (sample.pos - mSamples[i - 1].pos).len();
+	}
+
+	//group segments into chunks, each chunk box includes the first sample
+	//of the next chunk so every segment is fully covered
+	U32 numSegments = numSamples - 1;
+	U32 numChunks = (numSegments + SamplesPerChunk - 1) / SamplesPerChunk;
+	mChunks.setSize(numChunks);
+	for(U32 c = 0; c < numChunks; c++)
+	{
+		U32 first = c * SamplesPerChunk;
+		U32 last = getMin(first + SamplesPerChunk, numSamples - 1);
+
+		Box3F& box = mChunks[c];
+		box.minExtents = box.maxExtents = mSamples[first].pos;
+		for(U32 i = first + 1; i <= last; i++)
+			box.extend(mSamples[i].pos);
+	}
+
+	//anything that moves further than a few local steps per query has jumped
+	mJumpDistance = (getTotalLength() / (F32)numSegments) * MaxLocalSteps;
+}
+
+bool CameraPathTable::isStale(PathManager* pathManager, U32 pathIndex) const
+{
+	if(pathManager != mPathManager || pathIndex != mPathIndex)
+		return true;
+
+	if(!pathManager || !pathManager->isValidPath(pathIndex))
+		return isBuilt();
+
+	//the path was edited
+	if(pathManager->getPathTotalTime(pathIndex) != mTotalTime
+		|| pathManager->getPathNumWaypoints(pathIndex) != mNumWaypoints)
+		return true;
+
+	//dragging a waypoint changes neither the time nor the count, but it
+	//only happens in the editor, so only pay for the hash there
+	if(!gEditingMission && !mRecheckWaypoints)
+		return false;
+
+	return hashWaypoints(pathManager, pathIndex, mNumWaypoints) != mWaypointHash;
+}
+
+//-------------------------------------------------------------------
+// CameraPathTable::hashWaypoints
+//
+// FNV-1a over the position & rotation at each waypoint time, one path
+// evaluation per waypoint
+//-------------------------------------------------------------------
+U32 CameraPathTable::hashWaypoints(PathManager* pathManager, U32 pathIndex, U32 numWaypoints)
+{
+	U32 hash = 2166136261u;
+	for(U32 i = 0; i < numWaypoints; i++)
+	{
+		F32 values[7];
+		Point3F pos;
+		QuatF rot;
+		pathManager->getPathPosition(pathIndex, pathManager->getWaypointTime(pathIndex, i), pos, rot);
+		values[0] = pos.x; values[1] = pos.y; values[2] = pos.z;
+		values[3] = rot.x; values[4] = rot.y; values[5] = rot.z; values[6] = rot.w;
+
+		const U8* bytes = (const U8*)values;
+		for(U32 j = 0; j < sizeof(values); j++)
+		{
+			hash ^= bytes[j];
+			hash *= 16777619u;
+		}
+	}
+
+	return hash;
+}
+
+//-------------------------------------------------------------------
+// CameraPathTable::update
+//
+// rebuild the table if the path has changed, returns true if the
+// table is usable
+//-------------------------------------------------------------------
+bool CameraPathTable::update(PathManager* pathManager, U32 pathIndex)
+{
+	if(isStale(pathManager, pathIndex))
+		build(pathManager, pathIndex);
+
+	//one more check after leaving the editor, for a drag on the last frame
+	mRecheckWaypoints = gEditingMission;
+
+	return isBuilt();
+}
+
+F32 CameraPathTable::getSegmentSqDistance(S32 seg, const Point3F& point, F32* u) const
+{
+	const Point3F& a = mSamples[seg].pos;
+	VectorF ab = mSamples[seg + 1].pos - a;
+
+	F32 lenSq = mDot(ab, ab);
+	*u = (lenSq > 0.0f) ? mClampF(mDot(point - a, ab) / lenSq, 0.0f, 1.0f) : 0.0f;
+
+	Point3F closest = a + ab * (*u);
+	return (point - closest).lenSquared();
+}
+
+//-------------------------------------------------------------------
+// CameraPathTable::findLocalSegment
+//
+// walk from start toward the nearest local minimum. converged is
+// false if MaxLocalSteps ran out before a minimum was found
+//-------------------------------------------------------------------
+S32 CameraPathTable::findLocalSegment(S32 start, const Point3F& point, bool* converged) const
+{
+	S32 numSegments = mSamples.size() - 1;
+	S32 seg = mClamp(start, 0, numSegments - 1);
+
+	F32 u;
+	F32 best = getSegmentSqDistance(seg, point, &u);
+
+	for(U32 step = 0; step < MaxLocalSteps; step++)
+	{
+		S32 next = seg;
+		F32 nextDist = best;
+
+		if(seg > 0)
+		{
+			F32 dist = getSegmentSqDistance(seg - 1, point, &u);
+			if(dist < nextDist) { next = seg - 1; nextDist = dist; }
+		}
+
+		if(seg < numSegments - 1)
+		{
+			F32 dist = getSegmentSqDistance(seg + 1, point, &u);
+			if(dist < nextDist) { next = seg + 1; nextDist = dist; }
+		}
+
+		if(next == seg)
+		{
+			*converged = true;
+			return seg;
+		}
+
+		seg = next;
+		best = nextDist;
+	}
+
+	*converged = false;
+	return seg;
+}
+
+//-------------------------------------------------------------------
+// CameraPathTable::findGlobalSegment
+//
+// closest segment over the whole path. Chunks whose box is further
+// away than the best segment so far are skipped, starting from hint
+// usually prunes almost all of them
+//-------------------------------------------------------------------
+S32 CameraPathTable::findGlobalSegment(const Point3F& point, S32 hint) const
+{
+	PROFILE_SCOPE(CameraPathTable_findGlobalSegment);
+
+	S32 numSegments = mSamples.size() - 1;
+	S32 bestSeg = mClamp(hint, 0, numSegments - 1);
+
+	F32 u;
+	F32 best = getSegmentSqDistance(bestSeg, point, &u);
+
+	for(U32 c = 0; c < mChunks.size(); c++)
+	{
+		if(mChunks[c].getSqDistanceToPoint(point) >= best)
+			continue;
+
+		S32 first = c * SamplesPerChunk;
+		S32 last = getMin(first + (S32)SamplesPerChunk, numSegments);
+		for(S32 seg = first; seg < last; seg++)
+		{
+			F32 dist = getSegmentSqDistance(seg, point, &u);
+			if(dist < best)
+			{
+				best = dist;
+				bestSeg = seg;
+			}
+		}
+	}
+
+	return bestSeg;
+}
+
+//-------------------------------------------------------------------
+// CameraPathTable::findClosestTime
+//
+// path time closest to point, replaces PathManager::getClosestTimeToPoint
+//-------------------------------------------------------------------
+F64 CameraPathTable::findClosestTime(const Point3F& point)
+{
+	if(!isBuilt())
+		return 0;
+
+	S32 seg = mLastSegment;
+	bool converged = false;
+
+	//coherent search from the last result
+	if(mLastSegment >= 0 && (point - mLastPoint).lenSquared() <= mJumpDistance * mJumpDistance)
+		seg = findLocalSegment(mLastSegment, point, &converged);
+
+	//first query, or the point jumped
+	if(!converged)
+		seg = findGlobalSegment(point, getMax(seg, 0));
+
+	mLastSegment = seg;
+	mLastPoint = point;
+
+	F32 u;
+	getSegmentSqDistance(seg, point, &u);
+	return mSamples[seg].time + (mSamples[seg + 1].time - mSamples[seg].time) * u;
+}
+
+F32 CameraPathTable::getLengthAtTime(F64 time) const
+{
+	if(!isBuilt())
+		return 0.0f;
+
+	if(time <= mSamples.first().time)
+		return 0.0f;
+	if(time >= mSamples.last().time)
+		return mSamples.last().length;
+
+	//binary search for the sample before time
+	S32 lo = 0, hi = mSamples.size() - 1;
+	while(hi - lo > 1)
+	{
+		S32 mid = (lo + hi) / 2;
+		if(mSamples[mid].time <= time)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	F32 u = (F32)((time - mSamples[lo].time) / (mSamples[hi].time - mSamples[lo].time));
+	return mLerp(mSamples[lo].length, mSamples[hi].length, u);
+}
+
+//-------------------------------------------------------------------
+// CameraPathTable::findSample
+//
+// sample at or before time, samples are evenly spaced so this is
+// just an index
+//-------------------------------------------------------------------
+S32 CameraPathTable::findSample(F64 time, F32* u) const
+{
+	S32 last = mSamples.size() - 2;
+	F64 index = getMax(time / mStep, 0.0);
+
+	S32 i = mClamp((S32)index, 0, last);
+	*u = mClampF((F32)(index - i), 0.0f, 1.0f);
+	return i;
+}
+
+void CameraPathTable::getPosition(F64 time, Point3F& pos, QuatF& rot) const
+{
+	if(!isBuilt())
+		return;
+
+	F32 u;
+	S32 i = findSample(time, &u);
+	pos.interpolate(mSamples[i].pos, mSamples[i + 1].pos, u);
+	rot.interpolate(mSamples[i].rot, mSamples[i + 1].rot, u);
+}
+
+void CameraPathTable::getPosition(F64 time, Point3F& pos) const
+{
+	if(!isBuilt())
+		return;
+
+	F32 u;
+	S32 i = findSample(time, &u);
+	pos.interpolate(mSamples[i].pos, mSamples[i + 1].pos, u);
+}
+
+//-------------------------------------------------------------------
+// CameraPathTable::acquire
+//
+// get the shared table for a path, it's built on first use and kept
+// up to date by update()
+//-------------------------------------------------------------------
+CameraPathTable* CameraPathTable::acquire(PathManager* pathManager, U32 pathIndex)
+{
+	for(U32 i = 0; i < smSharedTables.size(); i++)
+	{
+		SharedTable& shared = smSharedTables[i];
+		if(shared.pathManager == pathManager && shared.pathIndex == pathIndex)
+		{
+			shared.refCount++;
+			return shared.table;
+		}
+	}
+
+	SharedTable shared;
+	shared.pathManager = pathManager;
+	shared.pathIndex = pathIndex;
+	shared.refCount = 1;
+	shared.table = new CameraPathTable;
+	shared.table->build(pathManager, pathIndex);
+	smSharedTables.push_back(shared);
+
+	return shared.table;
+}
+
+void CameraPathTable::release(CameraPathTable* table)
+{
+	if(!table)
+		return;
+
+	for(U32 i = 0; i < smSharedTables.size(); i++)
+	{
+		SharedTable& shared = smSharedTables[i];
+		if(shared.table != table)
+			continue;
+
+		if(--shared.refCount == 0)
+		{
+			delete shared.table;
+			smSharedTables.erase_fast(i);
+		}
+		return;
+	}
+}
@@ -0,0 +1,133 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _CAMERAPATHTABLE_H_
+#define _CAMERAPATHTABLE_H_
+
+#ifndef _PATHMANAGER_H_
+#include "scene/pathManager.h"
+#endif
+
+#ifndef _MBOX_H_
+#include "math/mBox.h"
+#endif
+
+//----------------------------------------------------------------------------
+// CameraPathTable
+//
+// A sampled copy of a PathManager path. Samples are taken at a fixed density
+// per waypoint segment and store the path time, position and the arc length
+// up to that sample. Consecutive samples are grouped into chunks with a
+// bounding box each, giving a coarse index for closest-point queries.
+//
+// findClosestTime() is coherent: it starts from the result of the previous
+// query and walks to the nearest local minimum, so the usual per tick cost
+// doesn't depend on the length of the path. The chunk index is only used
+// when there's no previous result or the point has jumped.
+//
+// Staleness checks are O(1) in game. Dragging a waypoint changes neither
+// the path time nor the waypoint count, so the waypoint transforms are
+// only hashed while the mission editor is open (or on recheckWaypoints).
+//
+// Since samples are evenly spaced in time, getPosition() is a direct index
+// plus a lerp/slerp, which is what the client uses every render frame.
+// Tables for client camera paths are shared between every CameraGoalPath
+// using the same path, see acquire() / release().
+//----------------------------------------------------------------------------
+class CameraPathTable
+{
+public:
+	enum {
+		SamplesPerSegment	= 16,	//samples taken between each pair of waypoints
+		SamplesPerChunk		= 16,	//samples grouped under one bounding box
+		MaxLocalSteps		= 8		//local search steps before falling back to the index
+	};
+
+	struct Sample {
+		F64 time;		//path time (ms)
+		Point3F pos;	//path position at time
+		QuatF rot;		//path rotation at time
+		F32 length;		//arc length from the start of the path to this sample
+	};
+
+private:
+	PathManager* mPathManager;
+	U32 mPathIndex;
+	U32 mTotalTime;		//path total time when built, used to spot edited paths
+	U32 mNumWaypoints;	//path waypoint count when built, used to spot edited paths
+	U32 mWaypointHash;	//hash of the waypoint transforms when built, catches dragged waypoints
+	bool mRecheckWaypoints;	//compare mWaypointHash on the next update even outside the editor
+
+	Vector<Sample> mSamples;
+	Vector<Box3F> mChunks;
+	F64 mStep;			//time between samples (ms)
+
+	//coherence state for findClosestTime
+	S32 mLastSegment;	//segment (mSamples[i] -> mSamples[i + 1]) of the last result
+	Point3F mLastPoint;	//query point of the last result
+	F32 mJumpDistance;	//moves larger than this skip the local search
+
+	F32 getSegmentSqDistance(S32 seg, const Point3F& point, F32* u) const;
+	S32 findLocalSegment(S32 start, const Point3F& point, bool* converged) const;
+	S32 findGlobalSegment(const Point3F& point, S32 hint) const;
+	static U32 hashWaypoints(PathManager* pathManager, U32 pathIndex, U32 numWaypoints);
+
+public:
+	CameraPathTable();
+
+	void build(PathManager* pathManager, U32 pathIndex);
+	bool update(PathManager* pathManager, U32 pathIndex);
+	void clear();
+	bool isBuilt() const { return mSamples.size() > 1; }
+	bool isStale(PathManager* pathManager, U32 pathIndex) const;
+
+	//waypoint transforms are compared while editing and once after, call
+	//this if the table sat unused for a while (the path may have been
+	//edited in the meantime)
+	void recheckWaypoints() { mRecheckWaypoints = true; }
+
+	F64 findClosestTime(const Point3F& point);
+	F32 getTotalLength() const { return isBuilt() ? mSamples.last().length : 0.0f; }
+	F32 getLengthAtTime(F64 time) const;
+
+	void getPosition(F64 time, Point3F& pos, QuatF& rot) const;
+	void getPosition(F64 time, Point3F& pos) const;
+
+	const Vector<Sample>& getSamples() const { return mSamples; }
+
+	//shared tables, reference counted per path manager / path
+	static CameraPathTable* acquire(PathManager* pathManager, U32 pathIndex);
+	static void release(CameraPathTable* table);
+
+private:
+	struct SharedTable {
+		PathManager* pathManager;
+		U32 pathIndex;
+		U32 refCount;
+		CameraPathTable* table;
+	};
+	static Vector<SharedTable> smSharedTables;
+
+	S32 findSample(F64 time, F32* u) const;
+};
+
+#endif
@@ -0,0 +1,336 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "climbZone.h"
+
+#include "math/mathIO.h"
+#include "scene/sceneRenderState.h"
+#include "core/stream/bitStream.h"
+#include "gfx/gfxTransformSaver.h"
+#include "renderInstance/renderPassManager.h"
+#include "gfx/gfxDrawUtil.h"
+#include "platform/profiler.h"
+
+#include <algorithm>
+
+IMPLEMENT_CO_NETOBJECT_V1(ClimbZone);
+
+ConsoleDocClass(ClimbZone,
+   "@brief A box volume inside which players may climb.\n\n"
+   "Works like a ClimbTrigger, without the trigger callbacks.\n");
+
+extern bool gEditingMission;
+bool ClimbZone::smRenderZones = false;
+
+ClimbZone::ZoneSet ClimbZone::smServerZones;
+ClimbZone::ZoneSet ClimbZone::smClientZones;
+
+// Size of a zone hash cell (world units)
+static const F32 sZoneCellSize = 16.0f;
+
+// Distinct zones countZones keeps track of per query
+static const U32 sMaxZonesPerQuery = 32;
+
+//-----------------------------------------------------------------------------
+// Object setup and teardown
+//-----------------------------------------------------------------------------
+ClimbZone::ClimbZone()
+{
+   mNetFlags.set(Ghostable | ScopeAlways);
+
+   // Players find zones through the zone hash (see countZones), keep
+   // them out of collision and camera queries
+   mTypeMask |= MarkerObjectType;
+
+   mCameraIgnores = true;
+}
+
+ClimbZone::~ClimbZone()
+{
+}
+
+void ClimbZone::consoleInit()
+{
+   Con::addVariable("$ClimbZone::renderZones", TypeBool, &smRenderZones,
+      "@brief Forces all ClimbZones to render.\n\n"
+      "Used by the Tools and debug render modes.\n"
+      "@ingroup gameObjects");
+}
+
+void ClimbZone::initPersistFields()
+{
+   // SceneObject already handles exposing the transform
+   Parent::initPersistFields();
+}
+
+bool ClimbZone::onAdd()
+{
+   if (!Parent::onAdd())
+      return false;
+
+   // Set up a 1x1x1 bounding box, scale sizes it
+   mObjBox.set(Point3F(-0.5f, -0.5f, -0.5f),
+      Point3F(0.5f, 0.5f, 0.5f));
+
+   resetWorldBox();
+
+   addToScene();
+
+   getZoneSet().add(this);
+
+   return true;
+}
+
+void ClimbZone::onRemove()
+{
+   getZoneSet().remove(this);
+
+   removeFromScene();
+
+   Parent::onRemove();
+}
+
+void ClimbZone::setTransform(const MatrixF& mat)
+{
+   Parent::setTransform(mat);
+
+   setMaskBits(TransformMask);
+
+   // Our world box moved, rehash before the next query
+   if (isProperlyAdded())
+      getZoneSet().dirty = true;
+}
+
+U32 ClimbZone::packUpdate(NetConnection* conn, U32 mask, BitStream* stream)
+{
+   U32 retMask = Parent::packUpdate(conn, mask, stream);
+
+   if (stream->writeFlag(mask & TransformMask))
+   {
+      mathWrite(*stream, getTransform());
+      mathWrite(*stream, getScale());
+   }
+
+   return retMask;
+}
+
+void ClimbZone::unpackUpdate(NetConnection* conn, BitStream* stream)
+{
+   Parent::unpackUpdate(conn, stream);
+
+   if (stream->readFlag())  // TransformMask
+   {
+      mathRead(*stream, &mObjToWorld);
+      mathRead(*stream, &mObjScale);
+
+      setTransform(mObjToWorld);
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Queries
+//-----------------------------------------------------------------------------
+bool ClimbZone::overlaps(const Box3F& worldBox) const
+{
+   if (!getWorldBox().isOverlapped(worldBox))
+      return false;
+
+   // Into object space, the zone may be rotated
+   Box3F box(worldBox);
+   getWorldTransform().mul(box);
+   box.minExtents.convolveInverse(getScale());
+   box.maxExtents.convolveInverse(getScale());
+
+   return mObjBox.isOverlapped(box);
+}
+
+U32 ClimbZone::countZones(bool server, const Box3F& worldBox)
+{
+   PROFILE_SCOPE(ClimbZone_countZones);
+
+   ZoneSet& set = server ? smServerZones : smClientZones;
+   return set.countZones(worldBox);
+}
+
+//-----------------------------------------------------------------------------
+// Zone hash
+//-----------------------------------------------------------------------------
+U32 ClimbZone::getCellKey(S32 x, S32 y)
+{
+   return ((U32)(x & 0xffff) << 16) | (U32)(y & 0xffff);
+}
+
+void ClimbZone::ZoneSet::add(ClimbZone* zone)
+{
+   zones.push_back(zone);
+   dirty = true;
+}
+
+void ClimbZone::ZoneSet::remove(ClimbZone* zone)
+{
+   for (U32 i = 0; i < zones.size(); i++)
+   {
+      if (zones[i] == zone)
+      {
+         zones.erase_fast(i);
+         dirty = true;
+         return;
+      }
+   }
+}
+
+void ClimbZone::ZoneSet::rebuild()
+{
+   PROFILE_SCOPE(ClimbZone_rebuildHash);
+
+   dirty = false;
+   cells.clear();
+   bigZones.clear();
+
+   for (U32 i = 0; i < zones.size(); i++)
+   {
+      const Box3F& box = zones[i]->getWorldBox();
+      S32 x0 = (S32)mFloor(box.minExtents.x / sZoneCellSize);
+      S32 y0 = (S32)mFloor(box.minExtents.y / sZoneCellSize);
+      S32 x1 = (S32)mFloor(box.maxExtents.x / sZoneCellSize);
+      S32 y1 = (S32)mFloor(box.maxExtents.y / sZoneCellSize);
+
+      if ((x1 - x0 + 1) * (y1 - y0 + 1) > MaxCellsPerZone)
+      {
+         bigZones.push_back(i);
+         continue;
+      }
+
+      for (S32 x = x0; x <= x1; x++)
+      {
+         for (S32 y = y0; y <= y1; y++)
+         {
+            CellEntry entry;
+            entry.cell = getCellKey(x, y);
+            entry.zone = i;
+            cells.push_back(entry);
+         }
+      }
+   }
+
+   std::sort(cells.begin(), cells.end(),
+      [](const CellEntry& a, const CellEntry& b) { return a.cell < b.cell; });
+}
+
+U32 ClimbZone::ZoneSet::countZones(const Box3F& box)
+{
+   if (dirty)
+      rebuild();
+
+   if (zones.empty())
+      return 0;
+
+   // A box can see the same zone through several cells, only count it once
+   U32 seen[sMaxZonesPerQuery];
+   U32 numSeen = 0;
+   U32 count = 0;
+
+   S32 x0 = (S32)mFloor(box.minExtents.x / sZoneCellSize);
+   S32 y0 = (S32)mFloor(box.minExtents.y / sZoneCellSize);
+   S32 x1 = (S32)mFloor(box.maxExtents.x / sZoneCellSize);
+   S32 y1 = (S32)mFloor(box.maxExtents.y / sZoneCellSize);
+
+   for (S32 x = x0; x <= x1; x++)
+   {
+      for (S32 y = y0; y <= y1; y++)
+      {
+         CellEntry key;
+         key.cell = getCellKey(x, y);
+         key.zone = 0;
+
+         const CellEntry* entry = std::lower_bound(cells.begin(), cells.end(), key,
+            [](const CellEntry& a, const CellEntry& b) { return a.cell < b.cell; });
+
+         for (; entry != cells.end() && entry->cell == key.cell; entry++)
+         {
+            bool dup = false;
+            for (U32 i = 0; i < numSeen && !dup; i++)
+               dup = seen[i] == entry->zone;
+            if (dup || !zones[entry->zone]->overlaps(box))
+               continue;
+
+            // Past sMaxZonesPerQuery we might count a zone twice, callers
+            // only care whether they're in any zone at all
+            if (numSeen < sMaxZonesPerQuery)
+               seen[numSeen++] = entry->zone;
+            count++;
+         }
+      }
+   }
+
+   for (U32 i = 0; i < bigZones.size(); i++)
+   {
+      if (zones[bigZones[i]]->overlaps(box))
+         count++;
+   }
+
+   return count;
+}
+
+//-----------------------------------------------------------------------------
+// Rendering
+//-----------------------------------------------------------------------------
+void ClimbZone::prepRenderImage(SceneRenderState* state)
+{
+   if (!gEditingMission || (!ClimbZone::smRenderZones && !isSelected()))
+      return;
+
+   ObjectRenderInst* ri = state->getRenderPass()->allocInst<ObjectRenderInst>();
+   ri->renderDelegate.bind(this, &ClimbZone::render);
+   ri->type = RenderPassManager::RIT_Editor;
+   ri->translucentSort = true;
+   ri->defaultKey = 1;
+   state->getRenderPass()->addInst(ri);
+}
+
+void ClimbZone::render(ObjectRenderInst* ri, SceneRenderState* state, BaseMatInstance* overrideMat)
+{
+   if (overrideMat)
+      return;
+
+   GFXStateBlockDesc desc;
+   desc.setZReadWrite(true, false);
+   desc.setBlend(true);
+   desc.setCullMode(GFXCullNone);
+
+   GFXTransformSaver saver;
+
+   MatrixF mat = getRenderTransform();
+   mat.scale(getScale());
+
+   GFX->multWorld(mat);
+
+   GFXDrawUtil* drawer = GFX->getDrawUtil();
+
+   Box3F bounds = getObjBox();
+
+   drawer->drawCube(desc, bounds, ColorI(150, 100, 0, 45));
+
+   // Render wireframe.
+   desc.setFillModeWireframe();
+   drawer->drawCube(desc, bounds, ColorI::BLACK);
+}
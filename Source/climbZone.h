@@ -0,0 +1,120 @@
+//-----------------------------------------------------------------------------
+// Copyright (C) 2008-2013 Ubiq Visuals, Inc. (http://www.ubiqvisuals.com/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _CLIMBZONE_H_
+#define _CLIMBZONE_H_
+
+#ifndef _SCENEOBJECT_H_
+#include "scene/sceneObject.h"
+#endif
+
+class BaseMatInstance;
+
+//-----------------------------------------------------------------------------
+// ClimbZone
+//
+// A box volume that lets players climb any suitable surface inside it. It
+// does the same job as a ClimbTrigger, but players look zones up directly
+// (see countZones) instead of waiting on trigger script callbacks to bump
+// their climbTriggerCount, so levels can have hundreds of them.
+//
+// Like CameraBlocker, zones aren't in the container's way: each side keeps
+// a 2D spatial hash of zone world boxes, rebuilt lazily after a zone is
+// added, removed or moved.
+//-----------------------------------------------------------------------------
+class ClimbZone : public SceneObject
+{
+   typedef SceneObject Parent;
+
+   enum MaskBits
+   {
+      TransformMask = Parent::NextFreeMask << 0,
+      NextFreeMask = Parent::NextFreeMask << 1
+   };
+
+   static bool smRenderZones;
+
+   //--------------------------------------------------------------------------
+   // Zone hash
+   // Zones are bucketed by the square grid cells their world box covers.
+   // Cells are kept as one sorted array of (cell, zone) pairs, so a lookup
+   // is a binary search and the zones for a cell sit next to each other.
+   // Zones covering more than MaxCellsPerZone cells go in a list that is
+   // always tested instead.
+   //--------------------------------------------------------------------------
+   struct CellEntry
+   {
+      U32 cell;
+      U32 zone;      // index into zones
+   };
+
+   struct ZoneSet
+   {
+      enum { MaxCellsPerZone = 64 };
+
+      Vector<ClimbZone*> zones;
+      Vector<CellEntry> cells;      // sorted by cell
+      Vector<U32> bigZones;
+      bool dirty;
+
+      ZoneSet() : dirty(false) {}
+      void add(ClimbZone* zone);
+      void remove(ClimbZone* zone);
+      void rebuild();
+      U32 countZones(const Box3F& box);
+   };
+
+   static ZoneSet smServerZones;
+   static ZoneSet smClientZones;
+
+   ZoneSet& getZoneSet() { return isServerObject() ? smServerZones : smClientZones; }
+
+   static U32 getCellKey(S32 x, S32 y);
+
+public:
+   ClimbZone();
+   virtual ~ClimbZone();
+
+   DECLARE_CONOBJECT(ClimbZone);
+
+   static void initPersistFields();
+   static void consoleInit();
+
+   bool onAdd();
+   void onRemove();
+
+   void setTransform(const MatrixF& mat);
+
+   U32 packUpdate(NetConnection* conn, U32 mask, BitStream* stream);
+   void unpackUpdate(NetConnection* conn, BitStream* stream);
+
+   /// Does this zone overlap the given world box?
+   bool overlaps(const Box3F& worldBox) const;
+
+   /// Number of zones (server or client side) overlapping a world box
+   static U32 countZones(bool server, const Box3F& worldBox);
+
+   void prepRenderImage(SceneRenderState* state);
+   void render(ObjectRenderInst* ri, SceneRenderState* state, BaseMatInstance* overrideMat);
+};
+
+#endif